@@ -0,0 +1,667 @@
+// Performance regression runner.
+//
+// Runs micro benchmarks of the request hot paths (sampler, parsers, JSON,
+// compression, embedding search, generation) and an HTTP load test against
+// the real server linked with the stub llama backend, then compares p50/p99
+// latency and allocations per operation with a baseline JSON. Exits non-zero
+// when any metric regresses past its threshold, so it can gate a deploy.
+#include "http_server.h"
+#include "token_sampler.h"
+#include "stop_matcher.h"
+#include "near_duplicate_index.h"
+#include "template_registry.h"
+#include "embedding_index.h"
+#include "response_compressor.h"
+#include "simd_kernels.h"
+#include <jsoncpp/json/json.h>
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <map>
+#include <new>
+#include <random>
+#include <thread>
+
+namespace {
+
+std::atomic<uint64_t> g_allocations{0};
+
+using Clock = std::chrono::steady_clock;
+
+struct BenchmarkResult {
+    double p50Ns = 0.0;
+    double p99Ns = 0.0;
+    double allocsPerOp = 0.0;
+    uint64_t ops = 0;
+};
+
+struct Thresholds {
+    double p50 = 0.15;   // Allowed relative growth
+    double p99 = 0.35;
+    double allocs = 0.05;
+};
+
+// Makes a result observable so link-time optimization cannot drop the
+// benchmarked call as dead code
+template <typename T>
+void keep(const T& value) {
+    asm volatile("" : : "r"(&value) : "memory");
+}
+
+double percentile(std::vector<double> values, double fraction) {
+    if (values.empty()) {
+        return 0.0;
+    }
+    size_t index = std::min(values.size() - 1, static_cast<size_t>(fraction * values.size()));
+    std::nth_element(values.begin(), values.begin() + index, values.end());
+    return values[index];
+}
+
+// Silences the server's per-request logging while it is measured
+class QuietStdout {
+public:
+    QuietStdout() : devNull("/dev/null"), saved(std::cout.rdbuf(devNull.rdbuf())) {}
+    ~QuietStdout() { std::cout.rdbuf(saved); }
+
+private:
+    std::ofstream devNull;
+    std::streambuf* saved;
+};
+
+class Runner {
+public:
+    Runner(const std::string& filter, int rounds) : filter(filter), rounds(std::max(1, rounds)) {}
+
+    bool selected(const std::string& name) const {
+        return filter.empty() || name.find(filter) != std::string::npos;
+    }
+
+    // `samples` timings of `opsPerSample` back-to-back calls each, so ops
+    // far shorter than the clock's resolution still time accurately
+    void measure(const std::string& name, int samples, int opsPerSample, const std::function<void()>& op) {
+        if (!selected(name)) {
+            return;
+        }
+        op(); // Warm caches and lazily built state
+
+        measureRounds(name, [&]() {
+            std::vector<double> perOpNs;
+            perOpNs.reserve(samples);
+            uint64_t allocationsBefore = g_allocations.load();
+            for (int sample = 0; sample < samples; ++sample) {
+                auto start = Clock::now();
+                for (int i = 0; i < opsPerSample; ++i) {
+                    op();
+                }
+                perOpNs.push_back(std::chrono::duration<double, std::nano>(Clock::now() - start).count() / opsPerSample);
+            }
+            return summarize(perOpNs, g_allocations.load() - allocationsBefore,
+                             static_cast<uint64_t>(samples) * opsPerSample);
+        });
+    }
+
+    // Each metric keeps its best round: interference from other processes
+    // only ever makes a round slower, so the minimum is the stable estimate
+    void measureRounds(const std::string& name, const std::function<BenchmarkResult()>& round) {
+        if (!selected(name)) {
+            return;
+        }
+        BenchmarkResult best = round();
+        for (int i = 1; i < rounds; ++i) {
+            BenchmarkResult result = round();
+            best.p50Ns = std::min(best.p50Ns, result.p50Ns);
+            best.p99Ns = std::min(best.p99Ns, result.p99Ns);
+            best.allocsPerOp = std::min(best.allocsPerOp, result.allocsPerOp);
+            best.ops += result.ops;
+        }
+        record(name, best);
+    }
+
+    static BenchmarkResult summarize(const std::vector<double>& perOpNs, uint64_t allocations, uint64_t ops) {
+        BenchmarkResult result;
+        result.p50Ns = percentile(perOpNs, 0.50);
+        result.p99Ns = percentile(perOpNs, 0.99);
+        result.allocsPerOp = ops > 0 ? static_cast<double>(allocations) / ops : 0.0;
+        result.ops = ops;
+        return result;
+    }
+
+    void record(const std::string& name, const BenchmarkResult& result) {
+        results[name] = result;
+
+        std::cerr << "  " << std::left << std::setw(32) << name << std::right << std::fixed << std::setprecision(0)
+                  << std::setw(12) << result.p50Ns << " ns p50" << std::setw(12) << result.p99Ns << " ns p99"
+                  << std::setprecision(1) << std::setw(10) << result.allocsPerOp << " allocs/op" << std::endl;
+    }
+
+    const std::map<std::string, BenchmarkResult>& getResults() const { return results; }
+
+private:
+    std::string filter;
+    int rounds;
+    std::map<std::string, BenchmarkResult> results;
+};
+
+std::string readFile(const std::string& path) {
+    std::ifstream in(path);
+    std::stringstream buffer;
+    buffer << in.rdbuf();
+    return buffer.str();
+}
+
+const char* const kSampleResponse = " Which planet in our solar system is known as the Red Planet?\n"
+                                    "A) Venus\nB) Mars\nC) Jupiter\nAnswer: B\n";
+
+void runSamplerSuite(Runner& runner) {
+    std::mt19937_64 rng(7);
+    std::normal_distribution<float> noise(0.0f, 3.0f);
+    const int n_vocab = 50257;
+    std::vector<float> logits(n_vocab);
+    for (float& logit : logits) {
+        logit = noise(rng);
+    }
+
+    GenerationParams greedy;
+    greedy.temperature = 0.0f;
+    GenerationParams defaults;
+    GenerationParams topK;
+    topK.topK = 40;
+    GenerationParams topP;
+    topP.topP = 0.9f;
+
+    runner.measure("sampler.greedy", 200, 10, [&]() { keep(sampleToken(logits.data(), n_vocab, greedy, rng)); });
+    runner.measure("sampler.temperature", 200, 10, [&]() { keep(sampleToken(logits.data(), n_vocab, defaults, rng)); });
+    runner.measure("sampler.top_k", 200, 10, [&]() { keep(sampleToken(logits.data(), n_vocab, topK, rng)); });
+    runner.measure("sampler.top_p", 100, 5, [&]() { keep(sampleToken(logits.data(), n_vocab, topP, rng)); });
+}
+
+void runParserSuite(Runner& runner, const std::string& templatesPath) {
+    // Detokenized pieces are a few bytes each
+    StopMatcher matcher({"Question:", "Answer:", "D)"});
+    std::string text;
+    while (text.size() < 2048) {
+        text += "The quick brown fox jumps over the lazy dog while answering nothing. ";
+    }
+    runner.measure("parser.stop_matcher", 200, 20, [&]() {
+        StopMatcher::State state = 0;
+        StopMatcher::Match match;
+        for (size_t pos = 0; pos < text.size(); pos += 4) {
+            matcher.feed(state, text.data() + pos, std::min<size_t>(4, text.size() - pos), match);
+        }
+        keep(state);
+    });
+
+    runner.measure("parser.simhash", 200, 100, []() { keep(NearDuplicateIndex::simhash(kSampleResponse)); });
+
+    std::string templatesJson = readFile(templatesPath);
+    if (templatesJson.empty()) {
+        std::cerr << "⚠️ " << templatesPath << " not readable, skipping parser.templates" << std::endl;
+        return;
+    }
+    runner.measure("parser.templates", 100, 5, [&]() {
+        TemplateSet set;
+        std::string error;
+        keep(TemplateRegistry::parse(templatesJson, set, error));
+    });
+}
+
+void runJsonSuite(Runner& runner) {
+    // Shaped like HttpServer::questionToJson output
+    auto question = []() {
+        Json::Value json;
+        json["id"] = "q-1700000000000";
+        json["question"] = "Which planet in our solar system is known as the Red Planet?";
+        json["category"] = "Science";
+        json["difficulty"] = "Medium";
+        json["correctAnswerIndex"] = 1;
+        json["correctAnswerPriceMultiplier"] = 1.5;
+        json["wrongAnswerPriceMultiplier"] = 0.8;
+        json["stealChance"] = 0.1;
+        json["stealPercentage"] = 0.2;
+        json["generated"] = true;
+        json["source"] = "generated";
+        json["aiModel"] = "Quiz Model";
+        json["generationTimeMs"] = 120;
+        Json::Value answers(Json::arrayValue);
+        answers.append("Venus");
+        answers.append("Mars");
+        answers.append("Jupiter");
+        json["answers"] = answers;
+        return json;
+    };
+
+    runner.measure("json.serialize_question", 200, 20, [&]() {
+        Json::Value response;
+        response["success"] = true;
+        response["question"] = question();
+        Json::StreamWriterBuilder builder;
+        builder["indentation"] = "";
+        keep(Json::writeString(builder, response));
+    });
+
+    const std::string body = R"({"category":"Science","difficulty":"Medium","playerName":"Perf","seed":42,"temperature":0.7})";
+    runner.measure("json.parse_request", 200, 20, [&]() {
+        Json::CharReaderBuilder builder;
+        Json::Value json;
+        std::string errors;
+        std::istringstream stream(body);
+        keep(Json::parseFromStream(builder, stream, &json, &errors));
+    });
+
+    ResponseCompressor compressor;
+    if (compressor.negotiate("gzip") == ContentEncoding::Gzip) {
+        std::string payload;
+        for (int i = 0; i < 40; ++i) {
+            payload += Json::writeString(Json::StreamWriterBuilder(), question());
+        }
+        runner.measure("json.gzip_response", 100, 5, [&]() {
+            std::string compressed;
+            keep(compressor.compress(payload, ContentEncoding::Gzip, compressed));
+        });
+    }
+}
+
+void runIndexSuite(Runner& runner) {
+    const size_t dimensions = 768, rows = 10000, keys = 36;
+    EmbeddingIndex index;
+    index.open("", dimensions, 1);
+
+    std::mt19937_64 rng(11);
+    std::normal_distribution<float> noise;
+    std::vector<float> vector(dimensions);
+    for (size_t row = 0; row < rows; ++row) {
+        for (float& component : vector) {
+            component = noise(rng);
+        }
+        index.add(row, static_cast<uint32_t>(row % keys), vector);
+    }
+
+    runner.measure("index.search_key", 200, 10, [&]() { keep(index.search(vector, 16, {7}, 0.0f)); });
+    runner.measure("index.search_all", 50, 1, [&]() { keep(index.search(vector, 16)); });
+}
+
+void runGeneratorSuite(Runner& runner) {
+    if (!runner.selected("generator.")) {
+        return;
+    }
+    QuietStdout quiet;
+    AIQuizGenerator generator(ModelZooConfig::forRoles("stub.gguf", "stub.gguf", "stub.gguf"));
+
+    // Explicit parameters bypass the pool, bank and cache: every call decodes
+    GenerationParams params;
+    runner.measure("generator.quiz", 20, 1, [&]() {
+        generator.generateQuestion("Science", "Medium", "Perf", std::nullopt, params);
+    });
+}
+
+void runHttpSuite(Runner& runner, int port) {
+    if (!runner.selected("http.")) {
+        return;
+    }
+    QuietStdout quiet;
+    HttpServer server("127.0.0.1", port, "stub.gguf");
+    if (!server.start()) {
+        std::cerr << "❌ Could not start the server on port " << port << ", skipping http.*" << std::endl;
+        return;
+    }
+
+    // Without TCP_NODELAY, delayed ACKs add ~40 ms to every request
+    httplib::Client client("127.0.0.1", port);
+    client.set_keep_alive(true);
+    client.set_tcp_nodelay(true);
+    runner.measure("http.categories", 300, 1, [&]() { client.Get("/api/quiz/categories"); });
+
+    // The same seed answers from the generation cache after the first call
+    const std::string seeded = R"({"category":"Science","difficulty":"Medium","playerName":"Perf","seed":42})";
+    runner.measure("http.quiz_seeded", 300, 1, [&]() {
+        client.Post("/api/quiz/generate", seeded, "application/json");
+    });
+
+    // A bulk questionnaire upload: descriptions come from the cache after the
+    // first call, so this times scoring and NDJSON streaming
+    std::string batch = R"({"profiles":[)";
+    for (int p = 0; p < 1000; ++p) {
+        batch += std::string(p ? "," : "") + R"({"id":)" + std::to_string(p) + R"(,"answers":[)";
+        for (int q = 1; q <= 8; ++q) {
+            batch += std::string(q > 1 ? "," : "") + R"({"questionId":)" + std::to_string(q) +
+                     R"(,"selectedOption":)" + std::to_string((p * 7 + q * 3) % 3) + "}";
+        }
+        batch += "]}";
+    }
+    batch += "]}";
+    runner.measure("http.analyze_batch", 30, 1, [&]() {
+        client.Post("/api/psychology/analyze/batch", batch, "application/json");
+    });
+
+    // Concurrent players across categories: a mix of pool hits and generation
+    const char* categories[] = {"Science", "Technology", "History", "Mathematics"};
+    runner.measureRounds("http.quiz_load", [&]() {
+        const int clients = 8, requestsPerClient = 5;
+        std::vector<std::vector<double>> latencies(clients);
+        uint64_t allocationsBefore = g_allocations.load();
+
+        std::vector<std::thread> threads;
+        for (int c = 0; c < clients; ++c) {
+            threads.emplace_back([&, c]() {
+                httplib::Client player("127.0.0.1", port);
+                player.set_keep_alive(true);
+                player.set_tcp_nodelay(true);
+                for (int i = 0; i < requestsPerClient; ++i) {
+                    std::string body = std::string(R"({"category":")") + categories[(c + i) % 4] +
+                                       R"(","difficulty":"Medium","playerName":"Player)" + std::to_string(c) + "\"}";
+                    auto start = Clock::now();
+                    player.Post("/api/quiz/generate", body, "application/json");
+                    latencies[c].push_back(std::chrono::duration<double, std::nano>(Clock::now() - start).count());
+                }
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+
+        std::vector<double> all;
+        for (const auto& perClient : latencies) {
+            all.insert(all.end(), perClient.begin(), perClient.end());
+        }
+        return Runner::summarize(all, g_allocations.load() - allocationsBefore, all.size());
+    });
+
+    server.shutdown(std::chrono::milliseconds(0));
+}
+
+// Replays recorded requests (one JSON object per line: method, path, and
+// optional headers and body) against the in-process server from several
+// clients. This is the PGO training workload; nothing is measured
+bool replayRequests(const std::string& path, int port, int passes) {
+    std::ifstream in(path);
+    if (!in) {
+        std::cerr << "❌ Cannot read " << path << std::endl;
+        return false;
+    }
+
+    std::vector<httplib::Request> requests;
+    Json::CharReaderBuilder builder;
+    Json::StreamWriterBuilder writer;
+    writer["indentation"] = "";
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.empty()) {
+            continue;
+        }
+        Json::Value json;
+        std::string errors;
+        std::istringstream stream(line);
+        if (!Json::parseFromStream(builder, stream, &json, &errors) || !json.isObject()) {
+            std::cerr << "❌ Invalid request in " << path << ": " << errors << std::endl;
+            return false;
+        }
+
+        httplib::Request request;
+        request.method = json.get("method", "GET").asString();
+        request.path = json.get("path", "/").asString();
+        for (const auto& name : json["headers"].getMemberNames()) {
+            request.headers.emplace(name, json["headers"][name].asString());
+        }
+        // Bodies are JSON, or a string sent verbatim (e.g. deliberately malformed)
+        if (json.isMember("body")) {
+            request.body = json["body"].isString() ? json["body"].asString() : Json::writeString(writer, json["body"]);
+            request.headers.emplace("Content-Type", "application/json");
+        }
+        requests.push_back(std::move(request));
+    }
+
+    QuietStdout quiet;
+    HttpServer server("127.0.0.1", port, "stub.gguf");
+    if (!server.start()) {
+        std::cerr << "❌ Could not start the server on port " << port << std::endl;
+        return false;
+    }
+
+    // Clients start at different offsets so the server sees a mix
+    const int clients = 4;
+    std::atomic<int> succeeded{0}, failed{0};
+    std::vector<std::thread> threads;
+    for (int c = 0; c < clients; ++c) {
+        threads.emplace_back([&, c]() {
+            httplib::Client client("127.0.0.1", port);
+            client.set_keep_alive(true);
+            client.set_tcp_nodelay(true);
+            for (int pass = 0; pass < passes; ++pass) {
+                for (size_t i = 0; i < requests.size(); ++i) {
+                    auto result = client.send(requests[(i + c * requests.size() / clients) % requests.size()]);
+                    (result ? succeeded : failed)++;
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    server.shutdown(std::chrono::seconds(5));
+
+    std::cerr << "🔁 Replayed " << requests.size() << " requests x " << passes << " passes x " << clients
+              << " clients: " << succeeded << " answered, " << failed << " failed" << std::endl;
+    return failed == 0;
+}
+
+Json::Value resultsToJson(const std::map<std::string, BenchmarkResult>& results, const Thresholds& thresholds) {
+    Json::Value root;
+    root["thresholds"]["p50"] = thresholds.p50;
+    root["thresholds"]["p99"] = thresholds.p99;
+    root["thresholds"]["allocs"] = thresholds.allocs;
+    for (const auto& entry : results) {
+        Json::Value& benchmark = root["benchmarks"][entry.first];
+        benchmark["p50_ns"] = entry.second.p50Ns;
+        benchmark["p99_ns"] = entry.second.p99Ns;
+        benchmark["allocs_per_op"] = entry.second.allocsPerOp;
+    }
+    return root;
+}
+
+bool writeJson(const std::string& path, const Json::Value& json) {
+    Json::StreamWriterBuilder builder;
+    builder["indentation"] = "  ";
+    std::ofstream out(path);
+    out << Json::writeString(builder, json) << std::endl;
+    return static_cast<bool>(out);
+}
+
+// Prints one row per metric and returns the number of regressions
+int compareWithBaseline(const std::map<std::string, BenchmarkResult>& results, const Json::Value& baseline,
+                        const Thresholds& thresholds) {
+    std::cout << std::left << std::setw(32) << "benchmark" << std::setw(8) << "metric" << std::right
+              << std::setw(14) << "baseline" << std::setw(14) << "current" << std::setw(10) << "change"
+              << "  status" << std::endl;
+    std::cout << std::string(88, '-') << std::endl;
+
+    int regressions = 0;
+    for (const auto& entry : results) {
+        const Json::Value& base = baseline["benchmarks"][entry.first];
+        if (!base.isObject()) {
+            std::cout << std::left << std::setw(32) << entry.first << "  (not in baseline)" << std::endl;
+            continue;
+        }
+
+        struct Metric {
+            const char* label;
+            const char* key;
+            double current;
+            double threshold;
+        };
+        const Metric metrics[] = {
+            {"p50", "p50_ns", entry.second.p50Ns, thresholds.p50},
+            {"p99", "p99_ns", entry.second.p99Ns, thresholds.p99},
+            {"allocs", "allocs_per_op", entry.second.allocsPerOp, thresholds.allocs},
+        };
+        for (const auto& metric : metrics) {
+            double before = base[metric.key].asDouble();
+            double change = before > 0 ? (metric.current - before) / before : (metric.current > 0 ? 1.0 : 0.0);
+            // Fractional allocations come from background threads; ignore under half an allocation
+            bool regressed = metric.current > before * (1.0 + metric.threshold) &&
+                             !(metric.key == std::string("allocs_per_op") && metric.current - before < 0.5);
+            regressions += regressed ? 1 : 0;
+
+            std::cout << std::left << std::setw(32) << entry.first << std::setw(8) << metric.label << std::right
+                      << std::fixed << std::setprecision(1) << std::setw(14) << before << std::setw(14)
+                      << metric.current << std::setw(9) << change * 100.0 << "%  "
+                      << (regressed ? "REGRESSED" : (change < -metric.threshold ? "improved" : "ok")) << std::endl;
+        }
+    }
+
+    for (const auto& name : baseline["benchmarks"].getMemberNames()) {
+        if (!results.count(name)) {
+            std::cout << std::left << std::setw(32) << name << "  (in baseline, not run)" << std::endl;
+        }
+    }
+    return regressions;
+}
+
+} // namespace
+
+// Count every allocation in the process, server threads included
+void* operator new(std::size_t size) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* pointer = std::malloc(size ? size : 1)) {
+        return pointer;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* pointer) noexcept {
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, std::size_t) noexcept {
+    std::free(pointer);
+}
+
+int main(int argc, char* argv[]) {
+    std::string baselinePath = "bench/baseline.json";
+    std::string templatesPath = "config/templates.json";
+    std::string jsonPath;
+    std::string filter;
+    std::string replayPath;
+    bool updateBaseline = false;
+    int port = 18480;
+    int rounds = 5;
+    std::optional<double> p50Threshold, p99Threshold, allocThreshold;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--baseline" && i + 1 < argc) {
+            baselinePath = argv[++i];
+        } else if (arg == "--update-baseline") {
+            updateBaseline = true;
+        } else if (arg == "--json" && i + 1 < argc) {
+            jsonPath = argv[++i];
+        } else if (arg == "--filter" && i + 1 < argc) {
+            filter = argv[++i];
+        } else if (arg == "--templates" && i + 1 < argc) {
+            templatesPath = argv[++i];
+        } else if (arg == "--replay" && i + 1 < argc) {
+            replayPath = argv[++i];
+        } else if (arg == "--rounds" && i + 1 < argc) {
+            rounds = std::stoi(argv[++i]);
+        } else if (arg == "--port" && i + 1 < argc) {
+            port = std::stoi(argv[++i]);
+        } else if (arg == "--p50-threshold" && i + 1 < argc) {
+            p50Threshold = std::stod(argv[++i]);
+        } else if (arg == "--p99-threshold" && i + 1 < argc) {
+            p99Threshold = std::stod(argv[++i]);
+        } else if (arg == "--alloc-threshold" && i + 1 < argc) {
+            allocThreshold = std::stod(argv[++i]);
+        } else if (arg == "--simd" && i + 1 < argc) {
+            std::string variant = argv[++i];
+            if (!selectSimdKernels(variant)) {
+                std::cerr << "❌ SIMD kernels '" << variant << "' are not supported on this CPU" << std::endl;
+                return 2;
+            }
+        } else if (arg == "--help") {
+            std::cout << "Usage: " << argv[0] << " [options]" << std::endl;
+            std::cout << "Options:" << std::endl;
+            std::cout << "  --baseline <path>        Baseline to compare with (default: bench/baseline.json)" << std::endl;
+            std::cout << "  --update-baseline        Write this run's results as the new baseline" << std::endl;
+            std::cout << "  --json <path>            Also write this run's results to <path>" << std::endl;
+            std::cout << "  --filter <text>          Only run benchmarks whose name contains <text>" << std::endl;
+            std::cout << "  --templates <path>       Template file for parser.templates (default: config/templates.json)" << std::endl;
+            std::cout << "  --replay <path>          Replay recorded requests instead of benchmarking (PGO training)" << std::endl;
+            std::cout << "  --rounds <n>             Rounds per benchmark, keeping each metric's best, or passes" << std::endl;
+            std::cout << "                           over the --replay file (default: 5)" << std::endl;
+            std::cout << "  --port <port>            Loopback port for the http.* suite (default: 18480)" << std::endl;
+            std::cout << "  --simd <variant>         Force the generic, avx2 or avx512 kernels (default: best supported)" << std::endl;
+            std::cout << "  --p50-threshold <frac>   Allowed p50 growth, e.g. 0.15 (default: baseline's, else 0.15)" << std::endl;
+            std::cout << "  --p99-threshold <frac>   Allowed p99 growth (default: baseline's, else 0.35)" << std::endl;
+            std::cout << "  --alloc-threshold <frac> Allowed allocations/op growth (default: baseline's, else 0.05)" << std::endl;
+            return 0;
+        }
+    }
+
+    std::cout << "🧮 SIMD kernels: " << simdKernels().name << std::endl;
+    if (!replayPath.empty()) {
+        return replayRequests(replayPath, port, rounds) ? 0 : 1;
+    }
+
+    Json::Value baseline;
+    std::string baselineText = readFile(baselinePath);
+    if (!baselineText.empty()) {
+        Json::CharReaderBuilder builder;
+        std::string errors;
+        std::istringstream stream(baselineText);
+        if (!Json::parseFromStream(builder, stream, &baseline, &errors)) {
+            std::cerr << "❌ Invalid baseline " << baselinePath << ": " << errors << std::endl;
+            return 2;
+        }
+    }
+
+    // Command line beats the baseline's thresholds, which beat the defaults
+    Thresholds thresholds;
+    const Json::Value& stored = baseline["thresholds"];
+    thresholds.p50 = p50Threshold.value_or(stored.get("p50", thresholds.p50).asDouble());
+    thresholds.p99 = p99Threshold.value_or(stored.get("p99", thresholds.p99).asDouble());
+    thresholds.allocs = allocThreshold.value_or(stored.get("allocs", thresholds.allocs).asDouble());
+
+    std::cerr << "⏱️ Running benchmarks (stub backend)" << std::endl;
+    Runner runner(filter, rounds);
+    runSamplerSuite(runner);
+    runParserSuite(runner, templatesPath);
+    runJsonSuite(runner);
+    runIndexSuite(runner);
+    runGeneratorSuite(runner);
+    runHttpSuite(runner, port);
+
+    Json::Value current = resultsToJson(runner.getResults(), thresholds);
+    if (!jsonPath.empty() && !writeJson(jsonPath, current)) {
+        std::cerr << "❌ Failed to write " << jsonPath << std::endl;
+        return 2;
+    }
+
+    if (updateBaseline) {
+        if (!writeJson(baselinePath, current)) {
+            std::cerr << "❌ Failed to write " << baselinePath << std::endl;
+            return 2;
+        }
+        std::cout << "📝 Baseline written to " << baselinePath << std::endl;
+        return 0;
+    }
+
+    if (baseline.isNull()) {
+        std::cerr << "⚠️ No baseline at " << baselinePath << "; run with --update-baseline to create one" << std::endl;
+        return 0;
+    }
+
+    int regressions = compareWithBaseline(runner.getResults(), baseline, thresholds);
+    if (regressions > 0) {
+        std::cout << "❌ " << regressions << " metric(s) regressed beyond thresholds (p50 "
+                  << thresholds.p50 * 100 << "%, p99 " << thresholds.p99 * 100 << "%, allocs "
+                  << thresholds.allocs * 100 << "%)" << std::endl;
+        return 1;
+    }
+    std::cout << "✅ No regressions against " << baselinePath << std::endl;
+    return 0;
+}
@@ -0,0 +1,365 @@
+// Stand-in for the llama.cpp API, linked into ai_quiz_perf instead of the
+// real library so the server can be benchmarked offline and without model
+// weights. Every "model" deterministically continues any prompt with the same
+// well-formed quiz answer, so requests exercise the full decode, sampling,
+// stop matching and parsing path while the model itself costs nothing.
+#include "llama.h"
+#include "ggml-backend.h"
+#include "ggml-cpu.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace {
+
+// Token ids: 0 is end-of-generation, 1..256 are prompt bytes, and the canned
+// answer's characters follow from kAnswerBase. The vocabulary is padded to
+// GPT-2's size so the sampler does realistic work
+const int32_t kVocabSize = 50257;
+const llama_token kEos = 0;
+const llama_token kAnswerBase = 257;
+const int32_t kEmbeddingSize = 64;
+
+const std::string kAnswer = " Which planet in our solar system is known as the Red Planet?\n"
+                            "A) Venus\nB) Mars\nC) Jupiter\nAnswer: B\n";
+
+// The only token the "model" predicts after `token`
+llama_token successor(llama_token token) {
+    if (token >= kAnswerBase) {
+        size_t next = static_cast<size_t>(token - kAnswerBase) + 1;
+        return next < kAnswer.size() ? kAnswerBase + static_cast<llama_token>(next) : kEos;
+    }
+    return kAnswerBase;
+}
+
+// Logits other than the predicted token's: uniform in [-4, 4), like the
+// spread of a real model's tail, so sampling (and a PGO training run) does
+// realistic work. The predicted token scores 30 and always wins
+const std::vector<float>& noiseFloor() {
+    static const std::vector<float> row = []() {
+        std::vector<float> values(kVocabSize);
+        uint32_t state = 2463534242u;
+        for (float& value : values) {
+            state ^= state << 13;
+            state ^= state >> 17;
+            state ^= state << 5;
+            value = static_cast<float>(state % 8000) / 1000.0f - 4.0f;
+        }
+        return values;
+    }();
+    return row;
+}
+
+} // namespace
+
+struct llama_vocab {};
+
+struct llama_model {
+    std::string path;
+    llama_vocab vocab;
+};
+
+struct llama_context {
+    llama_model* model;
+    llama_context_params params;
+    std::vector<float> logits;     // One kVocabSize row per output of the last decode
+    std::vector<int32_t> rowOutput; // Batch row -> output row, or -1
+    std::vector<float> embedding;  // Pooled over the last decode
+};
+
+void llama_backend_init(void) {}
+
+void llama_backend_free(void) {}
+
+void ggml_backend_load_all(void) {}
+
+// The CPU backend's threadpool API, found through the registry as with a
+// dynamically loaded backend. The stub decodes on the calling thread, so
+// its pools start none
+struct ggml_threadpool {
+    int n_threads;
+};
+
+struct ggml_backend_device {};
+struct ggml_backend_reg {};
+
+struct ggml_threadpool_params ggml_threadpool_params_default(int n_threads) {
+    ggml_threadpool_params params = {};
+    params.n_threads = n_threads;
+    params.prio = GGML_SCHED_PRIO_NORMAL;
+    params.poll = 50;
+    return params;
+}
+
+struct ggml_threadpool* ggml_threadpool_new(struct ggml_threadpool_params* params) {
+    return new ggml_threadpool{params->n_threads};
+}
+
+void ggml_threadpool_free(struct ggml_threadpool* threadpool) {
+    delete threadpool;
+}
+
+ggml_backend_dev_t ggml_backend_dev_by_type(enum ggml_backend_dev_type type) {
+    static ggml_backend_device cpu;
+    return type == GGML_BACKEND_DEVICE_TYPE_CPU ? &cpu : nullptr;
+}
+
+ggml_backend_reg_t ggml_backend_dev_backend_reg(ggml_backend_dev_t) {
+    static ggml_backend_reg reg;
+    return &reg;
+}
+
+void* ggml_backend_reg_get_proc_address(ggml_backend_reg_t, const char* name) {
+    if (std::strcmp(name, "ggml_threadpool_new") == 0) {
+        return reinterpret_cast<void*>(&ggml_threadpool_new);
+    }
+    if (std::strcmp(name, "ggml_threadpool_free") == 0) {
+        return reinterpret_cast<void*>(&ggml_threadpool_free);
+    }
+    return nullptr;
+}
+
+const char* llama_print_system_info(void) {
+    return "stub";
+}
+
+struct llama_model_params llama_model_default_params(void) {
+    llama_model_params params = {};
+    return params;
+}
+
+struct llama_context_params llama_context_default_params(void) {
+    llama_context_params params = {};
+    params.n_ctx = 512;
+    params.n_batch = 2048;
+    params.n_ubatch = 512;
+    params.n_seq_max = 1;
+    params.n_threads = 4;
+    params.n_threads_batch = 4;
+    return params;
+}
+
+struct llama_model* llama_model_load_from_file(const char* path_model, struct llama_model_params) {
+    auto* model = new llama_model();
+    model->path = path_model;
+    return model;
+}
+
+void llama_model_free(struct llama_model* model) {
+    delete model;
+}
+
+struct llama_context* llama_init_from_model(struct llama_model* model, struct llama_context_params params) {
+    auto* context = new llama_context();
+    context->model = model;
+    context->params = params;
+    return context;
+}
+
+void llama_free(struct llama_context* ctx) {
+    delete ctx;
+}
+
+const struct llama_vocab* llama_model_get_vocab(const struct llama_model* model) {
+    return &model->vocab;
+}
+
+int32_t llama_model_n_embd(const struct llama_model*) {
+    return kEmbeddingSize;
+}
+
+int32_t llama_model_desc(const struct llama_model*, char* buf, size_t buf_size) {
+    return snprintf(buf, buf_size, "stub backend");
+}
+
+uint64_t llama_model_size(const struct llama_model*) {
+    return 0;
+}
+
+uint32_t llama_n_ctx(const struct llama_context* ctx) {
+    return ctx->params.n_ctx;
+}
+
+uint32_t llama_n_batch(const struct llama_context* ctx) {
+    return ctx->params.n_batch;
+}
+
+uint32_t llama_n_ubatch(const struct llama_context* ctx) {
+    return ctx->params.n_ubatch;
+}
+
+uint32_t llama_n_seq_max(const struct llama_context* ctx) {
+    return ctx->params.n_seq_max;
+}
+
+int32_t llama_n_threads(struct llama_context* ctx) {
+    return ctx->params.n_threads;
+}
+
+void llama_attach_threadpool(struct llama_context*, ggml_threadpool_t, ggml_threadpool_t) {}
+
+void llama_detach_threadpool(struct llama_context*) {}
+
+void llama_set_n_threads(struct llama_context* ctx, int32_t n_threads, int32_t n_threads_batch) {
+    ctx->params.n_threads = n_threads;
+    ctx->params.n_threads_batch = n_threads_batch;
+}
+
+// Adapters load but leave the output unchanged
+struct llama_adapter_lora {};
+
+struct llama_adapter_lora* llama_adapter_lora_init(struct llama_model*, const char*) {
+    return new llama_adapter_lora();
+}
+
+void llama_adapter_lora_free(struct llama_adapter_lora* adapter) {
+    delete adapter;
+}
+
+int32_t llama_set_adapter_lora(struct llama_context*, struct llama_adapter_lora*, float) {
+    return 0;
+}
+
+void llama_clear_adapter_lora(struct llama_context*) {}
+
+int32_t llama_tokenize(const struct llama_vocab*, const char* text, int32_t text_len, llama_token* tokens,
+                       int32_t n_tokens_max, bool, bool) {
+    if (text_len > n_tokens_max) {
+        return -text_len;
+    }
+    for (int32_t i = 0; i < text_len; ++i) {
+        tokens[i] = static_cast<unsigned char>(text[i]) + 1;
+    }
+    return text_len;
+}
+
+int32_t llama_token_to_piece(const struct llama_vocab*, llama_token token, char* buf, int32_t length, int32_t, bool) {
+    char piece;
+    if (token >= kAnswerBase && static_cast<size_t>(token - kAnswerBase) < kAnswer.size()) {
+        piece = kAnswer[token - kAnswerBase];
+    } else if (token >= 1 && token <= 256) {
+        piece = static_cast<char>(token - 1);
+    } else {
+        return 0;
+    }
+    if (length < 1) {
+        return -1;
+    }
+    buf[0] = piece;
+    return 1;
+}
+
+int32_t llama_vocab_n_tokens(const struct llama_vocab*) {
+    return kVocabSize;
+}
+
+llama_token llama_vocab_eos(const struct llama_vocab*) {
+    return kEos;
+}
+
+void llama_kv_self_clear(struct llama_context*) {}
+
+bool llama_kv_self_seq_rm(struct llama_context*, llama_seq_id, llama_pos, llama_pos) {
+    return true;
+}
+
+void llama_kv_self_seq_cp(struct llama_context*, llama_seq_id, llama_seq_id, llama_pos, llama_pos) {}
+
+struct llama_batch llama_batch_get_one(llama_token* tokens, int32_t n_tokens) {
+    llama_batch batch = {};
+    batch.n_tokens = n_tokens;
+    batch.token = tokens;
+    return batch;
+}
+
+struct llama_batch llama_batch_init(int32_t n_tokens, int32_t, int32_t n_seq_max) {
+    llama_batch batch = {};
+    batch.token = static_cast<llama_token*>(malloc(sizeof(llama_token) * n_tokens));
+    batch.pos = static_cast<llama_pos*>(malloc(sizeof(llama_pos) * n_tokens));
+    batch.n_seq_id = static_cast<int32_t*>(malloc(sizeof(int32_t) * n_tokens));
+    batch.seq_id = static_cast<llama_seq_id**>(malloc(sizeof(llama_seq_id*) * (n_tokens + 1)));
+    for (int32_t i = 0; i < n_tokens; ++i) {
+        batch.seq_id[i] = static_cast<llama_seq_id*>(malloc(sizeof(llama_seq_id) * n_seq_max));
+    }
+    batch.seq_id[n_tokens] = nullptr;
+    batch.logits = static_cast<int8_t*>(malloc(sizeof(int8_t) * n_tokens));
+    return batch;
+}
+
+void llama_batch_free(struct llama_batch batch) {
+    if (batch.seq_id) {
+        for (int32_t i = 0; batch.seq_id[i]; ++i) {
+            free(batch.seq_id[i]);
+        }
+    }
+    free(batch.token);
+    free(batch.pos);
+    free(batch.n_seq_id);
+    free(batch.seq_id);
+    free(batch.logits);
+}
+
+int32_t llama_decode(struct llama_context* ctx, struct llama_batch batch) {
+    // Like llama.cpp, a decode takes at most n_batch tokens
+    if (batch.n_tokens <= 0 || !batch.token || static_cast<uint32_t>(batch.n_tokens) > ctx->params.n_batch) {
+        return -1;
+    }
+
+    // Like llama.cpp, a batch without output flags only outputs its last token
+    ctx->rowOutput.assign(batch.n_tokens, -1);
+    int32_t outputs = 0;
+    for (int32_t i = 0; i < batch.n_tokens; ++i) {
+        if (batch.logits ? batch.logits[i] != 0 : i == batch.n_tokens - 1) {
+            ctx->rowOutput[i] = outputs++;
+        }
+    }
+
+    ctx->logits.resize(static_cast<size_t>(outputs) * kVocabSize);
+    for (int32_t i = 0; i < batch.n_tokens; ++i) {
+        if (ctx->rowOutput[i] >= 0) {
+            float* row = ctx->logits.data() + static_cast<size_t>(ctx->rowOutput[i]) * kVocabSize;
+            std::copy(noiseFloor().begin(), noiseFloor().end(), row);
+            row[successor(batch.token[i])] = 30.0f;
+        }
+    }
+
+    // Hashed bag of tokens, so similar texts get similar vectors
+    if (ctx->params.embeddings) {
+        ctx->embedding.assign(kEmbeddingSize, 0.0f);
+        for (int32_t i = 0; i < batch.n_tokens; ++i) {
+            ctx->embedding[(static_cast<uint32_t>(batch.token[i]) * 2654435761u) % kEmbeddingSize] += 1.0f;
+        }
+    }
+    return 0;
+}
+
+float* llama_get_logits_ith(struct llama_context* ctx, int32_t i) {
+    if (i < 0) {
+        i += static_cast<int32_t>(ctx->rowOutput.size());
+    }
+    if (i < 0 || i >= static_cast<int32_t>(ctx->rowOutput.size()) || ctx->rowOutput[i] < 0) {
+        return nullptr;
+    }
+    return ctx->logits.data() + static_cast<size_t>(ctx->rowOutput[i]) * kVocabSize;
+}
+
+float* llama_get_embeddings_ith(struct llama_context* ctx, int32_t) {
+    return ctx->embedding.empty() ? nullptr : ctx->embedding.data();
+}
+
+float* llama_get_embeddings_seq(struct llama_context* ctx, llama_seq_id) {
+    return ctx->embedding.empty() ? nullptr : ctx->embedding.data();
+}
+
+void llama_synchronize(struct llama_context*) {}
+
+size_t llama_state_seq_save_file(struct llama_context*, const char*, llama_seq_id, const llama_token*, size_t) {
+    return 0;
+}
+
+size_t llama_state_seq_load_file(struct llama_context*, const char*, llama_seq_id, llama_token*, size_t, size_t*) {
+    return 0;
+}
@@ -8,6 +8,24 @@
 #include <mutex>
 #include <atomic>
 #include <chrono>
+#include <thread>
+#include <condition_variable>
+#include <deque>
+#include <optional>
+#include <random>
+#include <functional>
+#include <cstdint>
+#include "question_bank.h"
+#include "near_duplicate_index.h"
+#include "embedding_index.h"
+#include "player_history.h"
+#include "model_zoo.h"
+#include "generation_cache.h"
+#include "template_registry.h"
+#include "generation_params.h"
+#include "inference_pools.h"
+#include "lora_adapters.h"
+#include "auto_tuner.h"
 
 // Forward declaration for llama.cpp types
 struct llama_model;
@@ -26,6 +44,8 @@ struct QuizQuestion {
     bool generated;
     std::string aiModel;
     int generationTimeMs;
+    std::string source; // "generated", "pool", "bank" or "fallback"
+    int retryAfterSeconds = 0; // Nothing could be served: answer 503, retry after this long
 };
 
 // New structures for psychological assessment
@@ -58,11 +78,35 @@ struct PersonalityResult {
     bool aiGenerated;
     std::string analysisModel;
     int analysisTimeMs;
+    std::string source; // Of the description: "generated", "cache" or "template"
+};
+
+// analyzePersonalityBatch() output. Everything that depends only on the type
+// (title, description, strengths, growth areas) is resolved once per
+// distinct type; scores and confidence are per answer set.
+struct PersonalityBatchResult {
+    std::vector<PersonalityResult> types; // First-seen order; scores, confidence and time unset
+    std::vector<uint8_t> typeIndex;       // Per answer set, into types
+    std::vector<double> extraversion;     // Per answer set, the E, S, T and J scores;
+    std::vector<double> sensing;          // I, N, F and P are one minus each
+    std::vector<double> thinking;
+    std::vector<double> judging;
+    std::vector<double> confidence;
+    int analysisTimeMs = 0;
+};
+
+// A zoo model's adapters, as reported to admins
+struct ModelAdapterState {
+    std::string model;
+    std::string basePath;
+    std::vector<LoraAdapterSpec> adapters;
+    bool applied; // The context runs with exactly these; changed adapters attach on the model's next use
 };
 
 // Model management structure
 struct ModelInstance {
     llama_model* model;
+    std::shared_ptr<llama_model> weights; // Owns model; shared by every instance loaded from the same file
     llama_context* context;
     std::string modelPath;
     std::string modelName;
@@ -71,24 +115,65 @@ struct ModelInstance {
     std::atomic<int> usageCount{0};
     std::chrono::steady_clock::time_point lastUsed;
     
+    // Load estimate for shedding: requests waiting for or holding the model,
+    // and a moving average of how long each holds it
+    std::atomic<int> pending{0};
+    std::atomic<int> serviceTimeMs{0};
+    
+    // Guarded by modelMutex: cached prompt tokenizations, and the prompt
+    // tokens whose KV cells sequence 0 currently holds
+    std::unordered_map<std::string, std::vector<int32_t>> tokenCache; // llama_token ids
+    std::vector<int32_t> kvPrefix;
+    
+    // Threadpool the context decodes on, null when it has its own threads.
+    // Guarded by modelMutex
+    std::shared_ptr<InferencePool> threadPool;
+    
+    // LoRA adapters on the shared weights, guarded by modelMutex. `adapters`
+    // is what the context should run with; they are loaded and attached when
+    // the context is next used, and loadedAdapters holds them while attached
+    std::vector<LoraAdapterSpec> adapters;
+    std::vector<std::shared_ptr<LoraAdapter>> loadedAdapters;
+    bool adaptersApplied = false;
+    
+    // The model and the adapters it runs with as named in generation cache
+    // keys (just the model while its adapters failed to load)
+    std::shared_ptr<const std::string> cacheIdentity;
+    
+    // Threads and batch sizes measured fastest on this host; the context is
+    // created with them. Guarded by modelMutex
+    std::optional<TunedSettings> tuning;
+    
+    // Measured prefill speed, which sizes prefill chunks (0 until measured).
+    // Guarded by modelMutex
+    double prefillTokensPerMs = 0.0;
+    
     ModelInstance() : model(nullptr), context(nullptr), isLoaded(false) {}
 };
 
 class AIQuizGenerator {
 private:
-    // Multiple small models for different tasks
-    std::unique_ptr<ModelInstance> quizModel;        // For quiz questions
-    std::unique_ptr<ModelInstance> psychologyModel;  // For psychology questions
-    std::unique_ptr<ModelInstance> analysisModel;    // For personality analysis
+    // Model zoo: one instance (with its own context) per configured model,
+    // routed to by task, category and difficulty. Instances loaded from the
+    // same file share its weights. The set is fixed after construction
+    ModelZooConfig zoo;
+    std::vector<std::unique_ptr<ModelInstance>> models;
     
     // Model configuration
-    int contextSize;
-    int maxTokens;
-    float temperature;
+    std::atomic<int> contextSize;
+    
+    // Per-role sampling defaults and request limits, swapped as a whole
+    std::shared_ptr<const GenerationSettings> generationSettings;
+    std::mutex settingsMutex;
     
     // Thread safety for model management
     std::mutex managerMutex;
     
+    // Shutdown: cancelling makes in-flight decodes stop at their next step
+    std::atomic<bool> generationCancelled{false};
+    std::atomic<bool> shutDown{false};
+    std::string stateDirectory; // Prompt KV state is saved here on shutdown; empty disables
+    
     // Performance tracking
     std::atomic<int> totalQuestionsGenerated{0};
     std::atomic<int> totalPsychQuestionsGenerated{0};
@@ -99,33 +184,149 @@ private:
     // Difficulty modifiers
     std::unordered_map<std::string, std::unordered_map<std::string, double>> difficultyModifiers;
     
-    // AI prompt templates for different categories and difficulties
-    std::unordered_map<std::string, std::unordered_map<std::string, std::string>> promptTemplates;
+    // AI prompt templates for quiz categories/difficulties and psychology questions
+    TemplateRegistry templates;
+    std::function<void()> templatesChanged;
     
-    // Psychological assessment templates and data
-    std::unordered_map<std::string, std::string> psychologyPromptTemplates;
+    // Psychological assessment data
     std::unordered_map<std::string, std::vector<std::string>> personalityTraits;
     std::unordered_map<std::string, std::string> personalityDescriptions;
     
+    // Quality gating: several candidates are decoded per question and
+    // malformed ones are rejected before parsing
+    static constexpr int kMaxCandidates = 4;
+    int candidatesPerQuestion = 3;
+    std::atomic<int> totalQuizRequests{0};
+    std::atomic<int> totalCandidatesGenerated{0};
+    std::atomic<int> totalCandidatesRejected{0};
+    std::atomic<int> totalFallbacksServed{0};
+    
+    // Load shedding: when a model's estimated wait exceeds the SLO, serve
+    // pooled, banked or cached content instead of queueing for it (0 disables)
+    std::atomic<int> latencySloMs{5000};
+    std::atomic<int> totalShedRequests{0};
+    
+    // Longest a prefill chunk should hold a shared threadpool, and so delay
+    // the next token of the models decoding beside it (0: n_batch chunks)
+    std::atomic<int> prefillTargetMs{25};
+    
+    // Seed used for requests that do not bring their own (unset: nondeterministic)
+    std::optional<uint64_t> globalSeed;
+    
+    // Memoized output of seeded generation, checked before taking a model mutex
+    std::unique_ptr<GenerationCache> generationCache;
+    
+    // Questions pre-generated in the background, per category/difficulty
+    static constexpr size_t kPoolCapacityPerKey = 4;
+    std::unordered_map<std::string, std::deque<QuizQuestion>> questionPool;
+    mutable std::mutex poolMutex;
+    std::atomic<int> totalPoolHits{0};
+    
+    // Persistent question bank, grown in the background by the quiz model
+    std::unique_ptr<QuestionBank> questionBank;
+    NearDuplicateIndex duplicateIndex;
+    std::atomic<int> totalBankHits{0};
+    std::atomic<int> totalBankAppends{0};
+    std::atomic<int> totalDuplicatesRejected{0};
+    
+    // Semantic index over banked questions, so requests for a topic or
+    // subcategory are served by retrieval instead of inference. The embedder
+    // is an embeddings-mode context on its own weights or the quiz model's
+    static constexpr size_t kTopicCandidates = 16;
+    static constexpr size_t kMaxCachedTopics = 1024;
+    std::unique_ptr<EmbeddingIndex> embeddingIndex;
+    std::unique_ptr<ModelInstance> embedder;
+    
+    // ggml threadpools every context (embedder included) decodes on
+    InferencePools inferencePools;
+    
+    // LoRA adapters loaded by the zoo's models
+    LoraAdapterCache loraAdapters;
+    float topicMinSimilarity = 0.35f;
+    std::unordered_map<std::string, std::vector<float>> topicEmbeddings; // Query vectors by topic
+    std::mutex topicMutex;
+    std::atomic<int> totalTopicHits{0};
+    
+    // Background worker that refills the pool, retries rejected generations and grows the bank
+    std::thread backgroundThread;
+    std::mutex backgroundMutex;
+    std::condition_variable backgroundCv;
+    std::deque<std::pair<std::string, std::string>> backgroundQueue;
+    bool backgroundStopping = false;
+    
+    // Per-player record of served questions, so banked questions are not repeated
+    PlayerHistory playerHistory;
+    std::atomic<int> totalPlayerRepeatsAvoided{0};
+    
     // Private methods for model management
-    bool initializeModel(ModelInstance* instance, const std::string& modelPath, const std::string& modelName);
+    bool loadModels();
+    std::shared_ptr<llama_model> loadWeights(const std::string& modelPath);
+    bool initializeModel(ModelInstance* instance, std::shared_ptr<llama_model> weights);
     void cleanupModel(ModelInstance* instance);
+    std::vector<ModelInstance*> modelInstances() const;
+    ModelInstance* modelFor(GenerationRole task, const std::string& category,
+                            const std::string& difficulty = "") const;
     bool isModelLoaded(ModelInstance* instance) const;
-    std::string generateText(ModelInstance* instance, const std::string& prompt);
+    bool createContext(ModelInstance* instance); // Caller holds instance->modelMutex
+    void applyAdapters(ModelInstance* instance); // Caller holds instance->modelMutex
+    void releaseContext(ModelInstance* instance); // Caller holds instance->modelMutex
+    std::string stateDirectoryPath();
+    static std::string stateFilePath(const ModelInstance* instance, const std::string& directory);
+    bool saveModelState(ModelInstance* instance);
+    bool restoreModelState(ModelInstance* instance);
+    bool saveQuestionPool();
+    size_t restoreQuestionPool();
+    std::string generateText(ModelInstance* instance, const std::string& prompt,
+                             const GenerationParams& params, std::optional<uint64_t> seed = std::nullopt);
+    std::vector<std::string> generateTexts(ModelInstance* instance, const std::string& prompt, int count,
+                                           const GenerationParams& params, std::optional<uint64_t> seed = std::nullopt);
+    bool lookupCachedTexts(ModelInstance* instance, const std::string& prompt, int count,
+                           const GenerationParams& params, uint64_t seed, std::vector<std::string>& responses);
+    bool shouldShed(const ModelInstance* instance) const;
+    int retryAfterSeconds(const ModelInstance* instance) const;
+    GenerationParams generationDefaults(GenerationRole role) const;
+    std::optional<uint64_t> resolveSeed(std::optional<uint64_t> requested) const;
     
     // Initialization methods
     void initializeDifficultyModifiers();
-    void initializePromptTemplates();
-    void initializePsychologyTemplates();
     void initializePersonalityData();
+    void onTemplatesReloaded(const TemplateSet& previous, const TemplateSet& current);
+    
+    // Question bank and background generation helpers
+    QuizQuestion generateFreshQuestion(const std::string& category, const std::string& difficulty,
+                                       const GenerationParams& params,
+                                       std::optional<uint64_t> seed = std::nullopt);
+    int scoreQuizResponse(const std::string& response) const;
+    bool takeFromPool(const std::string& category, const std::string& difficulty,
+                      const std::string& playerName, QuizQuestion& question);
+    size_t poolSize(const std::string& category, const std::string& difficulty) const;
+    bool isBankable(const QuizQuestion& question) const;
+    bool bankIfNovel(const QuizQuestion& question);
+    bool sampleUnseen(const std::string& category, const std::string& difficulty,
+                      const std::string& playerName, QuizQuestion& question);
+    bool sampleByTopic(const std::string& topic, const std::string& category, const std::string& difficulty,
+                       const std::string& playerName, QuizQuestion& question);
+    bool embedText(const std::string& text, std::vector<float>& embedding);
+    bool topicEmbedding(const std::string& topic, std::vector<float>& embedding);
+    void recordServed(const std::string& playerName, const QuizQuestion& question);
+    static bool isTrackedPlayer(const std::string& playerName);
+    void requestBackgroundGeneration(const std::string& category, const std::string& difficulty);
+    bool needsBackgroundGeneration(const std::string& category, const std::string& difficulty) const;
+    void backgroundGenerationLoop();
+    void stopBackgroundWorker();
     
     // Generation methods
-    std::string buildPrompt(const std::string& category, const std::string& difficulty) const;
-    std::string buildPsychologyPrompt(const std::string& trait, const std::string& category) const;
+    // Return the template prompt, appending its stop sequences to `stops` when given
+    std::string buildPrompt(const std::string& category, const std::string& difficulty,
+                            std::vector<std::string>* stops = nullptr) const;
+    std::string buildPsychologyPrompt(const std::string& trait, const std::string& category,
+                                      std::vector<std::string>* stops = nullptr) const;
     
     QuizQuestion parseAIResponse(const std::string& response, 
                                 const std::string& category, 
-                                const std::string& difficulty);
+                                const std::string& difficulty,
+                                std::mt19937_64& rng);
+    void applyDifficultyModifiers(QuizQuestion& question) const;
     
     PsychologicalQuestion parsePsychologyResponse(const std::string& response,
                                                  int questionId,
@@ -135,41 +336,144 @@ private:
     // Response parsing helpers
     std::string extractQuestion(const std::string& text) const;
     std::vector<std::string> extractAnswers(const std::string& text) const;
+    std::vector<std::string> extractRawAnswers(const std::string& text) const;
     std::vector<std::string> extractPsychologyOptions(const std::string& text) const;
-    int extractCorrectAnswer(const std::string& text) const;
+    int extractCorrectAnswer(const std::string& text, std::mt19937_64& rng) const;
     
     // Personality analysis helpers
     std::unordered_map<std::string, double> calculateTraitScores(const std::vector<PersonalityAnswer>& answers) const;
     std::string determinePersonalityType(const std::unordered_map<std::string, double>& scores) const;
     std::string generatePersonalityDescription(const std::string& personalityType, 
-                                              const std::unordered_map<std::string, double>& scores);
+                                              const std::unordered_map<std::string, double>& scores,
+                                              uint64_t seed, std::string& source);
     std::vector<std::string> generateStrengthsAndGrowthAreas(const std::string& personalityType, bool isStrengths);
+    // Fills in title, description, source, strengths and growth areas for result.personalityType
+    void describePersonalityType(PersonalityResult& result, std::optional<uint64_t> seed);
 
 public:
     AIQuizGenerator(const std::string& quizModelPath = "models/distilgpt2-quiz.Q2_K.gguf",
                    const std::string& psychologyModelPath = "models/distilgpt2-psychology.Q2_K.gguf",
                    const std::string& analysisModelPath = "models/distilgpt2-analysis.Q2_K.gguf");
+    explicit AIQuizGenerator(const ModelZooConfig& zoo);
     ~AIQuizGenerator();
     
-    // Main generation functions
+    // Main generation functions. With a seed (per call or global), output
+    // depends only on the inputs, model and generation settings. Without
+    // params the role's current defaults are used. A topic (free text or a
+    // subcategory) is answered from the embedding index when it has a match
     QuizQuestion generateQuestion(const std::string& category = "Science",
                                 const std::string& difficulty = "Medium",
-                                const std::string& playerName = "Unknown");
+                                const std::string& playerName = "Unknown",
+                                std::optional<uint64_t> seed = std::nullopt,
+                                const std::optional<GenerationParams>& params = std::nullopt,
+                                const std::string& topic = "");
     
     // Psychology assessment functions
-    std::vector<PsychologicalQuestion> generatePsychologyQuestions(int count = 8);
-    PersonalityResult analyzePersonality(const std::vector<PersonalityAnswer>& answers);
+    std::vector<PsychologicalQuestion> generatePsychologyQuestions(int count = 8,
+                                                                   std::optional<uint64_t> seed = std::nullopt,
+                                                                   const std::optional<GenerationParams>& params = std::nullopt);
+    PersonalityResult analyzePersonality(const std::vector<PersonalityAnswer>& answers,
+                                         std::optional<uint64_t> seed = std::nullopt);
+    // Many questionnaires at once: one scoring pass over all of them, then at
+    // most one description per distinct type (16 for MBTI). Scores match
+    // analyzePersonality() for the same answers
+    PersonalityBatchResult analyzePersonalityBatch(const std::vector<std::vector<PersonalityAnswer>>& answerSets,
+                                                   std::optional<uint64_t> seed = std::nullopt);
     
     // Model management
     bool areModelsLoaded() const;
     bool reloadModels();
     std::vector<std::string> getLoadedModels() const;
+    std::vector<std::string> getModelNames() const; // As configured, in zoo order
+    std::string getModelName(GenerationRole task) const; // The model a task's catch-all route picks
+    
+    // Quality gating and reproducibility
+    void setCandidatesPerQuestion(int count);
+    void setSeed(std::optional<uint64_t> seed);
+    void getQualityStats(int& candidates, int& rejected, int& fallbacks,
+                         int& poolHits, double& fallbackRate) const;
+    
+    // Inference threads: replaces the threadpools and moves every context
+    // onto the new ones, each once it is not decoding
+    bool setThreadPoolConfig(const ThreadPoolConfig& config, std::string& error);
+    
+    // LoRA adapters: swaps a zoo model's adapters without reloading its base
+    // weights. The new ones load on the model's next use; its prompt KV cache
+    // is dropped, and cached generations are keyed by adapter
+    bool setModelAdapters(const std::string& modelName, const std::vector<LoraAdapterSpec>& adapters,
+                          std::string& error);
+    std::vector<ModelAdapterState> getModelAdapters() const;
+    
+    // Auto-tuning (before serving requests): each model's threads, n_batch
+    // and n_ubatch are looked up in the tuning cache, or measured and
+    // cached, and its context is recreated with them
+    bool enableAutoTune(const AutoTuneConfig& config);
+    
+    // Load shedding
+    void setLatencySlo(int milliseconds);
+    void getSheddingStats(int& shed, int& sloMs, int& quizWaitMs) const;
     
-    // Configuration
+    // Prefill chunking: prompts are prefilled in chunks of about this many
+    // milliseconds, between the decode steps of other models
+    void setPrefillLatencyTarget(int milliseconds);
+    
+    // Shutdown, in order: beginShutdown stops background work while requests
+    // still drain, cancelGeneration cuts off decodes still running at the
+    // drain deadline, and shutdown persists the bank, cache and prompt KV
+    // state. Each is idempotent; the destructor calls shutdown()
+    void beginShutdown();
+    void cancelGeneration();
+    void shutdown();
+    
+    // Periodic upkeep, run by the supervisor: top up the ready pools, expire
+    // player histories and sync the on-disk caches, and release the contexts
+    // of models unused for idleTimeout
+    void refillPools();
+    void runMaintenance();
+    size_t evictIdleModels(std::chrono::seconds idleTimeout);
+    
+    // Prompt KV state is restored from this directory now and saved to it on shutdown
+    bool configureStateDirectory(const std::string& directory);
+    
+    // Generation cache (configure before serving requests)
+    bool configureGenerationCache(const GenerationCacheConfig& config);
+    GenerationCache::Stats getCacheStats() const;
+    size_t getCacheCapacity() const;
+    
+    // Question bank (enable before serving requests)
+    bool enableQuestionBank(const QuestionBankConfig& config);
+    bool flushQuestionBank();
+    void getBankStats(size_t& totalEntries, int& hits, int& appended, int& duplicates) const;
+    
+    // Embedding index over the bank (enable after the bank). Banked questions
+    // are embedded incrementally by indexBankedQuestions, run periodically
+    bool enableEmbeddingIndex(const EmbeddingIndexConfig& config);
+    bool isEmbeddingIndexEnabled() const;
+    size_t indexBankedQuestions(size_t maxQuestions);
+    // Nearest banked questions to a topic; empty category/difficulty match any
+    std::vector<std::pair<QuizQuestion, float>> searchQuestions(const std::string& topic, const std::string& category,
+                                                                const std::string& difficulty, size_t limit);
+    void getEmbeddingIndexStats(size_t& entries, size_t& memoryBytes, int& topicHits) const;
+    
+    // Player history
+    void setPlayerHistoryConfig(const PlayerHistoryConfig& config);
+    void getPlayerHistoryStats(size_t& activePlayers, size_t& memoryBytes, int& exhausted) const;
+    
+    // Generation parameters: per-role defaults and the limits requests are checked against
+    std::shared_ptr<const GenerationSettings> getGenerationSettings() const;
+    bool validateGenerationParams(GenerationRole role, const GenerationParams& params, std::string& error) const;
+    bool updateGenerationSettings(const std::function<bool(GenerationSettings&, std::string&)>& edit,
+                                  std::string& error);
+    
+    // Configuration (temperature and max tokens set the defaults of every role)
     void setTemperature(float temp);
     void setMaxTokens(int tokens);
     void setContextSize(int size);
     
+    // Prompt templates (the file is watched and reloaded on change)
+    bool loadTemplates(const std::string& path, bool watch = true);
+    void setTemplatesChangedCallback(std::function<void()> callback);
+    
     // Get available categories and difficulties
     std::vector<std::string> getCategories() const;
     std::vector<std::string> getDifficulties() const;
@@ -187,6 +491,8 @@ public:
     // Model information
     std::string getModelInfo() const;
     size_t getModelMemoryUsage() const;
+    // ggml's CPU features and the backend variant it loaded
+    std::string getBackendInfo() const;
 };
 
 #endif // AI_QUIZ_GENERATOR_H
\ No newline at end of file
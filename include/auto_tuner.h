@@ -0,0 +1,61 @@
+#ifndef AUTO_TUNER_H
+#define AUTO_TUNER_H
+
+#include "model_bench.h"
+#include <string>
+#include <vector>
+#include <map>
+#include <mutex>
+
+struct llama_model;
+
+// The context settings measured fastest for one model on one kind of host
+struct TunedSettings {
+    int threads = 0;    // Most threads a decode uses
+    int batchSize = 0;  // n_batch: most prompt tokens per llama_decode
+    int ubatchSize = 0; // n_ubatch: tokens per compute graph
+    double prefillTokensPerSec = 0.0;
+    double decodeTokensPerSec = 0.0;
+};
+
+struct AutoTuneConfig {
+    std::string cachePath;                  // Winners are kept here across restarts
+    bool retune = false;                    // Measure again even when cached
+    std::vector<int> threadCounts;          // Empty: a quarter, half and all of the CPU limit
+    std::vector<int> batchSizes = {128, 512};
+    std::vector<int> ubatchSizes = {64, 128, 512};
+    size_t prompts = 4;                     // Prompt templates prefilled per point
+    int decodeTokens = 16;                  // Tokens decoded after each
+    int contextSize = 1024;                 // Of the measured contexts; the generator uses its own
+};
+
+// Picks n_threads, n_batch and n_ubatch per model by measuring a small grid
+// with ModelBench, and caches the winners in a JSON file keyed by CPU model,
+// CPU limit and model file, so later starts on the same kind of node apply
+// them without measuring.
+//
+// The winner is the point with the lowest estimated request time: an average
+// prompt's prefill plus a full default-length decode.
+class AutoTuner {
+public:
+    explicit AutoTuner(const AutoTuneConfig& config);
+
+    // Cached settings for the model loaded from path, or measured now and
+    // cached. False when nothing could be measured
+    bool tune(llama_model* model, const std::string& path, const std::vector<std::string>& prompts,
+              TunedSettings& settings);
+
+    // "<CPU model> x<CPU limit>" and a fingerprint of a model file
+    static std::string hostKey();
+    static std::string modelKey(const std::string& path);
+
+private:
+    bool load();
+    bool save() const; // Caller holds mutex
+
+    AutoTuneConfig config;
+    std::mutex mutex;
+    std::map<std::string, TunedSettings> entries; // By "<host key>|<model key>"
+};
+
+#endif // AUTO_TUNER_H
@@ -0,0 +1,89 @@
+#ifndef EMBEDDING_INDEX_H
+#define EMBEDDING_INDEX_H
+
+#include "record_log.h"
+#include <string>
+#include <vector>
+#include <unordered_set>
+#include <unordered_map>
+#include <shared_mutex>
+#include <cstdint>
+
+struct EmbeddingIndexConfig {
+    std::string path;            // Persist vectors to <path>.log; empty keeps them in memory only
+    std::string modelPath;       // GGUF to embed with; empty reuses the quiz model's weights
+    float minSimilarity = 0.35f; // Cosine similarity a question needs to count as on-topic
+};
+
+// Nearest-neighbour search over question embeddings.
+//
+// Vectors are L2-normalized and stored int8-quantized with one scale per
+// row, a quarter of their float size, in a flat row-major array. A query is
+// quantized the same way and scored against every candidate row with
+// integer dot products (simd_kernels.h). Rows carry the id (bank log offset)
+// and key ((category, difficulty) hash) of their question and are listed per key, so
+// a search within a key scans only its few hundred rows, well under a
+// millisecond; an unfiltered search scans them all. With a path set, every
+// row is also appended to a RecordLog that is replayed on open(); vectors
+// from a different model are discarded, so questions are re-embedded only
+// when the model changes.
+class EmbeddingIndex {
+public:
+    struct Match {
+        uint64_t id;
+        uint32_t key;
+        float similarity;
+    };
+
+    EmbeddingIndex() = default;
+    ~EmbeddingIndex();
+
+    EmbeddingIndex(const EmbeddingIndex&) = delete;
+    EmbeddingIndex& operator=(const EmbeddingIndex&) = delete;
+
+    // modelTag identifies the embedding model; persisted rows with another tag are dropped
+    bool open(const std::string& path, size_t dimensions, uint64_t modelTag);
+    void close();
+
+    bool add(uint64_t id, uint32_t key, const std::vector<float>& embedding);
+    bool contains(uint64_t id) const;
+
+    // Up to k rows most similar to query, best first. With keys given, only
+    // rows with one of them are considered
+    std::vector<Match> search(const std::vector<float>& query, size_t k,
+                              const std::vector<uint32_t>& keys = {}, float minSimilarity = -1.0f) const;
+
+    bool flush();
+
+    size_t size() const;
+    size_t dimensions() const { return dims; }
+    size_t memoryBytes() const;
+
+    static void normalize(std::vector<float>& vector);
+
+private:
+    size_t dims = 0;
+    uint64_t tag = 0;
+
+    std::vector<int8_t> codes; // size() * dims quantized components
+    std::vector<float> scales; // Per row: component = code * scale
+    std::vector<uint64_t> ids;
+    std::vector<uint32_t> keys;
+    std::unordered_map<uint32_t, std::vector<uint32_t>> rowsByKey;
+    std::unordered_set<uint64_t> idSet;
+    mutable std::shared_mutex mutex;
+
+    RecordLog log;
+
+    // Caller holds mutex exclusively
+    void insertLocked(uint64_t id, uint32_t key, const int8_t* rowCodes, float scale);
+    void clearLocked();
+
+    // Caller holds mutex, shared or exclusively
+    float similarityLocked(size_t row, const int8_t* queryCodes, float queryScale) const;
+
+    static float quantize(const std::vector<float>& vector, std::vector<int8_t>& out);
+    std::string serialize(uint64_t id, uint32_t key, const int8_t* rowCodes, float scale) const;
+};
+
+#endif // EMBEDDING_INDEX_H
@@ -0,0 +1,98 @@
+#ifndef GENERATION_CACHE_H
+#define GENERATION_CACHE_H
+
+#include "record_log.h"
+#include "generation_params.h"
+#include <string>
+#include <string_view>
+#include <vector>
+#include <list>
+#include <array>
+#include <unordered_map>
+#include <mutex>
+#include <atomic>
+#include <cstdint>
+
+struct GenerationCacheConfig {
+    size_t maxBytes = 32 * 1024 * 1024; // Total budget across shards; 0 disables the cache
+    std::string path;                   // Persist entries to <path>.log; empty keeps them in memory only
+};
+
+// Memoizes deterministic model output.
+//
+// Seeded generation is a pure function of (model, prompt, sampling
+// parameters, seed), so its result can be reused instead of decoded again.
+// Entries are spread over lock-striped shards, each an LRU list bounded by
+// its share of maxBytes. With a path set, every insertion is also appended
+// to a RecordLog that is replayed (and compacted) on open(), so the cache
+// survives restarts.
+class GenerationCache {
+public:
+    struct Stats {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t insertions = 0;
+        uint64_t evictions = 0;
+        size_t entries = 0;
+        size_t bytes = 0;
+    };
+
+    explicit GenerationCache(const GenerationCacheConfig& config = GenerationCacheConfig());
+
+    GenerationCache(const GenerationCache&) = delete;
+    GenerationCache& operator=(const GenerationCache&) = delete;
+
+    // Load persisted entries; a no-op for memory-only caches
+    bool open();
+    void close();
+
+    bool get(const std::string& key, std::vector<std::string>& value);
+    void put(const std::string& key, const std::vector<std::string>& value);
+
+    // Sync the backing log, compacting it first once it has grown well past the live entries
+    bool flush();
+
+    bool isEnabled() const { return config.maxBytes > 0; }
+    Stats getStats() const;
+    const GenerationCacheConfig& getConfig() const { return config; }
+
+    static std::string makeKey(const std::string& model, const std::string& prompt, int count,
+                               const GenerationParams& params, uint64_t seed);
+
+private:
+    static constexpr int kShards = 16;
+
+    struct Entry {
+        std::string key;
+        std::vector<std::string> value;
+        size_t bytes;
+    };
+
+    struct Shard {
+        mutable std::mutex mutex;
+        std::list<Entry> lru; // Most recently used first
+        std::unordered_map<std::string_view, std::list<Entry>::iterator> index;
+        size_t bytes = 0;
+    };
+
+    GenerationCacheConfig config;
+    std::array<Shard, kShards> shards;
+
+    RecordLog log;
+    std::mutex logMutex;
+
+    std::atomic<uint64_t> hits{0};
+    std::atomic<uint64_t> misses{0};
+    std::atomic<uint64_t> insertions{0};
+    std::atomic<uint64_t> evictions{0};
+
+    Shard& shardFor(const std::string& key);
+    bool insert(const std::string& key, const std::vector<std::string>& value);
+    bool compact();
+
+    static size_t entryBytes(const std::string& key, const std::vector<std::string>& value);
+    static std::string serialize(const std::string& key, const std::vector<std::string>& value);
+    static bool deserialize(const std::string& payload, std::string& key, std::vector<std::string>& value);
+};
+
+#endif // GENERATION_CACHE_H
@@ -0,0 +1,61 @@
+#ifndef GENERATION_PARAMS_H
+#define GENERATION_PARAMS_H
+
+#include <string>
+#include <vector>
+#include <array>
+#include <cstddef>
+
+// Which model a generation runs on; each has its own defaults and limits
+enum class GenerationRole {
+    Quiz,
+    Psychology,
+    Analysis
+};
+
+constexpr size_t kGenerationRoleCount = 3;
+
+struct GenerationParams {
+    int maxTokens = 128;
+    float temperature = 0.7f;      // 0 samples greedily
+    int topK = 0;                  // 0 keeps the whole vocabulary
+    float topP = 1.0f;             // 1 disables nucleus filtering
+    std::vector<std::string> stop; // Output ends before the first occurrence of any of these
+
+    bool operator==(const GenerationParams& other) const {
+        return maxTokens == other.maxTokens && temperature == other.temperature &&
+               topK == other.topK && topP == other.topP && stop == other.stop;
+    }
+    bool operator!=(const GenerationParams& other) const { return !(*this == other); }
+};
+
+// Bounds a request may choose parameters within
+struct GenerationLimits {
+    int maxTokens = 256;
+    float maxTemperature = 1.5f;
+    int maxTopK = 1000;
+    size_t maxStopSequences = 4;
+    size_t maxStopLength = 32;
+};
+
+struct RoleGenerationSettings {
+    GenerationParams defaults;
+    GenerationLimits limits;
+};
+
+// Defaults and limits for every role. Published as one immutable snapshot,
+// so a reader never sees half of an update
+struct GenerationSettings {
+    std::array<RoleGenerationSettings, kGenerationRoleCount> roles;
+
+    const RoleGenerationSettings& forRole(GenerationRole role) const { return roles[static_cast<size_t>(role)]; }
+    RoleGenerationSettings& forRole(GenerationRole role) { return roles[static_cast<size_t>(role)]; }
+};
+
+const char* generationRoleName(GenerationRole role);
+bool parseGenerationRole(const std::string& name, GenerationRole& role);
+
+bool validateGenerationLimits(const GenerationLimits& limits, std::string& error);
+bool validateGenerationParams(const GenerationParams& params, const GenerationLimits& limits, std::string& error);
+
+#endif // GENERATION_PARAMS_H
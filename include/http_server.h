@@ -3,11 +3,16 @@
 
 #include "httplib.h"
 #include "ai_quiz_generator.h"
+#include "response_compressor.h"
 #include <jsoncpp/json/json.h>
 #include <memory>
 #include <string>
 #include <chrono>
 #include <atomic>
+#include <optional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 
 class HttpServer {
 private:
@@ -18,49 +23,93 @@ private:
     std::string host;
     int port;
     
+    // Listener thread; it returns once stopped and every accepted connection is served
+    std::thread listenerThread;
+    std::mutex listenerMutex;
+    std::condition_variable listenerCv;
+    bool listenerDone = false;
+    std::atomic<bool> shuttingDown{false};
+    
     // Statistics
     std::atomic<int> totalRequests{0};
     std::atomic<int> successfulGenerations{0};
     std::atomic<int> failedGenerations{0};
     std::chrono::steady_clock::time_point startTime;
     
+    // Response compression and catalog bodies compressed once at startup
+    ResponseCompressor compressor;
+    std::shared_ptr<const PrecompressedBody> categoriesBody;
+    std::shared_ptr<const PrecompressedBody> traitsBody;
+    std::atomic<bool> catalogModelLoaded{false}; // The model state the catalog bodies report
+    
+    // Required in X-Admin-Token for /api/admin/*; when empty, only loopback clients are admitted
+    std::string adminToken;
+    
     // Request handlers
     void setupRoutes();
     void handleHealthCheck(const httplib::Request& req, httplib::Response& res);
     void handleGenerateQuiz(const httplib::Request& req, httplib::Response& res);
     void handleGetCategories(const httplib::Request& req, httplib::Response& res);
+    void handleSearchQuestions(const httplib::Request& req, httplib::Response& res);
     void handleGetStats(const httplib::Request& req, httplib::Response& res);
     void handleGetModelInfo(const httplib::Request& req, httplib::Response& res);
     
     // Psychology handlers
     void handleGeneratePsychologyQuestions(const httplib::Request& req, httplib::Response& res);
     void handleAnalyzePersonality(const httplib::Request& req, httplib::Response& res);
+    void handleAnalyzePersonalityBatch(const httplib::Request& req, httplib::Response& res);
     void handleGetPersonalityTraits(const httplib::Request& req, httplib::Response& res);
     
+    // Admin handlers
+    void handleGetGenerationSettings(const httplib::Request& req, httplib::Response& res);
+    void handleUpdateGenerationSettings(const httplib::Request& req, httplib::Response& res);
+    void handleGetAdapters(const httplib::Request& req, httplib::Response& res);
+    void handleUpdateAdapters(const httplib::Request& req, httplib::Response& res);
+    bool authorizeAdmin(const httplib::Request& req, httplib::Response& res) const;
+    
     // Utility functions
     Json::Value questionToJson(const QuizQuestion& question) const;
     std::string getCurrentTimestamp() const;
     void setCORSHeaders(httplib::Response& res) const;
     bool parseJsonRequest(const std::string& body, Json::Value& json) const;
+    bool parseSeed(const Json::Value& json, std::optional<uint64_t>& seed) const;
+    bool parseGenerationParams(const Json::Value& json, GenerationRole role,
+                               std::optional<GenerationParams>& params, std::string& error) const;
+    bool applyGenerationParams(const Json::Value& json, GenerationParams& params, std::string& error) const;
+    bool applyGenerationLimits(const Json::Value& json, GenerationLimits& limits, std::string& error) const;
+    Json::Value generationSettingsToJson(const GenerationSettings& settings) const;
+    Json::Value adaptersToJson() const;
+    std::string serializeJson(const Json::Value& data) const;
+    void rebuildCatalogBodies();
+    std::shared_ptr<const PrecompressedBody> currentCatalogBody(const std::shared_ptr<const PrecompressedBody>& body);
     
     // Error handling
     void sendErrorResponse(httplib::Response& res, int code, 
                           const std::string& message) const;
-    void sendSuccessResponse(httplib::Response& res, 
+    void sendSuccessResponse(const httplib::Request& req, httplib::Response& res, 
                            const Json::Value& data) const;
+    void sendPrecompressedResponse(const httplib::Request& req, httplib::Response& res,
+                                   const PrecompressedBody& body) const;
 
 public:
     HttpServer(const std::string& host = "0.0.0.0", int port = 8080,
                const std::string& modelPath = "models/distilgpt2.Q4_K_M.gguf");
-    ~HttpServer() = default;
+    HttpServer(const std::string& host, int port, const ModelZooConfig& zoo);
+    ~HttpServer();
     
     // Server control
     bool start();
     void stop();
     
+    // Graceful stop: refuse new connections, let accepted requests finish
+    // (cancelling generation still running at the deadline), then persist
+    // generator state. Idempotent
+    void shutdown(std::chrono::milliseconds drainTimeout);
+    
     // Configuration
     void setHost(const std::string& newHost);
     void setPort(int newPort);
+    void setCompressionConfig(const CompressionConfig& config);
     
     // Status
     bool isRunning() const;
@@ -73,6 +122,25 @@ public:
     bool isAIModelLoaded() const;
     bool reloadAIModel();
     bool isModelLoading() const;
+    bool enableQuestionBank(const QuestionBankConfig& config);
+    bool enableEmbeddingIndex(const EmbeddingIndexConfig& config);
+    void setPlayerHistoryConfig(const PlayerHistoryConfig& config);
+    void setCandidatesPerQuestion(int count);
+    void setSeed(std::optional<uint64_t> seed);
+    void setLatencySlo(int milliseconds);
+    void setPrefillLatencyTarget(int milliseconds);
+    bool setThreadPoolConfig(const ThreadPoolConfig& config, std::string& error);
+    bool configureGenerationCache(const GenerationCacheConfig& config);
+    bool loadTemplates(const std::string& path);
+    bool configureStateDirectory(const std::string& directory);
+    bool enableAutoTune(const AutoTuneConfig& config);
+    
+    // Periodic upkeep, scheduled by the supervisor
+    void refillPools();
+    size_t indexBankedQuestions(size_t maxQuestions);
+    void runMaintenance();
+    size_t evictIdleModels(std::chrono::seconds idleTimeout);
+    void setAdminToken(const std::string& token);
 };
 
 #endif // HTTP_SERVER_H
\ No newline at end of file
@@ -0,0 +1,90 @@
+#ifndef INFERENCE_POOLS_H
+#define INFERENCE_POOLS_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+
+struct ggml_threadpool;
+struct llama_context;
+
+struct ThreadPoolConfig {
+    int pools = 1;                   // Pools the contexts are spread over, round-robin
+    int threads = 0;                 // Per pool; 0 splits the CPU limit between the pools
+    int poll = 50;                   // How long idle workers spin before sleeping: 0 (not at all) .. 100
+    std::string priority = "normal"; // Worker priority: normal, medium, high or realtime
+    bool strictCpu = false;          // Pin each worker to its own CPU
+
+    static bool parsePriority(const std::string& name, int& priority);
+};
+
+// One ggml CPU threadpool. The contexts attached to it take turns: a context
+// holds a Turn for each llama_decode, so two models never run their graphs
+// on the same workers at once, and never more workers than CPUs.
+//
+// Decode steps (one token per sequence) go before prefill chunks that are
+// waiting, so a long prompt on one model delays the next token of the others
+// by about one chunk rather than its whole prefill. A chunk yields for at
+// most its maxYield, so steady decoding cannot starve it.
+struct InferencePool {
+    enum class Work { Step, Prefill };
+
+    class Turn {
+    public:
+        Turn(InferencePool& pool, Work work, std::chrono::milliseconds maxYield = std::chrono::milliseconds(0));
+        ~Turn();
+        Turn(const Turn&) = delete;
+        Turn& operator=(const Turn&) = delete;
+
+    private:
+        InferencePool& pool;
+    };
+
+    ggml_threadpool* threadpool = nullptr;
+    int threads = 0;
+
+    ~InferencePool();
+
+private:
+    std::mutex mutex;
+    std::condition_variable released;
+    bool busy = false;
+    int waitingSteps = 0;
+};
+
+// The server's inference threads. Without explicit pools every llama context
+// starts its own workers, and contexts decoding side by side oversubscribe
+// the CPUs with spinning threads; here all contexts share a few long-lived
+// pools instead.
+//
+// Pools are created on first use, after the CPU backend is loaded (with
+// GGML_BACKEND_DL the threadpool API is looked up through the backend
+// registry). When that fails, contexts keep their own threads.
+class InferencePools {
+public:
+    // Replaces the pools; contexts move to the new ones when reattached. An
+    // invalid config is rejected and the current pools stay
+    bool configure(const ThreadPoolConfig& config, std::string& error);
+    ThreadPoolConfig getConfig() const;
+
+    // The pool for the next context, or null when pools are unavailable
+    std::shared_ptr<InferencePool> assign();
+
+    // Run context on pool (null detaches it back to its own threads), on at
+    // most maxThreads of its workers when set
+    static void attach(llama_context* context, const std::shared_ptr<InferencePool>& pool, int maxThreads = 0);
+
+private:
+    bool createPools(); // Caller holds mutex
+
+    mutable std::mutex mutex;
+    ThreadPoolConfig config;
+    std::vector<std::shared_ptr<InferencePool>> pools;
+    size_t next = 0;
+    bool unavailable = false; // The backend has no threadpool API
+};
+
+#endif // INFERENCE_POOLS_H
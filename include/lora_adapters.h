@@ -0,0 +1,48 @@
+#ifndef LORA_ADAPTERS_H
+#define LORA_ADAPTERS_H
+
+#include "model_zoo.h"
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <map>
+#include <utility>
+
+struct llama_adapter_lora;
+struct llama_model;
+struct llama_context;
+
+// A loaded adapter. It keeps its base weights alive: llama.cpp frees an
+// adapter's tensors with the model, so the model must outlive it
+struct LoraAdapter {
+    llama_adapter_lora* adapter = nullptr;
+    std::shared_ptr<llama_model> weights;
+    std::string path;
+
+    ~LoraAdapter();
+};
+
+// Adapters loaded so far, one per (base weights, adapter file). An adapter is
+// loaded when a context first needs it, shared by every context on the same
+// weights, and freed when the last one drops it, so configured but unused
+// specializations cost nothing.
+//
+// llama.cpp applies adapters per context, not per sequence: every sequence
+// of a context decodes with the same adapters.
+class LoraAdapterCache {
+public:
+    std::shared_ptr<LoraAdapter> get(const std::shared_ptr<llama_model>& weights, const std::string& path,
+                                     std::string& error);
+
+    // Replaces context's adapters. Both lists run in parallel (adapter i at
+    // specs[i].scale); the caller keeps the adapters while the context uses them
+    static void apply(llama_context* context, const std::vector<std::shared_ptr<LoraAdapter>>& adapters,
+                      const std::vector<LoraAdapterSpec>& specs);
+
+private:
+    std::mutex mutex;
+    std::map<std::pair<const llama_model*, std::string>, std::weak_ptr<LoraAdapter>> adapters;
+};
+
+#endif // LORA_ADAPTERS_H
@@ -0,0 +1,63 @@
+#ifndef MODEL_BENCH_H
+#define MODEL_BENCH_H
+
+#include "model_zoo.h"
+#include <string>
+#include <vector>
+#include <ostream>
+#include <cstddef>
+
+struct llama_model;
+
+struct BenchConfig {
+    std::vector<int> threadCounts;              // Empty: the server's per-model share and every core
+    std::vector<int> batchSizes = {32, 128, 512};
+    std::vector<int> ubatchSizes;               // Empty: each batch size as its own ubatch
+    int decodeTokens = 64;                      // Sampled after each prompt
+    int contextSize = 1024;
+};
+
+// One model measured at one (threads, batch, ubatch) point, summed over every prompt
+struct BenchResult {
+    std::string model;
+    int threads = 0;
+    int batchSize = 0;
+    int ubatchSize = 0;
+    size_t promptTokens = 0;
+    double prefillTokensPerSec = 0.0;
+    size_t decodedTokens = 0;
+    double decodeTokensPerSec = 0.0; // Model time only; sampling is reported separately
+    double samplerUsPerToken = 0.0;
+    size_t contextBytes = 0;         // Resident memory the context added
+};
+
+// Raw model throughput, measured without the HTTP server.
+//
+// Each distinct model file in the zoo is loaded once. For every batch size
+// (and each ubatch size no larger) a fresh context is created, and for every
+// thread count each prompt is
+// prefilled in batch-sized chunks and followed by decodeTokens single-token
+// decodes through the server's own sampler, so the numbers match what a
+// request would see. Progress goes to stderr, leaving stdout for the report.
+class ModelBench {
+public:
+    explicit ModelBench(const BenchConfig& config);
+
+    // Empty when no model could be loaded
+    std::vector<BenchResult> run(const ModelZooConfig& zoo, const std::vector<std::string>& prompts);
+
+    // Measures weights that are already loaded (the backend is initialized)
+    bool benchWeights(llama_model* model, const std::string& name, const std::vector<std::string>& prompts,
+                      std::vector<BenchResult>& results);
+
+    static void printTable(const std::vector<BenchResult>& results, std::ostream& out);
+    static std::string toJson(const std::vector<BenchResult>& results);
+
+private:
+    BenchConfig config;
+
+    bool benchModel(const std::string& name, const std::string& path, const std::vector<std::string>& prompts,
+                    std::vector<BenchResult>& results);
+};
+
+#endif // MODEL_BENCH_H
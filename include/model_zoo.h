@@ -0,0 +1,60 @@
+#ifndef MODEL_ZOO_H
+#define MODEL_ZOO_H
+
+#include "generation_params.h"
+#include <string>
+#include <vector>
+#include <optional>
+
+namespace Json {
+class Value;
+}
+
+// A LoRA adapter on top of a model's weights. Scale weighs its delta (1:
+// as trained, 0: off, negative: subtracted)
+struct LoraAdapterSpec {
+    std::string path;
+    float scale = 1.0f;
+};
+
+struct ModelSpec {
+    std::string name; // Unique; names the model in logs, stats and cache keys
+    std::string path; // Base weights; models with the same path share them
+    std::vector<LoraAdapterSpec> adapters; // Applied to this model's context only
+};
+
+// Sends matching requests to a model; unset fields match anything
+struct ModelRoute {
+    std::optional<GenerationRole> task;
+    std::string category;   // Quiz category, psychology category or personality type
+    std::string difficulty; // Quiz only
+    size_t model = 0;       // Index into ModelZooConfig::models
+};
+
+// Which model serves each (task, category, difficulty).
+//
+// Routes are tried in order and the first match wins, so specific rules go
+// before general ones. Every task must have a route that matches any request,
+// so a request can never go unrouted.
+//
+// Specializations need not be separate model files: several models can name
+// one base file, each with its own adapters, and cost one set of weights plus
+// a few MB per adapter.
+struct ModelZooConfig {
+    std::vector<ModelSpec> models;
+    std::vector<ModelRoute> routes;
+
+    // Index into models, or -1 when no route matches
+    int resolve(GenerationRole task, const std::string& category, const std::string& difficulty) const;
+
+    // The classic layout: one model per task
+    static ModelZooConfig forRoles(const std::string& quizPath, const std::string& psychologyPath,
+                                   const std::string& analysisPath);
+
+    static bool parse(const std::string& json, ModelZooConfig& config, std::string& error);
+    // An adapter list: each entry a path or {"path": ..., "scale": ...}
+    static bool parseAdapters(const Json::Value& json, std::vector<LoraAdapterSpec>& adapters, std::string& error);
+    static bool load(const std::string& path, ModelZooConfig& config, std::string& error);
+};
+
+#endif // MODEL_ZOO_H
@@ -0,0 +1,48 @@
+#ifndef NEAR_DUPLICATE_INDEX_H
+#define NEAR_DUPLICATE_INDEX_H
+
+#include <string>
+#include <vector>
+#include <array>
+#include <unordered_map>
+#include <shared_mutex>
+#include <cstdint>
+
+// Near-duplicate detection for generated question text.
+//
+// Each question is reduced to a 64-bit SimHash of character shingles over
+// its normalized, stop-word-free text; two questions are near-duplicates
+// when their hashes differ in at most kMaxDistance bits. The hash is cut into kMaxDistance + 1
+// bands, so by pigeonhole any near-duplicate matches at least one band
+// exactly, and lookups only compare against that band's bucket.
+class NearDuplicateIndex {
+public:
+    static constexpr int kMaxDistance = 3;
+    static constexpr int kBands = kMaxDistance + 1;
+    static constexpr int kBandBits = 64 / kBands;
+
+    NearDuplicateIndex() = default;
+
+    static std::string normalize(const std::string& text);
+    static uint64_t simhash(const std::string& text);
+    static int distance(uint64_t a, uint64_t b);
+
+    bool containsNear(uint64_t hash) const;
+    void insert(uint64_t hash);
+
+    // Check and insert under one lock; returns false for a near-duplicate
+    bool insertIfNovel(uint64_t hash);
+
+    size_t size() const;
+
+private:
+    std::array<std::unordered_map<uint16_t, std::vector<uint64_t>>, kBands> bands;
+    size_t count = 0;
+    mutable std::shared_mutex mutex;
+
+    static uint16_t bandKey(uint64_t hash, int band);
+    bool containsNearLocked(uint64_t hash) const;
+    void insertLocked(uint64_t hash);
+};
+
+#endif // NEAR_DUPLICATE_INDEX_H
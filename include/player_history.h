@@ -0,0 +1,70 @@
+#ifndef PLAYER_HISTORY_H
+#define PLAYER_HISTORY_H
+
+#include <string>
+#include <array>
+#include <unordered_map>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+struct PlayerHistoryConfig {
+    std::chrono::seconds ttl{1800}; // Forget players idle for longer than this
+    int rotateAfter = 64;           // Questions per Bloom generation before the oldest is dropped
+};
+
+// Which questions each player has recently been shown.
+//
+// Every player gets two 512-bit Bloom filters keyed by question fingerprint:
+// inserts go to the current one, lookups check both, and once the current
+// filter holds rotateAfter questions the older one is discarded. That keeps
+// the false-positive rate bounded (about 2% per full filter at 4 hashes) and
+// lets long sessions see old questions again, in under 200 bytes per player.
+// Players idle past the TTL are evicted by sweep().
+class PlayerHistory {
+public:
+    explicit PlayerHistory(const PlayerHistoryConfig& config = PlayerHistoryConfig());
+
+    bool hasSeen(const std::string& player, uint64_t fingerprint) const;
+    void markSeen(const std::string& player, uint64_t fingerprint);
+
+    // Evict expired players from every shard; returns how many were removed
+    size_t sweep();
+
+    size_t activePlayers() const;
+    size_t approximateMemoryBytes() const;
+
+    void setConfig(const PlayerHistoryConfig& newConfig) { config = newConfig; }
+
+private:
+    static constexpr int kFilterWords = 8; // 512 bits
+    static constexpr int kHashes = 4;
+    static constexpr int kShards = 64;
+
+    struct Entry {
+        std::array<uint64_t, kFilterWords> current{};
+        std::array<uint64_t, kFilterWords> previous{};
+        uint32_t lastSeen = 0; // Seconds since the history was created
+        uint16_t currentCount = 0;
+    };
+
+    struct Shard {
+        mutable std::mutex mutex;
+        std::unordered_map<uint64_t, Entry> players;
+    };
+
+    PlayerHistoryConfig config;
+    std::array<Shard, kShards> shards;
+    std::chrono::steady_clock::time_point epoch;
+    std::atomic<uint64_t> operations{0};
+    std::atomic<size_t> playerCount{0};
+
+    uint32_t now() const;
+    size_t sweepShard(Shard& shard, uint32_t cutoff);
+    static uint64_t playerKey(const std::string& player);
+    static bool testBits(const std::array<uint64_t, kFilterWords>& filter, uint64_t fingerprint);
+    static void setBits(std::array<uint64_t, kFilterWords>& filter, uint64_t fingerprint);
+};
+
+#endif // PLAYER_HISTORY_H
@@ -0,0 +1,100 @@
+#ifndef QUESTION_BANK_H
+#define QUESTION_BANK_H
+
+#include "record_log.h"
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <shared_mutex>
+#include <random>
+#include <functional>
+#include <cstdint>
+
+struct QuizQuestion;
+
+struct QuestionBankConfig {
+    std::string path = "data/question_bank";
+    double freshness = 0.2;        // Share of requests that still go to the model once a key is stocked
+    int minEntriesToServe = 20;    // Bank only answers for a (category, difficulty) once it holds this many
+    int targetEntriesPerKey = 200; // Background growth stops at this size
+    bool syncOnAppend = false;     // fdatasync every question instead of on flush()
+};
+
+// Persistent, append-only store of generated quiz questions.
+//
+// Questions live in <path>.log (a RecordLog); <path>.idx is a memory-mapped
+// array of fixed-size entries pointing into it, grouped in memory by
+// (category, difficulty) so a random question can be picked without touching
+// the rest of the bank. The index is only a cache: if it is missing, from an
+// older version or behind the log, it is rebuilt from the log on open().
+class QuestionBank {
+private:
+    struct IndexHeader {
+        char magic[8];
+        uint32_t version;
+        uint32_t entrySize;
+        uint64_t count;
+        uint64_t logEnd; // Log offset covered by the entries below
+    };
+
+    struct IndexEntry {
+        uint64_t offset;      // Record offset in the log
+        uint64_t fingerprint; // SimHash of the question text
+        uint32_t keyHash;     // (category, difficulty)
+        uint32_t createdAt;   // Unix seconds
+    };
+
+    QuestionBankConfig config;
+    RecordLog log;
+
+    int indexFd = -1;
+    char* indexMap = nullptr;
+    size_t indexMapSize = 0;
+
+    std::unordered_map<uint32_t, std::vector<uint32_t>> entriesByKey;
+    mutable std::shared_mutex indexMutex;
+
+    IndexHeader* header() const { return reinterpret_cast<IndexHeader*>(indexMap); }
+    IndexEntry* entries() const { return reinterpret_cast<IndexEntry*>(indexMap + sizeof(IndexHeader)); }
+
+    bool openIndex(bool& rebuild);
+    bool growIndex(uint64_t minEntries);
+    void closeIndex();
+    bool addIndexEntry(uint64_t offset, const QuizQuestion& question);
+
+public:
+    explicit QuestionBank(const QuestionBankConfig& config);
+    ~QuestionBank();
+
+    QuestionBank(const QuestionBank&) = delete;
+    QuestionBank& operator=(const QuestionBank&) = delete;
+
+    bool open();
+    void close();
+
+    bool append(const QuizQuestion& question);
+    bool sample(const std::string& category, const std::string& difficulty,
+                std::mt19937_64& rng, QuizQuestion& question) const;
+
+    size_t count(const std::string& category, const std::string& difficulty) const;
+    size_t size() const;
+    void forEachFingerprint(const std::function<void(uint64_t)>& callback) const;
+    
+    // Every stored question's log offset (its stable id) and key, oldest first
+    void forEachEntry(const std::function<void(uint64_t offset, uint32_t keyHash)>& callback) const;
+    bool read(uint64_t offset, QuizQuestion& question) const;
+
+    // Push appended questions and index entries to stable storage
+    bool flush();
+
+    const QuestionBankConfig& getConfig() const { return config; }
+
+    static uint64_t fingerprint(const std::string& questionText);
+    static uint32_t keyHash(const std::string& category, const std::string& difficulty);
+
+    // A question's record payload (also how the saved question pool stores it)
+    static std::string serialize(const QuizQuestion& question);
+    static bool deserialize(const std::string& payload, QuizQuestion& question);
+};
+
+#endif // QUESTION_BANK_H
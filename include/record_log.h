@@ -0,0 +1,55 @@
+#ifndef RECORD_LOG_H
+#define RECORD_LOG_H
+
+#include <string>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <atomic>
+
+// Append-only file of checksummed, length-prefixed records.
+//
+// Every record carries a CRC32 of its payload. A record may reach the file in
+// several pwrite() calls, so a crash can leave it torn; crash safety comes
+// from the scan at open, which checks records from the last trusted offset
+// and truncates the log at the first torn or corrupt one.
+class RecordLog {
+public:
+    using RecordCallback = std::function<void(uint64_t offset, const std::string& payload)>;
+
+    RecordLog() = default;
+    ~RecordLog();
+
+    RecordLog(const RecordLog&) = delete;
+    RecordLog& operator=(const RecordLog&) = delete;
+
+    // Opens (creating if needed) the log. Records at or after verifyFrom are
+    // checksummed and reported through onRecord; earlier ones are trusted.
+    bool open(const std::string& path, uint64_t verifyFrom = 0,
+              const RecordCallback& onRecord = nullptr);
+    void close();
+
+    bool append(const std::string& payload, uint64_t& offset);
+    bool read(uint64_t offset, std::string& payload) const;
+
+    // fdatasync() the log; cheap when nothing was appended since the last call
+    bool sync();
+    void setSyncOnAppend(bool enabled) { syncOnAppend = enabled; }
+
+    bool isOpen() const { return fd >= 0; }
+    uint64_t size() const { return endOffset.load(); }
+    const std::string& getPath() const { return path; }
+
+    static uint64_t firstRecordOffset();
+    static uint32_t crc32(const char* data, size_t length);
+
+private:
+    int fd = -1;
+    std::string path;
+    std::atomic<uint64_t> endOffset{0};
+    std::atomic<bool> dirty{false};
+    bool syncOnAppend = false;
+    std::mutex appendMutex;
+};
+
+#endif // RECORD_LOG_H
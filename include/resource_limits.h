@@ -0,0 +1,37 @@
+#ifndef RESOURCE_LIMITS_H
+#define RESOURCE_LIMITS_H
+
+#include <string>
+#include <cstddef>
+
+// CPU and memory the process may actually use. In a container these are the
+// cgroup limits (v2 cpu.max / memory.max, or v1 CFS quota and
+// memory.limit_in_bytes, the tightest along the cgroup's ancestors), not the
+// host's: hardware_concurrency() reports every core of a 64-core node even
+// when the pod's quota is 4, and threads sized from it get throttled.
+struct ResourceLimits {
+    double cpus = 1.0;        // Quota / period, capped by the CPUs we may run on
+    size_t memoryBytes = 0;   // 0 when unknown
+    std::string cpuSource;    // Where the figures came from, for the startup log
+    std::string memorySource;
+
+    // Whole CPUs we can keep busy without being throttled, at least 1
+    int cpuCount() const;
+
+    // Threads for each of `contexts` llama contexts decoding side by side
+    int threadsPerContext(int contexts) const;
+
+    // HTTP workers: enough to keep idle keep-alive connections from starving
+    // new ones, but not one per host core
+    int httpWorkers() const;
+
+    // Default generation cache budget: 32 MB, or 2% of a smaller memory limit
+    size_t generationCacheBytes() const;
+
+    // Read from /proc and /sys/fs/cgroup on the first call; limits changed
+    // later (a resized pod) take effect at the next start
+    static const ResourceLimits& current();
+    static ResourceLimits detect();
+};
+
+#endif // RESOURCE_LIMITS_H
@@ -0,0 +1,60 @@
+#ifndef RESPONSE_COMPRESSOR_H
+#define RESPONSE_COMPRESSOR_H
+
+#include <string>
+#include <vector>
+#include <cstddef>
+
+// Content codings we can produce. Which ones are actually available depends on
+// the AEON_*_SUPPORT flags the build was configured with.
+enum class ContentEncoding {
+    Identity,
+    Gzip,
+    Brotli,
+    Zstd
+};
+
+struct CompressionConfig {
+    bool enabled = true;
+    size_t minSize = 1024; // Bodies smaller than this are sent as-is
+    int level = 6;         // 1 (fastest) .. 9 (smallest), mapped onto each codec
+};
+
+// A response body compressed once for every available coding, used for
+// endpoints whose payload does not change between requests.
+struct PrecompressedBody {
+    std::string identity;
+    std::string gzip;
+    std::string brotli;
+    std::string zstd;
+
+    const std::string& forEncoding(ContentEncoding encoding) const;
+};
+
+class ResponseCompressor {
+private:
+    CompressionConfig config;
+
+    bool compressGzip(const std::string& input, std::string& output) const;
+    bool compressBrotli(const std::string& input, std::string& output) const;
+    bool compressZstd(const std::string& input, std::string& output) const;
+
+public:
+    explicit ResponseCompressor(const CompressionConfig& config = CompressionConfig());
+
+    // Pick the best coding we support from an Accept-Encoding header value.
+    ContentEncoding negotiate(const std::string& acceptEncoding) const;
+
+    // Returns false (leaving output untouched) when the body is below the size
+    // threshold, compression is disabled or the codec failed.
+    bool compress(const std::string& input, ContentEncoding encoding, std::string& output) const;
+
+    PrecompressedBody precompress(const std::string& body) const;
+
+    const CompressionConfig& getConfig() const { return config; }
+
+    static const char* encodingName(ContentEncoding encoding);
+    static std::vector<ContentEncoding> supportedEncodings();
+};
+
+#endif // RESPONSE_COMPRESSOR_H
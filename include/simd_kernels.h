@@ -0,0 +1,44 @@
+#ifndef SIMD_KERNELS_H
+#define SIMD_KERNELS_H
+
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+// The server's own hot loops, built once per instruction set.
+//
+// The binary targets baseline x86-64 so it runs on every node; each kernel
+// is additionally compiled for AVX2+FMA and AVX-512, and the best variant
+// the CPU supports is picked by cpuid on first use. All variants compute
+// bit-identical results (floating point is evaluated in a fixed order
+// without contraction), so the path a node takes never changes a seeded
+// request's sampling (the logits themselves depend on llama.cpp's backend).
+struct SimdKernels {
+    const char* name; // "generic", "avx2" or "avx512"
+
+    // Index of the largest value; the lowest index wins ties. n > 0
+    int32_t (*argmax)(const float* values, size_t n);
+
+    // weights[i] = exp((logits[i] - maxLogit) * invTemperature); returns their sum.
+    // Requires logits[i] <= maxLogit
+    double (*expWeights)(const float* logits, float* weights, size_t n, float maxLogit, float invTemperature);
+
+    int32_t (*dotInt8)(const int8_t* a, const int8_t* b, size_t n);
+
+    // weights[bit] += 1 where the feature hash has the bit set, else -= 1
+    void (*addSimhashFeature)(int32_t* weights, uint64_t featureHash);
+};
+
+// The selected variant; the first call runs detection
+const SimdKernels& simdKernels();
+
+// Use the named variant instead (before or after the first call). False,
+// keeping the current one, when the name is unknown or the CPU lacks it
+bool selectSimdKernels(const std::string& name);
+
+// Variants this CPU can run, best first, and the relevant features it reports
+std::vector<std::string> supportedSimdKernels();
+std::vector<std::string> cpuFeatures();
+
+#endif // SIMD_KERNELS_H
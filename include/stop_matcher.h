@@ -0,0 +1,45 @@
+#ifndef STOP_MATCHER_H
+#define STOP_MATCHER_H
+
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+// Finds the first occurrence of any of a set of stop sequences in a stream.
+//
+// An Aho–Corasick automaton over bytes: text is fed piece by piece as it is
+// detokenized, and a per-stream State carries partial matches across pieces,
+// so each piece costs time proportional to its length however many stop
+// sequences there are or however long the text has grown.
+class StopMatcher {
+public:
+    using State = uint32_t; // Starts at 0
+
+    struct Match {
+        size_t end;    // One past the last byte of the match, as an offset into the fed piece
+        size_t length; // Length of the stop sequence; it may start in an earlier piece
+    };
+
+    StopMatcher() = default;
+    explicit StopMatcher(const std::vector<std::string>& stops);
+
+    bool empty() const { return nodes.size() <= 1; }
+
+    // Advance over data; returns true (and stops advancing) at the first byte
+    // that completes a stop sequence. Where several end there, the longest wins
+    bool feed(State& state, const char* data, size_t size, Match& match) const;
+
+private:
+    struct Node {
+        std::vector<std::pair<unsigned char, State>> next; // Sorted by byte
+        State fail = 0;
+        size_t output = 0; // Longest stop sequence that is a suffix of this node's path
+    };
+
+    std::vector<Node> nodes{Node()};
+
+    State child(State state, unsigned char byte) const; // 0 when there is no edge
+};
+
+#endif // STOP_MATCHER_H
@@ -0,0 +1,60 @@
+#ifndef SUPERVISOR_H
+#define SUPERVISOR_H
+
+#include <string>
+#include <vector>
+#include <array>
+#include <functional>
+#include <chrono>
+#include <initializer_list>
+#include <cstdint>
+
+// Owns the main thread once the server is up: runs periodic jobs and waits
+// for a shutdown signal.
+//
+// Jobs live in a hashed timer wheel of one-second ticks; a job due in more
+// than one lap waits in its slot until its tick comes round. The loop sleeps
+// in poll() on a signal self-pipe until the next occupied slot, so an idle
+// server wakes only when a job is due. Jobs run on the supervisor thread
+// and should hand heavy work to the threads that own it.
+class Supervisor {
+public:
+    using Job = std::function<void()>;
+
+    Supervisor();
+    ~Supervisor();
+
+    Supervisor(const Supervisor&) = delete;
+    Supervisor& operator=(const Supervisor&) = delete;
+
+    // Route these signals to run(). A second one exits the process at once
+    bool handleSignals(std::initializer_list<int> signals);
+
+    // Run job every period (rounded up to whole seconds), first after one period
+    void every(const std::string& name, std::chrono::seconds period, Job job);
+
+    // Blocks until a handled signal arrives and returns its number
+    int run();
+
+private:
+    static constexpr size_t kSlots = 64;
+
+    struct Timer {
+        std::string name;
+        uint64_t period; // Ticks
+        uint64_t due;    // Tick the job next runs at
+        Job job;
+    };
+
+    std::array<std::vector<Timer>, kSlots> wheel;
+    std::chrono::steady_clock::time_point epoch;
+    uint64_t processedTick = 0; // Every tick up to this one has run
+    size_t timerCount = 0;
+
+    uint64_t currentTick() const;
+    void schedule(Timer timer);
+    void runDue(uint64_t tick);
+    int msUntilNextSlot(uint64_t now) const; // -1 when nothing is scheduled
+};
+
+#endif // SUPERVISOR_H
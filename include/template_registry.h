@@ -0,0 +1,90 @@
+#ifndef TEMPLATE_REGISTRY_H
+#define TEMPLATE_REGISTRY_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <functional>
+#include <cstdint>
+
+struct QuizCategoryTemplates {
+    std::string name;
+    std::vector<std::string> subcategories;
+    std::vector<std::string> prompts; // One per TemplateSet::difficulties entry
+    std::vector<std::string> stop;    // Generation ends before any of these
+};
+
+struct PsychologyTemplate {
+    std::string category; // "<trait>_<topic>", e.g. "E/I_Social"
+    std::string prompt;
+    std::vector<std::string> stop;
+};
+
+// Immutable snapshot of every prompt template; replaced wholesale on reload
+struct TemplateSet {
+    std::vector<std::string> difficulties;
+    std::vector<QuizCategoryTemplates> categories;
+    std::vector<PsychologyTemplate> psychology; // Asked in this order
+    uint64_t version = 0;
+
+    const QuizCategoryTemplates* findCategory(const std::string& name) const;
+    const std::string* findQuizPrompt(const std::string& category, const std::string& difficulty) const;
+    const PsychologyTemplate* findPsychology(const std::string& category) const;
+    const std::string* findPsychologyPrompt(const std::string& category) const;
+
+    // Every prompt in the set, for diffing one version against the next
+    std::vector<std::string> allPrompts() const;
+};
+
+// Prompt templates loaded from a JSON file and reloaded when it changes.
+//
+// Readers take a shared_ptr snapshot, so a reload never blocks or tears a
+// request in flight. The file's directory is watched with inotify (editors
+// usually replace files by rename, which a watch on the file itself would
+// miss); a file that fails to parse or validate is logged and ignored, and
+// the previous templates stay live. Without a file the built-in defaults
+// are used.
+class TemplateRegistry {
+public:
+    // Called after a reload with the old and new snapshots
+    using ReloadCallback = std::function<void(const TemplateSet& previous, const TemplateSet& current)>;
+
+    TemplateRegistry();
+    ~TemplateRegistry();
+
+    TemplateRegistry(const TemplateRegistry&) = delete;
+    TemplateRegistry& operator=(const TemplateRegistry&) = delete;
+
+    // Load from path (keeping the defaults if it does not exist) and start watching it
+    bool load(const std::string& path, bool watch = true);
+    bool reload();
+    void stopWatching();
+
+    std::shared_ptr<const TemplateSet> snapshot() const;
+    void setReloadCallback(ReloadCallback callback);
+
+    const std::string& getPath() const { return path; }
+
+    static std::shared_ptr<TemplateSet> defaults();
+    static bool parse(const std::string& json, TemplateSet& set, std::string& error);
+
+private:
+    std::shared_ptr<const TemplateSet> current;
+    std::string path;
+    uint64_t nextVersion = 1;
+
+    std::mutex reloadMutex; // Serializes reloads and callback registration
+    ReloadCallback onReload;
+
+    int inotifyFd = -1;
+    int stopPipe[2] = {-1, -1};
+    std::thread watchThread;
+
+    void install(std::shared_ptr<TemplateSet> set);
+    bool startWatching();
+    void watchLoop();
+};
+
+#endif // TEMPLATE_REGISTRY_H
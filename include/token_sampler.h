@@ -0,0 +1,15 @@
+#ifndef TOKEN_SAMPLER_H
+#define TOKEN_SAMPLER_H
+
+#include "generation_params.h"
+#include <random>
+#include <cstdint>
+
+// Draw a token (llama_token id) from softmax(logits / temperature),
+// optionally restricted to the top_k most likely tokens and then to the
+// smallest set whose probability reaches top_p. Without filters this is a
+// single O(n_vocab) pass for the weights and one for the draw; no sorting
+// needed.
+int32_t sampleToken(const float* logits, int n_vocab, const GenerationParams& params, std::mt19937_64& rng);
+
+#endif // TOKEN_SAMPLER_H
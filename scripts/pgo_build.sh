@@ -0,0 +1,58 @@
+#!/bin/bash
+
+# Profile-guided build of ai_quiz_server.
+#
+#   1. Build instrumented binaries (AEON_PGO=GENERATE)
+#   2. Train: replay bench/training_requests.jsonl through ai_quiz_perf, which
+#      runs the server's code against the stub llama backend
+#   3. Rebuild the same build directory with the profile (AEON_PGO=USE)
+#   4. With --compare, benchmark the result against a plain build
+#
+# Usage: scripts/pgo_build.sh [--compare]
+# Environment: BUILD_DIR (build-pgo), PLAIN_DIR (build-plain), PASSES (5), JOBS (nproc)
+
+set -e  # Exit on any error
+
+cd "$(dirname "$0")/.."
+
+BUILD_DIR="${BUILD_DIR:-build-pgo}"
+PLAIN_DIR="${PLAIN_DIR:-build-plain}"
+PASSES="${PASSES:-5}"
+JOBS="${JOBS:-$(nproc)}"
+PROFILE_DIR="$(pwd)/$BUILD_DIR/pgo-profile"
+COMPARE=0
+
+for arg in "$@"; do
+    case "$arg" in
+        --compare) COMPARE=1 ;;
+        *) echo "Usage: $0 [--compare]"; exit 1 ;;
+    esac
+done
+
+echo "🔧 [1/3] Instrumented build in $BUILD_DIR"
+rm -rf "$PROFILE_DIR"
+cmake -S . -B "$BUILD_DIR" -DCMAKE_BUILD_TYPE=Release -DAEON_BUILD_PERF=ON \
+    -DAEON_PGO=GENERATE -DAEON_PGO_DIR="$PROFILE_DIR"
+cmake --build "$BUILD_DIR" -j"$JOBS"
+
+echo "🏋️ [2/3] Training on bench/training_requests.jsonl ($PASSES passes)"
+"$BUILD_DIR/bin/ai_quiz_perf" --replay bench/training_requests.jsonl --rounds "$PASSES"
+
+# GCC writes .gcda files that are used as-is; Clang writes raw profiles to merge
+if compgen -G "$PROFILE_DIR/*.profraw" > /dev/null; then
+    llvm-profdata merge -output="$PROFILE_DIR/default.profdata" "$PROFILE_DIR"/*.profraw
+fi
+
+echo "🚀 [3/3] Optimized build in $BUILD_DIR"
+cmake -S . -B "$BUILD_DIR" -DAEON_PGO=USE
+cmake --build "$BUILD_DIR" -j"$JOBS"
+echo "✅ PGO server: $BUILD_DIR/bin/ai_quiz_server"
+
+if [ "$COMPARE" = 1 ]; then
+    echo "📊 Comparing against a plain build in $PLAIN_DIR"
+    cmake -S . -B "$PLAIN_DIR" -DCMAKE_BUILD_TYPE=Release -DAEON_BUILD_PERF=ON -DAEON_PGO=OFF
+    cmake --build "$PLAIN_DIR" --target ai_quiz_perf -j"$JOBS"
+    "$PLAIN_DIR/bin/ai_quiz_perf" --baseline "$PLAIN_DIR/perf-results.json" --update-baseline
+    # The plain build is the baseline: "improved" rows are the PGO speedup
+    "$BUILD_DIR/bin/ai_quiz_perf" --baseline "$PLAIN_DIR/perf-results.json" || true
+fi
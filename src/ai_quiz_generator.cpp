@@ -1,150 +1,503 @@
 #include "ai_quiz_generator.h"
+#include "stop_matcher.h"
+#include "token_sampler.h"
+#include "resource_limits.h"
+#include "record_log.h"
 #include "llama.h"
+#include "ggml-backend.h"
 #include <iostream>
 #include <sstream>
 #include <regex>
 #include <algorithm>
 #include <random>
 #include <thread>
+#include <filesystem>
+#include <unordered_set>
+#include <cstdio>
+
+namespace
+{
+    std::mt19937_64 &servingRng()
+    {
+        thread_local std::mt19937_64 rng(std::random_device{}());
+        return rng;
+    }
+
+    // FNV-1a; unlike std::hash, stable across builds, so persisted cache keys stay valid
+    uint64_t stableHash(const std::string &text)
+    {
+        uint64_t hash = 14695981039346656037ull;
+        for (unsigned char c : text)
+        {
+            hash = (hash ^ c) * 1099511628211ull;
+        }
+        return hash;
+    }
+
+    // The name generation cache keys use for a model: adapted output is not
+    // the base model's, so each adapter set keys its own entries. Unadapted
+    // models keep their plain name and the cache entries persisted under it
+    std::shared_ptr<const std::string> adapterIdentity(const std::string &modelName,
+                                                       const std::vector<LoraAdapterSpec> &adapters)
+    {
+        std::string identity = modelName;
+        for (const auto &adapter : adapters)
+        {
+            identity += "+lora:" + adapter.path + "@" + std::to_string(adapter.scale);
+        }
+        return std::make_shared<const std::string>(std::move(identity));
+    }
+
+    // How clear a profile's preferences are: the mean distance of its eight
+    // trait scores from neutral, scaled to 0-1. Summed in a fixed order so
+    // single and batch analyses agree to the last bit
+    double preferenceConfidence(double extraversion, double sensing, double thinking, double judging)
+    {
+        double total = 0.0;
+        for (double score : {extraversion, sensing, thinking, judging})
+        {
+            total += std::abs(score - 0.5) + std::abs((1.0 - score) - 0.5);
+        }
+        return std::min(1.0, total / 8 * 2.0);
+    }
+
+    // The cache's default budget, shrunk under a small container memory limit
+    GenerationCacheConfig defaultCacheConfig()
+    {
+        GenerationCacheConfig config;
+        config.maxBytes = ResourceLimits::current().generationCacheBytes();
+        return config;
+    }
+
+    // Prefill chunks: never so small that per-decode overhead dominates, and
+    // a first guess until the model's prefill speed has been measured
+    constexpr int kMinPrefillChunk = 32;
+    constexpr int kInitialPrefillChunk = 128;
+
+    // llama_decode on the instance's threadpool, once the contexts sharing
+    // it are done with it (prefill chunks yield to waiting decode steps for
+    // up to maxYield). Prefill chunks also update the model's measured
+    // prefill speed. Caller holds the instance's modelMutex
+    int decodeOnPool(ModelInstance &instance, const llama_batch &batch, InferencePool::Work work,
+                     std::chrono::milliseconds maxYield = std::chrono::milliseconds(0))
+    {
+        std::optional<InferencePool::Turn> turn;
+        if (instance.threadPool)
+        {
+            turn.emplace(*instance.threadPool, work, maxYield);
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        int result = llama_decode(instance.context, batch);
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        if (work == InferencePool::Work::Prefill && result == 0 && batch.n_tokens >= kMinPrefillChunk && ms > 0)
+        {
+            // Moving average (1/4 weight), so one slow chunk does not shrink the next ones
+            double rate = batch.n_tokens / ms;
+            double average = instance.prefillTokensPerMs;
+            instance.prefillTokensPerMs = average == 0 ? rate : average + (rate - average) / 4;
+        }
+        return result;
+    }
+
+    // Prompt tokens per prefill decode: as many as the model prefills in
+    // targetMs, in whole ubatches, at least kMinPrefillChunk and at most n_batch.
+    // A target of 0 prefills n_batch tokens at a time
+    int prefillChunkSize(const ModelInstance &instance, int targetMs)
+    {
+        const int batchSize = static_cast<int>(llama_n_batch(instance.context));
+        if (targetMs <= 0)
+        {
+            return batchSize;
+        }
+
+        double rate = instance.prefillTokensPerMs;
+        if (rate == 0 && instance.tuning)
+        {
+            rate = instance.tuning->prefillTokensPerSec / 1000.0;
+        }
+        int chunk = rate > 0 ? static_cast<int>(rate * targetMs) : kInitialPrefillChunk;
+        const int ubatchSize = static_cast<int>(llama_n_ubatch(instance.context));
+        if (chunk > ubatchSize)
+        {
+            chunk -= chunk % ubatchSize;
+        }
+        return std::min(batchSize, std::max(kMinPrefillChunk, chunk));
+    }
+
+    // Counts a request against a model's queue for as long as it is in scope
+    struct PendingRequest
+    {
+        std::atomic<int> &pending;
+        explicit PendingRequest(std::atomic<int> &counter) : pending(counter) { pending++; }
+        ~PendingRequest() { pending--; }
+    };
+
+    // Watches a growing response for its first "Answer:" and the option
+    // letter after it, looking only at newly appended text
+    struct AnswerLineWatch
+    {
+        static constexpr const char *kMarker = "Answer:";
+        static constexpr size_t kMarkerLength = 7;
+
+        size_t scanned = 0;                     // Offset below which the marker cannot start
+        size_t letterFrom = std::string::npos;  // Set once the marker is found
+        bool settled = false;                   // The first marker was not followed by a letter
+
+        // True once the text holds "Answer:" followed by its option letter
+        bool complete(const std::string &text)
+        {
+            if (settled)
+            {
+                return false;
+            }
+            if (letterFrom == std::string::npos)
+            {
+                size_t pos = text.find(kMarker, scanned);
+                if (pos == std::string::npos)
+                {
+                    scanned = text.size() >= kMarkerLength ? text.size() - kMarkerLength + 1 : 0;
+                    return false;
+                }
+                letterFrom = pos + kMarkerLength;
+            }
+
+            size_t pos = text.find_first_not_of(" \t", letterFrom);
+            if (pos == std::string::npos)
+            {
+                letterFrom = text.size();
+                return false;
+            }
+            settled = true;
+            return text[pos] == 'A' || text[pos] == 'B' || text[pos] == 'C';
+        }
+    };
+}
 
 AIQuizGenerator::AIQuizGenerator(const std::string &quizModelPath,
                                  const std::string &psychologyModelPath,
                                  const std::string &analysisModelPath)
-    : contextSize(1024), maxTokens(128), temperature(0.7), // Reduced for small models
-      startTime(std::chrono::steady_clock::now())
+    : AIQuizGenerator(ModelZooConfig::forRoles(quizModelPath, psychologyModelPath, analysisModelPath))
+{
+}
+
+AIQuizGenerator::AIQuizGenerator(const ModelZooConfig &zooConfig)
+    : zoo(zooConfig),
+      contextSize(1024), // Reduced for small models
+      generationSettings(std::make_shared<GenerationSettings>()),
+      startTime(std::chrono::steady_clock::now()),
+      generationCache(std::make_unique<GenerationCache>(defaultCacheConfig()))
 {
 
     // Initialize model instances
-    quizModel = std::make_unique<ModelInstance>();
-    psychologyModel = std::make_unique<ModelInstance>();
-    analysisModel = std::make_unique<ModelInstance>();
+    for (const auto &spec : zoo.models)
+    {
+        auto instance = std::make_unique<ModelInstance>();
+        instance->modelName = spec.name;
+        instance->modelPath = spec.path;
+        instance->adapters = spec.adapters;
+        instance->cacheIdentity = adapterIdentity(spec.name, spec.adapters);
+        models.push_back(std::move(instance));
+    }
 
     initializeDifficultyModifiers();
-    initializePromptTemplates();
-    initializePsychologyTemplates();
+    templates.setReloadCallback([this](const TemplateSet &previous, const TemplateSet &current)
+                                { onTemplatesReloaded(previous, current); });
     initializePersonalityData();
 
-    std::cout << "🤖 AIQuizGenerator initializing with multiple small models..." << std::endl;
-    std::cout << "📁 Quiz Model: " << quizModelPath << std::endl;
-    std::cout << "📁 Psychology Model: " << psychologyModelPath << std::endl;
-    std::cout << "📁 Analysis Model: " << analysisModelPath << std::endl;
-
-    // Initialize models in parallel for faster startup
-    std::vector<std::thread> initThreads;
-
-    initThreads.emplace_back([this, quizModelPath]()
-                             {
-        if (initializeModel(quizModel.get(), quizModelPath, "Quiz-Model")) {
-            std::cout << "✅ Quiz model loaded successfully!" << std::endl;
-        } else {
-            std::cerr << "❌ Failed to load quiz model!" << std::endl;
-        } });
-
-    initThreads.emplace_back([this, psychologyModelPath]()
-                             {
-        if (initializeModel(psychologyModel.get(), psychologyModelPath, "Psychology-Model")) {
-            std::cout << "✅ Psychology model loaded successfully!" << std::endl;
-        } else {
-            std::cerr << "❌ Failed to load psychology model!" << std::endl;
-        } });
-
-    initThreads.emplace_back([this, analysisModelPath]()
-                             {
-        if (initializeModel(analysisModel.get(), analysisModelPath, "Analysis-Model")) {
-            std::cout << "✅ Analysis model loaded successfully!" << std::endl;
-        } else {
-            std::cerr << "❌ Failed to load analysis model!" << std::endl;
-        } });
-
-    // Wait for all models to load
-    for (auto &thread : initThreads)
+    std::cout << "🤖 AIQuizGenerator initializing with " << models.size() << " small models..." << std::endl;
+    for (const auto &spec : zoo.models)
     {
-        thread.join();
+        std::cout << "📁 " << spec.name << ": " << spec.path << std::endl;
+        for (const auto &adapter : spec.adapters)
+        {
+            std::cout << "   🧩 LoRA " << adapter.path << " (scale " << adapter.scale << ")" << std::endl;
+        }
     }
 
+    loadModels();
+
+    // Background worker for pre-generation, retries and bank growth
+    backgroundThread = std::thread(&AIQuizGenerator::backgroundGenerationLoop, this);
+
     std::cout << "🧠 Multi-model psychology assessment ready!" << std::endl;
     std::cout << "💾 Total memory usage optimized with small models!" << std::endl;
 }
 
 AIQuizGenerator::~AIQuizGenerator()
 {
-    cleanupModel(quizModel.get());
-    cleanupModel(psychologyModel.get());
-    cleanupModel(analysisModel.get());
+    shutdown();
+
+    for (ModelInstance *instance : modelInstances())
+    {
+        cleanupModel(instance);
+    }
+    cleanupModel(embedder.get());
 }
 
-bool AIQuizGenerator::initializeModel(ModelInstance *instance, const std::string &modelPath, const std::string &modelName)
+bool AIQuizGenerator::loadModels()
 {
-    std::lock_guard<std::mutex> lock(instance->modelMutex);
+    // Load each distinct file once, in parallel for faster startup; every
+    // instance of that file then gets its own context on the shared weights
+    std::unordered_map<std::string, std::vector<ModelInstance *>> byPath;
+    for (ModelInstance *instance : modelInstances())
+    {
+        byPath[instance->modelPath].push_back(instance);
+    }
+
+    std::atomic<bool> success{true};
+    std::vector<std::thread> initThreads;
+    for (const auto &group : byPath)
+    {
+        initThreads.emplace_back([this, &group, &success]()
+                                 {
+            std::shared_ptr<llama_model> weights = loadWeights(group.first);
+            for (ModelInstance *instance : group.second) {
+                if (weights && initializeModel(instance, weights)) {
+                    std::cout << "✅ " << instance->modelName << " loaded successfully!" << std::endl;
+                } else {
+                    std::cerr << "❌ Failed to load " << instance->modelName << "!" << std::endl;
+                    success = false;
+                }
+            } });
+    }
+
+    // Wait for all models to load
+    for (auto &thread : initThreads)
+    {
+        thread.join();
+    }
+    return success;
+}
 
-    std::cout << "🔄 Loading " << modelName << " from " << modelPath << "..." << std::endl;
+std::shared_ptr<llama_model> AIQuizGenerator::loadWeights(const std::string &modelPath)
+{
+    std::cout << "🔄 Loading " << modelPath << "..." << std::endl;
 
-    // Initialize llama backend (only once)
+    // Initialize llama backend (only once). Portable builds ship ggml's CPU
+    // backend once per ISA as modules; loading them keeps the best one
     static std::once_flag llamaInitFlag;
     std::call_once(llamaInitFlag, []()
-                   { llama_backend_init(); });
+                   {
+                       llama_backend_init();
+                       ggml_backend_load_all();
+                   });
 
     // Model parameters optimized for small models
     auto model_params = llama_model_default_params();
     model_params.n_gpu_layers = 0; // CPU only
 
     // Load model
-    instance->model = llama_model_load_from_file(modelPath.c_str(), model_params);
-    if (!instance->model)
+    llama_model *model = llama_model_load_from_file(modelPath.c_str(), model_params);
+    if (!model)
     {
-        std::cerr << "❌ Failed to load " << modelName << " from: " << modelPath << std::endl;
-        return false;
+        std::cerr << "❌ Failed to load model from: " << modelPath << std::endl;
+        return nullptr;
     }
+    return std::shared_ptr<llama_model>(model, llama_model_free);
+}
 
-    // Context parameters optimized for small models
-    auto ctx_params = llama_context_default_params();
-    ctx_params.n_ctx = contextSize;
-    ctx_params.n_threads = std::max(1, (int)std::thread::hardware_concurrency() / 3); // Distribute threads
-    ctx_params.n_threads_batch = ctx_params.n_threads;
+bool AIQuizGenerator::initializeModel(ModelInstance *instance, std::shared_ptr<llama_model> weights)
+{
+    std::lock_guard<std::mutex> lock(instance->modelMutex);
 
-    // Create context
-    instance->context = llama_init_from_model(instance->model, ctx_params);
-    if (!instance->context)
+    instance->weights = std::move(weights);
+    instance->model = instance->weights.get();
+
+    if (!createContext(instance))
     {
-        std::cerr << "❌ Failed to create context for " << modelName << std::endl;
-        llama_model_free(instance->model);
+        instance->weights.reset();
         instance->model = nullptr;
         return false;
     }
 
-    instance->modelPath = modelPath;
-    instance->modelName = modelName;
     instance->isLoaded = true;
     instance->lastUsed = std::chrono::steady_clock::now();
 
     char buf[128];
     llama_model_desc(instance->model, buf, sizeof(buf));
-    std::cout << "✅ " << modelName << " loaded: " << buf << std::endl;
-    std::cout << "🧠 Context size: " << contextSize << " tokens, Threads: " << ctx_params.n_threads << std::endl;
+    std::cout << "✅ " << instance->modelName << " loaded: " << buf << std::endl;
+    std::cout << "🧠 Context size: " << contextSize << " tokens, Threads: "
+              << llama_n_threads(instance->context) << std::endl;
 
     return true;
 }
 
-void AIQuizGenerator::cleanupModel(ModelInstance *instance)
+std::vector<ModelInstance *> AIQuizGenerator::modelInstances() const
 {
-    if (!instance)
-        return;
+    std::vector<ModelInstance *> instances;
+    for (const auto &instance : models)
+    {
+        instances.push_back(instance.get());
+    }
+    return instances;
+}
 
-    std::lock_guard<std::mutex> lock(instance->modelMutex);
+ModelInstance *AIQuizGenerator::modelFor(GenerationRole task, const std::string &category,
+                                         const std::string &difficulty) const
+{
+    // Validated configs route every task; fall back to the first model regardless
+    int index = zoo.resolve(task, category, difficulty);
+    return models[index < 0 ? 0 : index].get();
+}
+
+bool AIQuizGenerator::createContext(ModelInstance *instance)
+{
+    // Context parameters optimized for small models
+    auto ctx_params = llama_context_default_params();
+    ctx_params.n_ctx = contextSize;
+    // Models may decode side by side, so they split the CPUs we are allowed
+    // (the cgroup quota in a container), not the host's cores
+    ctx_params.n_threads = ResourceLimits::current().threadsPerContext(static_cast<int>(models.size()));
+    ctx_params.n_threads_batch = ctx_params.n_threads;
+    ctx_params.n_seq_max = kMaxCandidates; // Parallel candidates share the context
+    if (instance->tuning)
+    {
+        ctx_params.n_threads = instance->tuning->threads;
+        ctx_params.n_threads_batch = instance->tuning->threads;
+        ctx_params.n_batch = instance->tuning->batchSize;
+        ctx_params.n_ubatch = instance->tuning->ubatchSize;
+    }
+
+    // Create context
+    instance->context = llama_init_from_model(instance->model, ctx_params);
+    if (!instance->context)
+    {
+        std::cerr << "❌ Failed to create context for " << instance->modelName << std::endl;
+        return false;
+    }
+    instance->threadPool = inferencePools.assign();
+    InferencePools::attach(instance->context, instance->threadPool, instance->tuning ? instance->tuning->threads : 0);
+    instance->adaptersApplied = false;
+    return true;
+}
 
+void AIQuizGenerator::releaseContext(ModelInstance *instance)
+{
     if (instance->context)
     {
         llama_free(instance->context);
         instance->context = nullptr;
     }
+    instance->threadPool.reset();
+    instance->loadedAdapters.clear();
+    instance->kvPrefix.clear();
+}
 
-    if (instance->model)
+void AIQuizGenerator::applyAdapters(ModelInstance *instance)
+{
+    if (instance->adaptersApplied)
     {
-        llama_model_free(instance->model);
-        instance->model = nullptr;
+        return;
+    }
+    instance->adaptersApplied = true;
+
+    // All or nothing: a model missing one of its adapters serves the base weights
+    std::vector<std::shared_ptr<LoraAdapter>> loaded;
+    for (const auto &spec : instance->adapters)
+    {
+        std::string error;
+        auto adapter = loraAdapters.get(instance->weights, spec.path, error);
+        if (!adapter)
+        {
+            std::cerr << "❌ " << instance->modelName << ": " << error << ", serving the base model" << std::endl;
+            loaded.clear();
+            break;
+        }
+        loaded.push_back(std::move(adapter));
+    }
+
+    // Detach the old adapters before they can be freed
+    LoraAdapterCache::apply(instance->context, loaded, instance->adapters);
+    instance->loadedAdapters = std::move(loaded);
+
+    // Without its adapters the model caches under its base name, and KV
+    // cells restored for the adapted model no longer match what it computes
+    const bool complete = instance->loadedAdapters.size() == instance->adapters.size();
+    std::atomic_store(&instance->cacheIdentity,
+                      adapterIdentity(instance->modelName,
+                                      complete ? instance->adapters : std::vector<LoraAdapterSpec>{}));
+    if (!complete)
+    {
+        llama_kv_self_clear(instance->context);
+        instance->kvPrefix.clear();
+    }
+}
+
+size_t AIQuizGenerator::evictIdleModels(std::chrono::seconds idleTimeout)
+{
+    auto now = std::chrono::steady_clock::now();
+    size_t evicted = 0;
+
+    for (ModelInstance *instance : modelInstances())
+    {
+        // A model that is busy is not idle
+        std::unique_lock<std::mutex> lock(instance->modelMutex, std::try_to_lock);
+        if (!lock.owns_lock() || !instance->isLoaded || !instance->context || now - instance->lastUsed < idleTimeout)
+        {
+            continue;
+        }
+
+        // The weights stay mapped; only the context and its KV buffers are
+        // released, and generateTexts recreates them on next use
+        releaseContext(instance);
+        evicted++;
+
+        std::cout << "💤 " << instance->modelName << " idle, released its context" << std::endl;
+    }
+    return evicted;
+}
+
+void AIQuizGenerator::refillPools()
+{
+    auto set = templates.snapshot();
+    for (const auto &category : set->categories)
+    {
+        for (const auto &difficulty : set->difficulties)
+        {
+            if (needsBackgroundGeneration(category.name, difficulty))
+            {
+                requestBackgroundGeneration(category.name, difficulty);
+            }
+        }
+    }
+}
+
+void AIQuizGenerator::runMaintenance()
+{
+    size_t expiredPlayers = playerHistory.sweep();
+    generationCache->flush();
+    if (questionBank)
+    {
+        questionBank->flush();
+    }
+    if (embeddingIndex)
+    {
+        embeddingIndex->flush();
+    }
+
+    if (expiredPlayers > 0)
+    {
+        std::cout << "🧹 Expired " << expiredPlayers << " idle player histories" << std::endl;
     }
+}
+
+void AIQuizGenerator::cleanupModel(ModelInstance *instance)
+{
+    if (!instance)
+        return;
+
+    std::lock_guard<std::mutex> lock(instance->modelMutex);
+
+    // The weights are freed with the last instance sharing them, after
+    // the adapters loaded on them
+    releaseContext(instance);
+    instance->adaptersApplied = false;
+    instance->weights.reset();
+    instance->model = nullptr;
 
     instance->isLoaded = false;
+    instance->tokenCache.clear();
 }
 
 bool AIQuizGenerator::isModelLoaded(ModelInstance *instance) const
@@ -152,150 +505,445 @@ bool AIQuizGenerator::isModelLoaded(ModelInstance *instance) const
     if (!instance)
         return false;
     std::lock_guard<std::mutex> lock(instance->modelMutex);
-    return instance->isLoaded && instance->model && instance->context;
+    return instance->isLoaded && instance->model; // The context may be released while idle
+}
+
+std::string AIQuizGenerator::generateText(ModelInstance *instance, const std::string &prompt,
+                                          const GenerationParams &params, std::optional<uint64_t> seed)
+{
+    std::vector<std::string> responses = generateTexts(instance, prompt, 1, params, seed);
+    return responses.empty() ? "" : responses[0];
 }
 
-std::string AIQuizGenerator::generateText(ModelInstance *instance, const std::string &prompt)
+std::vector<std::string> AIQuizGenerator::generateTexts(ModelInstance *instance, const std::string &prompt,
+                                                        int count, const GenerationParams &params,
+                                                        std::optional<uint64_t> seed)
 {
-    if (!instance || !isModelLoaded(instance))
+    std::vector<std::string> responses;
+
+    if (!instance || !isModelLoaded(instance) || count < 1)
+    {
+        return responses;
+    }
+
+    count = std::min(count, kMaxCandidates);
+
+    // Seeded output is a pure function of its inputs: answer repeats from
+    // the cache without waiting for the model
+    std::string cacheKey;
+    std::mt19937_64 seededRng;
+    if (seed)
     {
-        return "";
+        if (lookupCachedTexts(instance, prompt, count, params, *seed, responses))
+        {
+            return responses;
+        }
+        seededRng.seed(*seed);
     }
+    std::mt19937_64 &rng = seed ? seededRng : servingRng();
 
+    PendingRequest queued(instance->pending);
     std::lock_guard<std::mutex> lock(instance->modelMutex);
+    auto serviceStart = std::chrono::steady_clock::now();
+
+    if (!instance->context && !createContext(instance))
+    {
+        return responses;
+    }
+    applyAdapters(instance);
+    if (seed)
+    {
+        // Keyed under the lock, by the adapters this generation runs with
+        cacheKey = GenerationCache::makeKey(*instance->cacheIdentity, prompt, count, params, *seed);
+    }
 
     // Update usage stats
     instance->usageCount++;
     instance->lastUsed = std::chrono::steady_clock::now();
 
-    // Tokenize prompt
-    std::vector<llama_token> tokens_list;
-    tokens_list.resize(prompt.length() + 1);
+    const llama_vocab *vocab = llama_model_get_vocab(instance->model);
 
-    int n_tokens = llama_tokenize(llama_model_get_vocab(instance->model), prompt.c_str(), prompt.length(),
-                                  tokens_list.data(), tokens_list.size(), false, true);
-
-    if (n_tokens < 0)
+    // Tokenize prompt (templates repeat, so tokenizations are cached per prompt)
+    auto cached = instance->tokenCache.find(prompt);
+    if (cached == instance->tokenCache.end())
     {
-        std::cerr << "❌ Failed to tokenize prompt for " << instance->modelName << std::endl;
-        return "";
-    }
+        std::vector<llama_token> tokens;
+        tokens.resize(prompt.length() + 1);
 
-    tokens_list.resize(n_tokens);
+        int n = llama_tokenize(vocab, prompt.c_str(), prompt.length(),
+                               tokens.data(), tokens.size(), false, true);
 
-    // Reset context
-    llama_kv_self_clear(instance->context);
+        if (n <= 0)
+        {
+            std::cerr << "❌ Failed to tokenize prompt for " << instance->modelName << std::endl;
+            return responses;
+        }
 
-    // Process prompt
-    if (llama_decode(instance->context, llama_batch_get_one(tokens_list.data(), n_tokens)) != 0)
+        tokens.resize(n);
+        cached = instance->tokenCache.emplace(prompt, std::move(tokens)).first;
+    }
+    const std::vector<llama_token> &tokens_list = cached->second;
+    const int n_tokens = static_cast<int>(tokens_list.size());
+
+    // Reuse the KV cells of the longest prefix shared with the previous
+    // prompt. The last prompt token is always decoded again, since its
+    // logits seed the first sampled token. Seeded requests always prefill
+    // the whole prompt: logits depend on how the prompt was split into
+    // decodes, and the previous prompt (or a restored state file) would make
+    // their output depend on the server's history
+    int reused = 0;
+    const int reusable = seed ? 0 : std::min<int>(instance->kvPrefix.size(), n_tokens - 1);
+    while (reused < reusable && instance->kvPrefix[reused] == tokens_list[reused])
     {
-        std::cerr << "❌ Failed to decode prompt for " << instance->modelName << std::endl;
-        return "";
+        reused++;
     }
 
-    // Generate response with reduced token count for small models
-    std::string response;
-    std::vector<llama_token> response_tokens;
-
-    for (int i = 0; i < maxTokens; ++i)
+    if (reused == 0)
     {
-        // Sample next token
-        auto logits = llama_get_logits_ith(instance->context, -1);
-        auto n_vocab = llama_vocab_n_tokens(llama_model_get_vocab(instance->model));
-
-        std::vector<llama_token_data> candidates;
-        candidates.reserve(n_vocab);
+        llama_kv_self_clear(instance->context);
+    }
+    else
+    {
+        const int sequences = static_cast<int>(llama_n_seq_max(instance->context));
+        for (int seq = 1; seq < sequences; ++seq)
+        {
+            llama_kv_self_seq_rm(instance->context, seq, -1, -1);
+        }
+        llama_kv_self_seq_rm(instance->context, 0, reused, -1);
+    }
+    instance->kvPrefix.assign(tokens_list.begin(), tokens_list.begin() + reused);
+
+    // Process prompt once on sequence 0, then share its KV cells with the
+    // other candidates instead of prefilling the same prompt `count` times.
+    // The prompt goes in chunks sized to the prefill latency target: each
+    // holds the threadpool, and models sharing it decode their next tokens
+    // in between, so a long prompt here does not stall their output.
+    // Seeded prompts go in n_batch chunks instead: sizes derived from
+    // measured speed vary between runs, and so would their logits
+    const int targetMs = prefillTargetMs.load();
+    const int chunkSize = seed ? static_cast<int>(llama_n_batch(instance->context))
+                               : prefillChunkSize(*instance, targetMs);
+    llama_batch batch = llama_batch_init(std::max(std::min(n_tokens - reused, chunkSize), count), 0, count);
+
+    int lastRow = 0; // Of the last prompt token, in the final chunk
+    for (int start = reused; start < n_tokens; start += chunkSize)
+    {
+        const int end = std::min(n_tokens, start + chunkSize);
+        for (int i = start; i < end; ++i)
+        {
+            int slot = i - start;
+            batch.token[slot] = tokens_list[i];
+            batch.pos[slot] = i;
+            batch.n_seq_id[slot] = 1;
+            batch.seq_id[slot][0] = 0;
+            batch.logits[slot] = (i == n_tokens - 1);
+        }
+        batch.n_tokens = end - start;
+        lastRow = batch.n_tokens - 1;
 
-        for (llama_token token_id = 0; token_id < n_vocab; token_id++)
+        if (decodeOnPool(*instance, batch, InferencePool::Work::Prefill, std::chrono::milliseconds(targetMs)) != 0)
         {
-            candidates.emplace_back(llama_token_data{token_id, logits[token_id], 0.0f});
+            std::cerr << "❌ Failed to decode prompt for " << instance->modelName << std::endl;
+            instance->kvPrefix.clear();
+            llama_batch_free(batch);
+            return responses;
         }
+    }
+    instance->kvPrefix = tokens_list;
 
-        llama_token_data_array candidates_p = {candidates.data(), candidates.size(), false};
+    for (int seq = 1; seq < count; ++seq)
+    {
+        llama_kv_self_seq_cp(instance->context, 0, seq, -1, -1);
+    }
+
+    // Every candidate samples its first token from the prompt's last logits
+    struct Candidate
+    {
+        std::string text;
+        int logitsIndex;
+        bool done = false;
+        StopMatcher::State stopState = 0;
+        AnswerLineWatch answerLine;
+    };
+    std::vector<Candidate> candidates(count, Candidate{std::string(), lastRow, false, 0, AnswerLineWatch()});
+
+    const int n_vocab = llama_vocab_n_tokens(vocab);
+    bool interrupted = false;
+
+    // All stop sequences are matched in one pass over each new piece
+    const StopMatcher stops(params.stop);
+
+    // Decode all live candidates together: one batch of up to `count` tokens per step
+    for (int step = 0; step < params.maxTokens; ++step)
+    {
+        batch.n_tokens = 0;
 
-        // Apply temperature (softmax) - optimized for small models
-        if (temperature <= 0)
+        for (int seq = 0; seq < count; ++seq)
         {
-            // Greedy sampling
-            for (size_t i = 1; i < candidates_p.size; ++i)
+            Candidate &candidate = candidates[seq];
+            if (candidate.done)
             {
-                if (candidates_p.data[i].logit > candidates_p.data[0].logit)
-                {
-                    candidates_p.data[0] = candidates_p.data[i];
-                }
+                continue;
             }
-        }
-        else
-        {
-            // Temperature sampling
-            float max_l = candidates_p.data[0].logit;
-            for (size_t i = 1; i < candidates_p.size; ++i)
+
+            if (generationCancelled)
             {
-                max_l = std::max(max_l, candidates_p.data[i].logit);
+                interrupted = true;
+                break;
             }
 
-            // Compute softmax
-            float sum = 0.0f;
-            for (size_t i = 0; i < candidates_p.size; ++i)
+            const float *logits = llama_get_logits_ith(instance->context, candidate.logitsIndex);
+            llama_token new_token = sampleToken(logits, n_vocab, params, rng);
+
+            // Check for end of sequence
+            if (new_token == llama_vocab_eos(vocab))
             {
-                float p = expf((candidates_p.data[i].logit - max_l) / temperature);
-                candidates_p.data[i].p = p;
-                sum += p;
+                candidate.done = true;
+                continue;
             }
 
-            // Normalize
-            for (size_t i = 0; i < candidates_p.size; ++i)
+            // Convert token to text
+            char token_str[256];
+            int token_len = llama_token_to_piece(vocab, new_token, token_str, sizeof(token_str), 0, false);
+            if (token_len > 0)
             {
-                candidates_p.data[i].p /= sum;
+                // Output ends just before the stop sequence, which may have
+                // begun in an earlier piece
+                StopMatcher::Match match;
+                if (stops.feed(candidate.stopState, token_str, token_len, match))
+                {
+                    candidate.text.append(token_str, match.end);
+                    candidate.text.resize(candidate.text.size() - match.length);
+                    candidate.done = true;
+                    continue;
+                }
+                candidate.text.append(token_str, token_len);
             }
 
-            // Sort by probability
-            std::sort(candidates_p.data, candidates_p.data + candidates_p.size,
-                      [](const llama_token_data &a, const llama_token_data &b)
-                      {
-                          return a.p > b.p;
-                      });
-        }
+            // Stop once the answer letter is out (basic heuristic)
+            if (candidate.answerLine.complete(candidate.text))
+            {
+                candidate.done = true;
+                continue;
+            }
 
-        // Sample token
-        llama_token new_token = candidates_p.data[0].id;
+            int slot = batch.n_tokens++;
+            batch.token[slot] = new_token;
+            batch.pos[slot] = n_tokens + step;
+            batch.n_seq_id[slot] = 1;
+            batch.seq_id[slot][0] = seq;
+            batch.logits[slot] = true;
+            candidate.logitsIndex = slot;
+        }
 
-        // Check for end of sequence
-        if (new_token == llama_vocab_eos(llama_model_get_vocab(instance->model)))
+        if (batch.n_tokens == 0 || interrupted)
         {
             break;
         }
 
-        // Convert token to text
-        char token_str[256];
-        int token_len = llama_token_to_piece(llama_model_get_vocab(instance->model), new_token, token_str, sizeof(token_str), 0, false);
-
-        if (token_len > 0)
+        // Decode this step's tokens for the next iteration
+        if (decodeOnPool(*instance, batch, InferencePool::Work::Step) != 0)
         {
-            response.append(token_str, token_len);
+            interrupted = true;
+            break;
         }
+    }
 
-        response_tokens.push_back(new_token);
+    llama_batch_free(batch);
 
-        // Decode single token for next iteration
-        if (llama_decode(instance->context, llama_batch_get_one(&new_token, 1)) != 0)
-        {
-            break;
-        }
+    for (auto &candidate : candidates)
+    {
+        responses.push_back(std::move(candidate.text));
+    }
 
-        // Stop if we have a complete question (basic heuristic)
-        if (response.find("Answer:") != std::string::npos && response.length() > 50)
-        {
-            break;
-        }
+    // Truncated output would not be what the same seed produces next time
+    if (seed && !interrupted)
+    {
+        generationCache->put(cacheKey, responses);
     }
 
-    return response;
+    // Exponential moving average (1/8 weight) of the time the model is held
+    int serviceMs = static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(
+                                         std::chrono::steady_clock::now() - serviceStart)
+                                         .count());
+    int average = instance->serviceTimeMs.load();
+    instance->serviceTimeMs = average == 0 ? serviceMs : average + (serviceMs - average) / 8;
+    return responses;
 }
 
-void AIQuizGenerator::initializeDifficultyModifiers()
+bool AIQuizGenerator::lookupCachedTexts(ModelInstance *instance, const std::string &prompt, int count,
+                                        const GenerationParams &params, uint64_t seed,
+                                        std::vector<std::string> &responses)
 {
-    difficultyModifiers["Easy"] = {
+    count = std::min(count, kMaxCandidates);
+    auto identity = std::atomic_load(&instance->cacheIdentity);
+    return generationCache->get(GenerationCache::makeKey(*identity, prompt, count, params, seed), responses);
+}
+
+bool AIQuizGenerator::shouldShed(const ModelInstance *instance) const
+{
+    int slo = latencySloMs.load();
+    if (slo <= 0)
+    {
+        return false;
+    }
+
+    // Everyone already queued for the model goes first, then this request's own decode
+    long long expectedMs = static_cast<long long>(instance->pending.load() + 1) * instance->serviceTimeMs.load();
+    return expectedMs > slo;
+}
+
+int AIQuizGenerator::retryAfterSeconds(const ModelInstance *instance) const
+{
+    // Long enough for the requests queued for the model, and one more, to be decoded
+    long long expectedMs = static_cast<long long>(instance->pending.load() + 1) * instance->serviceTimeMs.load();
+    return static_cast<int>(std::max(1LL, (expectedMs + 999) / 1000));
+}
+
+bool AIQuizGenerator::setThreadPoolConfig(const ThreadPoolConfig &config, std::string &error)
+{
+    if (!inferencePools.configure(config, error))
+    {
+        return false;
+    }
+
+    // Each context moves while it holds no decode; the old pools are freed
+    // when the last context leaves them
+    std::vector<ModelInstance *> instances = modelInstances();
+    if (embedder)
+    {
+        instances.push_back(embedder.get());
+    }
+    for (ModelInstance *instance : instances)
+    {
+        std::lock_guard<std::mutex> lock(instance->modelMutex);
+        if (instance->context)
+        {
+            instance->threadPool = inferencePools.assign();
+            InferencePools::attach(instance->context, instance->threadPool,
+                                   instance->tuning ? instance->tuning->threads : 0);
+        }
+    }
+    return true;
+}
+
+bool AIQuizGenerator::setModelAdapters(const std::string &modelName, const std::vector<LoraAdapterSpec> &adapters,
+                                       std::string &error)
+{
+    auto found = std::find_if(models.begin(), models.end(), [&modelName](const std::unique_ptr<ModelInstance> &model)
+                              { return model->modelName == modelName; });
+    if (found == models.end())
+    {
+        error = "unknown model '" + modelName + "'";
+        return false;
+    }
+    for (const auto &adapter : adapters)
+    {
+        if (!std::filesystem::is_regular_file(adapter.path))
+        {
+            error = "no adapter file " + adapter.path;
+            return false;
+        }
+    }
+
+    // The base weights stay; only what the context runs with changes. Its
+    // KV cells were computed with the old adapters, so they go too
+    ModelInstance *instance = found->get();
+    std::lock_guard<std::mutex> lock(instance->modelMutex);
+    instance->adapters = adapters;
+    instance->adaptersApplied = false;
+    if (instance->context)
+    {
+        llama_kv_self_clear(instance->context);
+    }
+    instance->kvPrefix.clear();
+    std::atomic_store(&instance->cacheIdentity, adapterIdentity(modelName, adapters));
+
+    std::cout << "🧩 " << modelName << " now runs with " << adapters.size() << " LoRA adapter(s)" << std::endl;
+    return true;
+}
+
+std::vector<ModelAdapterState> AIQuizGenerator::getModelAdapters() const
+{
+    std::vector<ModelAdapterState> states;
+    for (ModelInstance *instance : modelInstances())
+    {
+        std::lock_guard<std::mutex> lock(instance->modelMutex);
+        // Whether the context runs with exactly the configured adapters
+        bool applied = instance->adaptersApplied ? instance->loadedAdapters.size() == instance->adapters.size()
+                                                 : instance->adapters.empty() && instance->loadedAdapters.empty();
+        states.push_back({instance->modelName, instance->modelPath, instance->adapters, applied});
+    }
+    return states;
+}
+
+bool AIQuizGenerator::enableAutoTune(const AutoTuneConfig &config)
+{
+    AutoTuneConfig measured = config;
+    measured.contextSize = contextSize;
+    AutoTuner tuner(measured);
+    std::vector<std::string> prompts = templates.snapshot()->allPrompts();
+
+    // Instances sharing weights are tuned once
+    std::unordered_map<const llama_model *, TunedSettings> byWeights;
+    bool success = true;
+    for (ModelInstance *instance : modelInstances())
+    {
+        if (!isModelLoaded(instance))
+        {
+            continue;
+        }
+        auto tuned = byWeights.find(instance->model);
+        if (tuned == byWeights.end())
+        {
+            TunedSettings settings;
+            if (!tuner.tune(instance->model, instance->modelPath, prompts, settings))
+            {
+                success = false;
+                continue;
+            }
+            tuned = byWeights.emplace(instance->model, settings).first;
+        }
+
+        // Batch sizes are fixed when a context is created, so it is recreated
+        std::lock_guard<std::mutex> lock(instance->modelMutex);
+        instance->tuning = tuned->second;
+        releaseContext(instance);
+        if (!createContext(instance))
+        {
+            success = false;
+            continue;
+        }
+        std::cout << "⚙️ " << instance->modelName << ": " << tuned->second.threads << " threads, batch "
+                  << tuned->second.batchSize << "/" << tuned->second.ubatchSize << " ("
+                  << static_cast<int>(tuned->second.prefillTokensPerSec) << " prefill, "
+                  << static_cast<int>(tuned->second.decodeTokensPerSec) << " decode tok/s)" << std::endl;
+    }
+    return success;
+}
+
+void AIQuizGenerator::setPrefillLatencyTarget(int milliseconds)
+{
+    prefillTargetMs = std::max(0, milliseconds);
+}
+
+void AIQuizGenerator::setLatencySlo(int milliseconds)
+{
+    latencySloMs = std::max(0, milliseconds);
+}
+
+void AIQuizGenerator::getSheddingStats(int &shed, int &sloMs, int &quizWaitMs) const
+{
+    shed = totalShedRequests.load();
+    sloMs = latencySloMs.load();
+
+    const ModelInstance *quiz = modelFor(GenerationRole::Quiz, "");
+    quizWaitMs = quiz->pending.load() * quiz->serviceTimeMs.load();
+}
+
+void AIQuizGenerator::initializeDifficultyModifiers()
+{
+    difficultyModifiers["Easy"] = {
         {"correct", 0.9}, {"wrong", 1.1}, {"steal", 5.0}, {"amount", 2.0}};
     difficultyModifiers["Medium"] = {
         {"correct", 0.8}, {"wrong", 1.3}, {"steal", 15.0}, {"amount", 5.0}};
@@ -303,115 +951,6 @@ void AIQuizGenerator::initializeDifficultyModifiers()
         {"correct", 0.6}, {"wrong", 1.5}, {"steal", 25.0}, {"amount", 10.0}};
 }
 
-void AIQuizGenerator::initializePromptTemplates()
-{
-    // Simplified prompts for small models
-    promptTemplates["Science"]["Easy"] =
-        "Create a basic science question with 3 options. "
-        "Question: [question]? A) [option1] B) [option2] C) [option3] Answer: [A/B/C]\n"
-        "Question:";
-
-    promptTemplates["Science"]["Medium"] =
-        "Create a science question with 3 options. "
-        "Question: [question]? A) [option1] B) [option2] C) [option3] Answer: [A/B/C]\n"
-        "Question:";
-
-    promptTemplates["Science"]["Hard"] =
-        "Create an advanced science question with 3 options. "
-        "Question: [question]? A) [option1] B) [option2] C) [option3] Answer: [A/B/C]\n"
-        "Question:";
-
-    // Similar simplified patterns for other categories
-    promptTemplates["Technology"]["Easy"] =
-        "Create a basic tech question with 3 options. "
-        "Question: [question]? A) [option1] B) [option2] C) [option3] Answer: [A/B/C]\n"
-        "Question:";
-
-    promptTemplates["Technology"]["Medium"] =
-        "Create a tech question with 3 options. "
-        "Question: [question]? A) [option1] B) [option2] C) [option3] Answer: [A/B/C]\n"
-        "Question:";
-
-    promptTemplates["Technology"]["Hard"] =
-        "Create an advanced tech question with 3 options. "
-        "Question: [question]? A) [option1] B) [option2] C) [option3] Answer: [A/B/C]\n"
-        "Question:";
-
-    promptTemplates["Mathematics"]["Easy"] =
-        "Create a basic math question with 3 options. "
-        "Question: [question]? A) [option1] B) [option2] C) [option3] Answer: [A/B/C]\n"
-        "Question:";
-
-    promptTemplates["Mathematics"]["Medium"] =
-        "Create a math question with 3 options. "
-        "Question: [question]? A) [option1] B) [option2] C) [option3] Answer: [A/B/C]\n"
-        "Question:";
-
-    promptTemplates["Mathematics"]["Hard"] =
-        "Create an advanced math question with 3 options. "
-        "Question: [question]? A) [option1] B) [option2] C) [option3] Answer: [A/B/C]\n"
-        "Question:";
-
-    promptTemplates["Engineering"]["Easy"] =
-        "Create a basic engineering question with 3 options. "
-        "Question: [question]? A) [option1] B) [option2] C) [option3] Answer: [A/B/C]\n"
-        "Question:";
-
-    promptTemplates["Engineering"]["Medium"] =
-        "Create an engineering question with 3 options. "
-        "Question: [question]? A) [option1] B) [option2] C) [option3] Answer: [A/B/C]\n"
-        "Question:";
-
-    promptTemplates["Engineering"]["Hard"] =
-        "Create an advanced engineering question with 3 options. "
-        "Question: [question]? A) [option1] B) [option2] C) [option3] Answer: [A/B/C]\n"
-        "Question:";
-}
-
-void AIQuizGenerator::initializePsychologyTemplates()
-{
-    // Simplified psychology prompts for small models
-    psychologyPromptTemplates["E/I_Social"] =
-        "Create a personality question about social preferences. "
-        "Question: [question]? A) [extroverted] B) [neutral] C) [introverted]\n"
-        "Question:";
-
-    psychologyPromptTemplates["E/I_Energy"] =
-        "Create a personality question about energy and social recharging. "
-        "Question: [question]? A) [extroverted] B) [neutral] C) [introverted]\n"
-        "Question:";
-
-    psychologyPromptTemplates["S/N_Information"] =
-        "Create a personality question about information processing. "
-        "Question: [question]? A) [sensing] B) [neutral] C) [intuition]\n"
-        "Question:";
-
-    psychologyPromptTemplates["S/N_Future"] =
-        "Create a personality question about future planning. "
-        "Question: [question]? A) [sensing] B) [neutral] C) [intuition]\n"
-        "Question:";
-
-    psychologyPromptTemplates["T/F_Decisions"] =
-        "Create a personality question about decision making. "
-        "Question: [question]? A) [thinking] B) [neutral] C) [feeling]\n"
-        "Question:";
-
-    psychologyPromptTemplates["T/F_Conflict"] =
-        "Create a personality question about handling conflict. "
-        "Question: [question]? A) [thinking] B) [neutral] C) [feeling]\n"
-        "Question:";
-
-    psychologyPromptTemplates["J/P_Structure"] =
-        "Create a personality question about structure and organization. "
-        "Question: [question]? A) [judging] B) [neutral] C) [perceiving]\n"
-        "Question:";
-
-    psychologyPromptTemplates["J/P_Deadlines"] =
-        "Create a personality question about deadlines and time management. "
-        "Question: [question]? A) [judging] B) [neutral] C) [perceiving]\n"
-        "Question:";
-}
-
 void AIQuizGenerator::initializePersonalityData()
 {
     // MBTI personality types and their descriptions
@@ -432,98 +971,1298 @@ void AIQuizGenerator::initializePersonalityData()
     personalityDescriptions["ESTP"] = "The Entrepreneur - Energetic, perceptive, skilled at adapting.";
     personalityDescriptions["ESFP"] = "The Entertainer - Enthusiastic, spontaneous, eager to help others have fun.";
 
-    // Personality traits for scoring
-    personalityTraits["E/I"] = {"Extroversion", "Introversion"};
-    personalityTraits["S/N"] = {"Sensing", "Intuition"};
-    personalityTraits["T/F"] = {"Thinking", "Feeling"};
-    personalityTraits["J/P"] = {"Judging", "Perceiving"};
+    // Personality traits for scoring
+    personalityTraits["E/I"] = {"Extroversion", "Introversion"};
+    personalityTraits["S/N"] = {"Sensing", "Intuition"};
+    personalityTraits["T/F"] = {"Thinking", "Feeling"};
+    personalityTraits["J/P"] = {"Judging", "Perceiving"};
+}
+
+std::string AIQuizGenerator::buildPrompt(const std::string &category, const std::string &difficulty,
+                                         std::vector<std::string> *stops) const
+{
+    auto set = templates.snapshot();
+
+    const QuizCategoryTemplates *categoryTemplates = set->findCategory(category);
+    if (!categoryTemplates)
+    {
+        categoryTemplates = &set->categories.front(); // Default fallback
+    }
+
+    auto diffIt = std::find(set->difficulties.begin(), set->difficulties.end(), difficulty);
+    if (diffIt == set->difficulties.end())
+    {
+        diffIt = std::find(set->difficulties.begin(), set->difficulties.end(), "Medium"); // Default fallback
+        if (diffIt == set->difficulties.end())
+        {
+            diffIt = set->difficulties.begin();
+        }
+    }
+
+    if (stops)
+    {
+        stops->insert(stops->end(), categoryTemplates->stop.begin(), categoryTemplates->stop.end());
+    }
+    return categoryTemplates->prompts[diffIt - set->difficulties.begin()];
+}
+
+QuizQuestion AIQuizGenerator::generateQuestion(const std::string &category,
+                                               const std::string &difficulty,
+                                               const std::string &playerName,
+                                               std::optional<uint64_t> seed,
+                                               const std::optional<GenerationParams> &params,
+                                               const std::string &topic)
+{
+    auto startTime = std::chrono::high_resolution_clock::now();
+    totalQuizRequests++;
+
+    // Seeded requests must depend only on their inputs, and requests with
+    // their own parameters must actually be generated with them, so both
+    // skip the pool, the bank and the player's history and run the model
+    auto resolved = resolveSeed(seed);
+    if (resolved || params)
+    {
+        GenerationParams effective = params ? *params : generationDefaults(GenerationRole::Quiz);
+
+        // Pool or bank content would break their guarantees, so under
+        // overload they are answered from the generation cache or not at all
+        ModelInstance *model = modelFor(GenerationRole::Quiz, category, difficulty);
+        if (isModelLoaded(model) && shouldShed(model))
+        {
+            GenerationParams keyed = effective;
+            std::string prompt = buildPrompt(category, difficulty, &keyed.stop);
+            std::vector<std::string> cached;
+            if (!resolved || !lookupCachedTexts(model, prompt, candidatesPerQuestion, keyed, *resolved, cached))
+            {
+                totalShedRequests++;
+                std::cout << "🚦 Quiz model overloaded, turning away " << (resolved ? "seeded" : "custom-params")
+                          << " request for " << playerName << std::endl;
+                QuizQuestion shed;
+                shed.category = category;
+                shed.difficulty = difficulty;
+                shed.generated = false;
+                shed.retryAfterSeconds = retryAfterSeconds(model);
+                return shed;
+            }
+        }
+
+        QuizQuestion question = generateFreshQuestion(category, difficulty, effective, resolved);
+
+        if (!question.generated)
+        {
+            // As below, the placeholder is never served or recorded. A seeded
+            // request would only reproduce the same candidates, so only an
+            // unseeded one gets the key's background worker going
+            if (!resolved)
+            {
+                requestBackgroundGeneration(category, difficulty);
+            }
+            totalFallbacksServed++;
+            question.source = "fallback";
+            question.retryAfterSeconds = retryAfterSeconds(model);
+            return question;
+        }
+
+        if (questionBank && isBankable(question))
+        {
+            bankIfNovel(question);
+        }
+
+        question.source = "generated";
+        recordServed(playerName, question);
+        return question;
+    }
+
+    // Keep a few freshly generated questions ready for this key
+    requestBackgroundGeneration(category, difficulty);
+
+    // A topic narrows the request to banked questions near it; without a
+    // match it is served like any other request for the key
+    if (!topic.empty() && embeddingIndex)
+    {
+        QuizQuestion targeted;
+        if (sampleByTopic(topic, category, difficulty, playerName, targeted))
+        {
+            targeted.generationTimeMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+                                            std::chrono::high_resolution_clock::now() - startTime)
+                                            .count();
+            totalTopicHits++;
+            targeted.source = "bank";
+            recordServed(playerName, targeted);
+
+            std::cout << "🧭 Served banked question on \"" << topic << "\" for " << playerName
+                      << " (" << category << "/" << difficulty << ")" << std::endl;
+            return targeted;
+        }
+    }
+
+    QuizQuestion pooled;
+    if (takeFromPool(category, difficulty, playerName, pooled))
+    {
+        pooled.generationTimeMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+                                      std::chrono::high_resolution_clock::now() - startTime)
+                                      .count();
+        totalPoolHits++;
+        pooled.source = "pool";
+        recordServed(playerName, pooled);
+
+        std::cout << "⚡ Served pre-generated question for " << playerName
+                  << " (" << category << "/" << difficulty << ")" << std::endl;
+        return pooled;
+    }
+
+    if (questionBank)
+    {
+        const auto &bankConfig = questionBank->getConfig();
+        size_t stocked = questionBank->count(category, difficulty);
+
+        // Once a key is stocked, only a `freshness` share of requests pays for
+        // inference. Under overload any banked question beats queueing for the
+        // model, however few the key has
+        std::uniform_real_distribution<double> coin(0.0, 1.0);
+        bool overloaded = shouldShed(modelFor(GenerationRole::Quiz, category, difficulty));
+        QuizQuestion banked;
+        if ((overloaded ||
+             (stocked >= static_cast<size_t>(bankConfig.minEntriesToServe) && coin(servingRng()) >= bankConfig.freshness)) &&
+            sampleUnseen(category, difficulty, playerName, banked))
+        {
+            banked.generationTimeMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+                                          std::chrono::high_resolution_clock::now() - startTime)
+                                          .count();
+            totalBankHits++;
+            if (overloaded)
+            {
+                totalShedRequests++;
+            }
+            banked.source = "bank";
+            recordServed(playerName, banked);
+
+            std::cout << (overloaded ? "🚦 Overloaded, served" : "🏦 Served") << " banked question for " << playerName
+                      << " (" << category << "/" << difficulty << ")" << std::endl;
+            return banked;
+        }
+    }
+
+    std::cout << "🤖 Generating quiz question using dedicated Quiz Model for " << playerName
+              << " (" << category << "/" << difficulty << ")" << std::endl;
+
+    QuizQuestion question = generateFreshQuestion(category, difficulty, generationDefaults(GenerationRole::Quiz));
+
+    if (!question.generated)
+    {
+        // No candidate passed the quality gate. The background worker retries;
+        // meanwhile a banked question beats asking the client to come back
+        QuizQuestion banked;
+        if (questionBank && sampleUnseen(category, difficulty, playerName, banked))
+        {
+            banked.generationTimeMs = question.generationTimeMs;
+            totalBankHits++;
+            banked.source = "bank";
+            recordServed(playerName, banked);
+            std::cout << "🏦 Served banked question after rejected generation" << std::endl;
+            return banked;
+        }
+
+        // The placeholder is never served: the client retries once the
+        // background worker has had a go at the key
+        requestBackgroundGeneration(category, difficulty);
+        totalFallbacksServed++;
+        question.source = "fallback";
+        question.retryAfterSeconds = retryAfterSeconds(modelFor(GenerationRole::Quiz, category, difficulty));
+        return question;
+    }
+
+    if (questionBank && isBankable(question) && !bankIfNovel(question))
+    {
+        // The model repeated itself: hand out a distinct banked question if
+        // there is one and let the worker produce a replacement
+        QuizQuestion banked;
+        if (sampleUnseen(category, difficulty, playerName, banked))
+        {
+            banked.generationTimeMs = question.generationTimeMs;
+            totalBankHits++;
+            banked.source = "bank";
+            recordServed(playerName, banked);
+            std::cout << "♻️ Replaced near-duplicate question with a banked one" << std::endl;
+            return banked;
+        }
+    }
+
+    question.source = "generated";
+    recordServed(playerName, question);
+    return question;
+}
+
+bool AIQuizGenerator::takeFromPool(const std::string &category, const std::string &difficulty,
+                                   const std::string &playerName, QuizQuestion &question)
+{
+    bool tracked = isTrackedPlayer(playerName);
+
+    std::lock_guard<std::mutex> lock(poolMutex);
+    auto it = questionPool.find(category + "/" + difficulty);
+    if (it == questionPool.end())
+    {
+        return false;
+    }
+
+    auto &ready = it->second;
+    for (auto entry = ready.begin(); entry != ready.end(); ++entry)
+    {
+        if (!tracked || !playerHistory.hasSeen(playerName, QuestionBank::fingerprint(entry->question)))
+        {
+            question = std::move(*entry);
+            ready.erase(entry);
+            return true;
+        }
+    }
+    return false;
+}
+
+size_t AIQuizGenerator::poolSize(const std::string &category, const std::string &difficulty) const
+{
+    std::lock_guard<std::mutex> lock(poolMutex);
+    auto it = questionPool.find(category + "/" + difficulty);
+    return it == questionPool.end() ? 0 : it->second.size();
+}
+
+bool AIQuizGenerator::isTrackedPlayer(const std::string &playerName)
+{
+    // Anonymous requests all share the default name; a shared history would
+    // only make them filter each other's questions
+    return !playerName.empty() && playerName != "Unknown";
+}
+
+bool AIQuizGenerator::sampleUnseen(const std::string &category, const std::string &difficulty,
+                                   const std::string &playerName, QuizQuestion &question)
+{
+    const int maxAttempts = 8;
+    bool tracked = isTrackedPlayer(playerName);
+
+    for (int attempt = 0; attempt < maxAttempts; ++attempt)
+    {
+        if (!questionBank->sample(category, difficulty, servingRng(), question))
+        {
+            return false;
+        }
+        if (!tracked || !playerHistory.hasSeen(playerName, QuestionBank::fingerprint(question.question)))
+        {
+            applyDifficultyModifiers(question);
+            return true;
+        }
+    }
+
+    // Everything we drew was already shown to this player
+    totalPlayerRepeatsAvoided++;
+    return false;
+}
+
+bool AIQuizGenerator::sampleByTopic(const std::string &topic, const std::string &category,
+                                    const std::string &difficulty, const std::string &playerName,
+                                    QuizQuestion &question)
+{
+    std::vector<float> query;
+    if (!topicEmbedding(topic, query))
+    {
+        return false;
+    }
+
+    // Every match clears the similarity bar, so pick among them at random
+    // rather than always serving the single nearest question
+    auto matches = embeddingIndex->search(query, kTopicCandidates, {QuestionBank::keyHash(category, difficulty)},
+                                          topicMinSimilarity);
+    std::shuffle(matches.begin(), matches.end(), servingRng());
+
+    bool tracked = isTrackedPlayer(playerName);
+    for (const auto &match : matches)
+    {
+        // Guard against keyHash collisions, as QuestionBank::sample does
+        if (!questionBank->read(match.id, question) || question.category != category ||
+            question.difficulty != difficulty)
+        {
+            continue;
+        }
+        if (!tracked || !playerHistory.hasSeen(playerName, QuestionBank::fingerprint(question.question)))
+        {
+            applyDifficultyModifiers(question);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool AIQuizGenerator::embedText(const std::string &text, std::vector<float> &embedding)
+{
+    if (!embedder)
+    {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(embedder->modelMutex);
+    if (!embedder->context)
+    {
+        return false;
+    }
+
+    const llama_vocab *vocab = llama_model_get_vocab(embedder->model);
+    std::vector<llama_token> tokens(text.length() + 2);
+    int n_tokens = llama_tokenize(vocab, text.c_str(), text.length(), tokens.data(), tokens.size(), true, false);
+    if (n_tokens <= 0)
+    {
+        return false;
+    }
+
+    // Pooling needs the whole sequence in one batch; questions are far shorter anyway
+    n_tokens = std::min<int>(n_tokens, llama_n_batch(embedder->context));
+
+    llama_batch batch = llama_batch_init(n_tokens, 0, 1);
+    for (int i = 0; i < n_tokens; ++i)
+    {
+        batch.token[i] = tokens[i];
+        batch.pos[i] = i;
+        batch.n_seq_id[i] = 1;
+        batch.seq_id[i][0] = 0;
+        batch.logits[i] = true;
+    }
+    batch.n_tokens = n_tokens;
+
+    llama_kv_self_clear(embedder->context);
+    bool ok = decodeOnPool(*embedder, batch, InferencePool::Work::Prefill,
+                           std::chrono::milliseconds(prefillTargetMs.load())) == 0;
+
+    const float *pooled = nullptr;
+    if (ok)
+    {
+        pooled = llama_get_embeddings_seq(embedder->context, 0);
+        if (!pooled)
+        {
+            pooled = llama_get_embeddings_ith(embedder->context, n_tokens - 1);
+        }
+    }
+    if (pooled)
+    {
+        embedding.assign(pooled, pooled + llama_model_n_embd(embedder->model));
+    }
+
+    llama_batch_free(batch);
+    return pooled != nullptr;
+}
+
+bool AIQuizGenerator::topicEmbedding(const std::string &topic, std::vector<float> &embedding)
+{
+    std::string key = topic;
+    std::transform(key.begin(), key.end(), key.begin(), [](unsigned char c)
+                   { return std::tolower(c); });
+
+    {
+        std::lock_guard<std::mutex> lock(topicMutex);
+        auto it = topicEmbeddings.find(key);
+        if (it != topicEmbeddings.end())
+        {
+            embedding = it->second;
+            return true;
+        }
+    }
+
+    // Phrased like the indexed text, so a bare subcategory name lands near its questions
+    if (!embedText("Question about " + topic, embedding))
+    {
+        return false;
+    }
+
+    // Subcategories repeat; arbitrary free text could grow the map without bound
+    std::lock_guard<std::mutex> lock(topicMutex);
+    if (topicEmbeddings.size() >= kMaxCachedTopics)
+    {
+        topicEmbeddings.clear();
+    }
+    topicEmbeddings.emplace(key, embedding);
+    return true;
+}
+
+void AIQuizGenerator::recordServed(const std::string &playerName, const QuizQuestion &question)
+{
+    if (isTrackedPlayer(playerName) && question.generated)
+    {
+        playerHistory.markSeen(playerName, QuestionBank::fingerprint(question.question));
+    }
+}
+
+void AIQuizGenerator::setPlayerHistoryConfig(const PlayerHistoryConfig &config)
+{
+    playerHistory.setConfig(config);
+}
+
+void AIQuizGenerator::getPlayerHistoryStats(size_t &activePlayers, size_t &memoryBytes, int &exhausted) const
+{
+    activePlayers = playerHistory.activePlayers();
+    memoryBytes = playerHistory.approximateMemoryBytes();
+    exhausted = totalPlayerRepeatsAvoided.load();
+}
+
+QuizQuestion AIQuizGenerator::generateFreshQuestion(const std::string &category,
+                                                    const std::string &difficulty,
+                                                    const GenerationParams &params,
+                                                    std::optional<uint64_t> seed)
+{
+    auto startTime = std::chrono::high_resolution_clock::now();
+
+    ModelInstance *model = modelFor(GenerationRole::Quiz, category, difficulty);
+    if (!isModelLoaded(model))
+    {
+        std::cerr << "❌ Quiz model " << model->modelName << " not loaded" << std::endl;
+        // Return a basic fallback question
+        QuizQuestion fallback;
+        fallback.question = "What is an important concept in " + category + "?";
+        fallback.answers = {"Concept A", "Concept B", "Concept C"};
+        fallback.correctAnswerIndex = 0;
+        fallback.category = category;
+        fallback.difficulty = difficulty;
+        fallback.generated = false;
+        fallback.aiModel = "Fallback";
+        applyDifficultyModifiers(fallback);
+        return fallback;
+    }
+
+    // Build AI prompt; the template's stop sequences add to the request's
+    GenerationParams effective = params;
+    std::string prompt = buildPrompt(category, difficulty, &effective.stop);
+
+    // Decode several candidates in one batch and keep the best-formed one
+    std::vector<std::string> candidates = generateTexts(model, prompt, candidatesPerQuestion, effective, seed);
+    totalCandidatesGenerated += candidates.size();
+
+    int bestIndex = -1;
+    int bestScore = -1;
+    for (size_t i = 0; i < candidates.size(); ++i)
+    {
+        int score = scoreQuizResponse(candidates[i]);
+        if (score < 0)
+        {
+            totalCandidatesRejected++;
+        }
+        else if (score > bestScore)
+        {
+            bestScore = score;
+            bestIndex = static_cast<int>(i);
+        }
+    }
+
+    std::mt19937_64 seededRng(seed.value_or(0));
+    std::mt19937_64 &rng = seed ? seededRng : servingRng();
+
+    QuizQuestion question;
+    if (bestIndex >= 0)
+    {
+        std::cout << "🔍 Quiz AI Response (" << bestIndex + 1 << "/" << candidates.size()
+                  << ", score " << bestScore << "): " << candidates[bestIndex].substr(0, 100) << "..." << std::endl;
+
+        // Parse response into structured question
+        question = parseAIResponse(candidates[bestIndex], category, difficulty, rng);
+        question.aiModel = model->modelName;
+    }
+    else
+    {
+        std::cout << "⚠️ All " << candidates.size() << " quiz candidates failed quality checks" << std::endl;
+
+        question = parseAIResponse("", category, difficulty, rng);
+        question.generated = false;
+        question.aiModel = "Fallback";
+    }
+
+    auto endTime = std::chrono::high_resolution_clock::now();
+    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(endTime - startTime);
+
+    question.generationTimeMs = duration.count();
+    totalQuestionsGenerated++;
+    totalGenerationTimeMs += duration.count();
+
+    std::cout << "✅ Quiz question generated in " << duration.count() << "ms: "
+              << question.question.substr(0, 50) << "..." << std::endl;
+
+    return question;
+}
+
+int AIQuizGenerator::scoreQuizResponse(const std::string &response) const
+{
+    // Hard requirements: anything failing these would reach the client as
+    // parseAIResponse() placeholders or a guessed correct answer
+    static const std::regex answerLine(R"(Answer:\s*[ABC])");
+    std::string question = extractQuestion(response);
+    std::vector<std::string> answers = extractRawAnswers(response);
+
+    if (question.size() < 15 || question.size() > 200 ||
+        question.find('[') != std::string::npos || answers.size() < 3 ||
+        !std::regex_search(response, answerLine))
+    {
+        return -1;
+    }
+
+    std::vector<std::string> seen;
+    int score = 100;
+    for (size_t i = 0; i < 3; ++i)
+    {
+        std::string normalized = NearDuplicateIndex::normalize(answers[i]);
+        if (normalized.empty() || answers[i].find('[') != std::string::npos ||
+            normalized == NearDuplicateIndex::normalize(question) ||
+            std::find(seen.begin(), seen.end(), normalized) != seen.end())
+        {
+            return -1; // Empty, echoed template, or repeated option
+        }
+        seen.push_back(normalized);
+
+        if (answers[i].size() > 80)
+        {
+            score -= 20; // Rambling option, probably swallowed the next line
+        }
+    }
+
+    // Soft preferences: a question of typical length, and no trailing junk
+    // between the options and the answer line
+    score -= std::abs(static_cast<int>(question.size()) - 60) / 10;
+    if (answers.size() > 3)
+    {
+        score -= 10;
+    }
+
+    return score;
+}
+
+bool AIQuizGenerator::isBankable(const QuizQuestion &question) const
+{
+    // parseAIResponse() patches over failed extraction with placeholders;
+    // those must never be stored and re-served
+    if (!question.generated || question.question.empty() ||
+        question.question.rfind("What is a fundamental concept in", 0) == 0 ||
+        question.answers.size() != 3)
+    {
+        return false;
+    }
+
+    for (const auto &answer : question.answers)
+    {
+        if (answer.empty() || answer.rfind("Option ", 0) == 0)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool AIQuizGenerator::bankIfNovel(const QuizQuestion &question)
+{
+    // SimHash lookup is a handful of hash probes, far cheaper than comparing
+    // against every stored question
+    if (!duplicateIndex.insertIfNovel(QuestionBank::fingerprint(question.question)))
+    {
+        totalDuplicatesRejected++;
+        return false;
+    }
+
+    if (questionBank->append(question))
+    {
+        totalBankAppends++;
+    }
+    return true;
+}
+
+void AIQuizGenerator::requestBackgroundGeneration(const std::string &category, const std::string &difficulty)
+{
+    // Only generate for keys we actually have prompts for
+    if (!templates.snapshot()->findQuizPrompt(category, difficulty))
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(backgroundMutex);
+    if (backgroundStopping)
+    {
+        return;
+    }
+    for (const auto &key : backgroundQueue)
+    {
+        if (key.first == category && key.second == difficulty)
+        {
+            return;
+        }
+    }
+    backgroundQueue.emplace_back(category, difficulty);
+    backgroundCv.notify_one();
+}
+
+bool AIQuizGenerator::needsBackgroundGeneration(const std::string &category, const std::string &difficulty) const
+{
+    if (poolSize(category, difficulty) < kPoolCapacityPerKey)
+    {
+        return true;
+    }
+    return questionBank &&
+           questionBank->count(category, difficulty) < static_cast<size_t>(questionBank->getConfig().targetEntriesPerKey);
+}
+
+void AIQuizGenerator::backgroundGenerationLoop()
+{
+    // Generate a few questions per key, then rotate so every key keeps
+    // its ready pool topped up and its bank growing
+    const int burstSize = 4;
+
+    while (true)
+    {
+        std::pair<std::string, std::string> key;
+        {
+            std::unique_lock<std::mutex> lock(backgroundMutex);
+            backgroundCv.wait(lock, [this]()
+                              { return backgroundStopping || !backgroundQueue.empty(); });
+            if (backgroundStopping)
+            {
+                return;
+            }
+            key = backgroundQueue.front();
+            backgroundQueue.pop_front();
+        }
+
+        int added = 0;
+        for (int i = 0; i < burstSize && needsBackgroundGeneration(key.first, key.second); ++i)
+        {
+            {
+                std::lock_guard<std::mutex> lock(backgroundMutex);
+                if (backgroundStopping)
+                {
+                    return;
+                }
+            }
+
+            // Rejected candidates are simply retried here rather than served
+            QuizQuestion question = generateFreshQuestion(key.first, key.second,
+                                                          generationDefaults(GenerationRole::Quiz));
+            if (!question.generated || !isBankable(question) || (questionBank && !bankIfNovel(question)))
+            {
+                continue;
+            }
+            added++;
+
+            std::lock_guard<std::mutex> lock(poolMutex);
+            auto &ready = questionPool[key.first + "/" + key.second];
+            if (ready.size() < kPoolCapacityPerKey)
+            {
+                ready.push_back(std::move(question));
+            }
+        }
+
+        // A burst that produced nothing usable means the model is stuck on
+        // this key for now; wait for the next request instead of spinning
+        if (added > 0 && needsBackgroundGeneration(key.first, key.second))
+        {
+            requestBackgroundGeneration(key.first, key.second);
+        }
+    }
+}
+
+void AIQuizGenerator::stopBackgroundWorker()
+{
+    {
+        std::lock_guard<std::mutex> lock(backgroundMutex);
+        backgroundStopping = true;
+        backgroundQueue.clear();
+    }
+    backgroundCv.notify_all();
+
+    if (backgroundThread.joinable())
+    {
+        backgroundThread.join();
+    }
+}
+
+bool AIQuizGenerator::enableQuestionBank(const QuestionBankConfig &config)
+{
+    std::lock_guard<std::mutex> lock(managerMutex);
+
+    if (questionBank)
+    {
+        std::cerr << "⚠️ Question bank already enabled" << std::endl;
+        return false;
+    }
+
+    std::error_code ec;
+    auto parent = std::filesystem::path(config.path).parent_path();
+    if (!parent.empty())
+    {
+        std::filesystem::create_directories(parent, ec);
+    }
+
+    auto bank = std::make_unique<QuestionBank>(config);
+    if (!bank->open())
+    {
+        std::cerr << "❌ Failed to open question bank at " << config.path << std::endl;
+        return false;
+    }
+
+    // Seed the near-duplicate index with everything already banked
+    bank->forEachFingerprint([this](uint64_t fingerprint)
+                             { duplicateIndex.insert(fingerprint); });
+
+    questionBank = std::move(bank);
+
+    std::cout << "🏦 Question bank enabled: " << config.path
+              << " (freshness " << config.freshness
+              << ", serve after " << config.minEntriesToServe
+              << ", grow to " << config.targetEntriesPerKey << " per key)" << std::endl;
+    return true;
+}
+
+bool AIQuizGenerator::enableEmbeddingIndex(const EmbeddingIndexConfig &config)
+{
+    std::lock_guard<std::mutex> lock(managerMutex);
+
+    if (!questionBank)
+    {
+        std::cerr << "❌ The embedding index needs the question bank enabled first" << std::endl;
+        return false;
+    }
+    if (embeddingIndex)
+    {
+        std::cerr << "⚠️ Embedding index already enabled" << std::endl;
+        return false;
+    }
+
+    // Without a model of its own the embedder shares the quiz model's weights
+    auto instance = std::make_unique<ModelInstance>();
+    instance->modelName = "Embedding Model";
+    if (config.modelPath.empty())
+    {
+        ModelInstance *quiz = modelFor(GenerationRole::Quiz, "");
+        std::lock_guard<std::mutex> quizLock(quiz->modelMutex);
+        instance->modelPath = quiz->modelPath;
+        instance->weights = quiz->weights;
+    }
+    else
+    {
+        instance->modelPath = config.modelPath;
+        instance->weights = loadWeights(config.modelPath);
+    }
+    if (!instance->weights)
+    {
+        std::cerr << "❌ No weights to embed questions with" << std::endl;
+        return false;
+    }
+    instance->model = instance->weights.get();
+
+    auto ctx_params = llama_context_default_params();
+    ctx_params.n_ctx = 512;
+    ctx_params.n_batch = ctx_params.n_ctx;
+    ctx_params.n_ubatch = ctx_params.n_ctx; // Mean pooling needs the sequence in one ubatch
+    ctx_params.n_threads = ResourceLimits::current().threadsPerContext(static_cast<int>(models.size()));
+    ctx_params.n_threads_batch = ctx_params.n_threads;
+    ctx_params.embeddings = true;
+    ctx_params.pooling_type = LLAMA_POOLING_TYPE_MEAN;
+    instance->context = llama_init_from_model(instance->model, ctx_params);
+    if (!instance->context)
+    {
+        std::cerr << "❌ Failed to create embedding context for " << instance->modelPath << std::endl;
+        return false;
+    }
+    instance->threadPool = inferencePools.assign();
+    InferencePools::attach(instance->context, instance->threadPool);
+    instance->isLoaded = true;
+
+    // Stored vectors are only comparable with ones from the same weights
+    size_t dimensions = static_cast<size_t>(llama_model_n_embd(instance->model));
+    std::error_code ec;
+    auto size = std::filesystem::file_size(instance->modelPath, ec);
+    auto modified = std::filesystem::last_write_time(instance->modelPath, ec).time_since_epoch().count();
+    uint64_t modelTag = stableHash(instance->modelPath + "|" + std::to_string(size) + "|" +
+                                   std::to_string(modified) + "|" + std::to_string(dimensions));
+
+    auto index = std::make_unique<EmbeddingIndex>();
+    if (!index->open(config.path, dimensions, modelTag))
+    {
+        cleanupModel(instance.get());
+        return false;
+    }
+
+    embedder = std::move(instance);
+    embeddingIndex = std::move(index);
+    topicMinSimilarity = config.minSimilarity;
+
+    std::cout << "🧭 Embedding index enabled: " << embeddingIndex->size() << " of " << questionBank->size()
+              << " banked questions indexed, " << dimensions << " dimensions (int8)" << std::endl;
+    return true;
+}
+
+bool AIQuizGenerator::isEmbeddingIndexEnabled() const
+{
+    return embeddingIndex != nullptr;
+}
+
+size_t AIQuizGenerator::indexBankedQuestions(size_t maxQuestions)
+{
+    if (!embeddingIndex)
+    {
+        return 0;
+    }
+
+    std::vector<std::pair<uint64_t, uint32_t>> pending;
+    questionBank->forEachEntry([this, &pending, maxQuestions](uint64_t offset, uint32_t key)
+                               {
+        if (pending.size() < maxQuestions && !embeddingIndex->contains(offset)) {
+            pending.emplace_back(offset, key);
+        } });
+
+    size_t indexed = 0;
+    for (const auto &entry : pending)
+    {
+        QuizQuestion question;
+        std::vector<float> embedding;
+        if (!questionBank->read(entry.first, question))
+        {
+            continue;
+        }
+
+        // The correct answer often names the topic more plainly than the question
+        std::string text = "Question about " + question.category + ": " + question.question;
+        if (question.correctAnswerIndex >= 0 && question.correctAnswerIndex < static_cast<int>(question.answers.size()))
+        {
+            text += " " + question.answers[question.correctAnswerIndex];
+        }
+        if (embedText(text, embedding) && embeddingIndex->add(entry.first, entry.second, embedding))
+        {
+            indexed++;
+        }
+    }
+
+    if (indexed > 0)
+    {
+        std::cout << "🧭 Embedded " << indexed << " banked questions (" << embeddingIndex->size()
+                  << " indexed)" << std::endl;
+    }
+    return indexed;
+}
+
+std::vector<std::pair<QuizQuestion, float>> AIQuizGenerator::searchQuestions(const std::string &topic,
+                                                                             const std::string &category,
+                                                                             const std::string &difficulty,
+                                                                             size_t limit)
+{
+    std::vector<std::pair<QuizQuestion, float>> results;
+    std::vector<float> query;
+    if (!embeddingIndex || !topicEmbedding(topic, query))
+    {
+        return results;
+    }
+
+    // An unset category or difficulty expands to every key it could pair with
+    std::vector<uint32_t> keys;
+    if (!category.empty() || !difficulty.empty())
+    {
+        auto set = templates.snapshot();
+        std::vector<std::string> categories, difficulties;
+        for (const auto &entry : set->categories)
+        {
+            categories.push_back(entry.name);
+        }
+        if (!category.empty())
+        {
+            categories = {category};
+        }
+        difficulties = difficulty.empty() ? set->difficulties : std::vector<std::string>{difficulty};
+
+        for (const auto &c : categories)
+        {
+            for (const auto &d : difficulties)
+            {
+                keys.push_back(QuestionBank::keyHash(c, d));
+            }
+        }
+    }
+
+    for (const auto &match : embeddingIndex->search(query, limit, keys))
+    {
+        QuizQuestion question;
+        if (questionBank->read(match.id, question) && (category.empty() || question.category == category) &&
+            (difficulty.empty() || question.difficulty == difficulty))
+        {
+            results.emplace_back(std::move(question), match.similarity);
+        }
+    }
+    return results;
+}
+
+void AIQuizGenerator::getEmbeddingIndexStats(size_t &entries, size_t &memoryBytes, int &topicHits) const
+{
+    entries = embeddingIndex ? embeddingIndex->size() : 0;
+    memoryBytes = embeddingIndex ? embeddingIndex->memoryBytes() : 0;
+    topicHits = totalTopicHits.load();
+}
+
+void AIQuizGenerator::beginShutdown()
+{
+    templates.stopWatching();
+
+    // Refills only compete with draining requests for the models; the
+    // worker exits after the question it is on
+    {
+        std::lock_guard<std::mutex> lock(backgroundMutex);
+        backgroundStopping = true;
+        backgroundQueue.clear();
+    }
+    backgroundCv.notify_all();
+}
+
+void AIQuizGenerator::cancelGeneration()
+{
+    generationCancelled = true;
+}
+
+void AIQuizGenerator::shutdown()
+{
+    if (shutDown.exchange(true))
+    {
+        return;
+    }
+
+    beginShutdown();
+    stopBackgroundWorker();
+
+    // The background worker is stopped, so the pool no longer changes
+    if (questionBank)
+    {
+        questionBank->flush();
+    }
+    saveQuestionPool();
+    if (embeddingIndex)
+    {
+        embeddingIndex->close();
+    }
+    generationCache->flush();
+    generationCache->close();
+
+    for (ModelInstance *instance : modelInstances())
+    {
+        saveModelState(instance);
+    }
+
+    std::cout << "💾 AI generator state persisted" << std::endl;
+}
+
+bool AIQuizGenerator::configureStateDirectory(const std::string &directory)
+{
+    {
+        std::lock_guard<std::mutex> lock(managerMutex);
+
+        std::error_code ec;
+        std::filesystem::create_directories(directory, ec);
+        if (ec)
+        {
+            std::cerr << "❌ Cannot create state directory " << directory << ": " << ec.message() << std::endl;
+            return false;
+        }
+        stateDirectory = directory;
+    }
+
+    int restored = 0;
+    for (ModelInstance *instance : modelInstances())
+    {
+        restored += restoreModelState(instance) ? 1 : 0;
+    }
+    size_t pooled = restoreQuestionPool();
+
+    std::cout << "💾 Model state directory: " << directory << " (" << restored << " prompt caches, "
+              << pooled << " pooled questions restored)" << std::endl;
+    return true;
+}
+
+bool AIQuizGenerator::saveQuestionPool()
+{
+    std::string directory = stateDirectoryPath();
+    if (directory.empty())
+    {
+        return false;
+    }
+
+    // Written aside and renamed over the previous file, so a crash mid-save
+    // leaves either the old pool or the new one
+    std::string path = (std::filesystem::path(directory) / "question_pool.log").string();
+    std::string tmpPath = path + ".tmp";
+    std::error_code ec;
+    std::filesystem::remove(tmpPath, ec);
+
+    RecordLog log;
+    if (!log.open(tmpPath))
+    {
+        std::cerr << "⚠️ Failed to save the question pool to " << tmpPath << std::endl;
+        return false;
+    }
+    size_t saved = 0;
+    bool ok = true;
+    {
+        std::lock_guard<std::mutex> lock(poolMutex);
+        for (const auto &entry : questionPool)
+        {
+            for (const auto &question : entry.second)
+            {
+                uint64_t offset;
+                ok = ok && log.append(QuestionBank::serialize(question), offset);
+                saved++;
+            }
+        }
+    }
+    ok = ok && log.sync();
+    log.close();
+
+    if (ok)
+    {
+        std::filesystem::rename(tmpPath, path, ec);
+        ok = !ec;
+    }
+    if (!ok)
+    {
+        std::cerr << "⚠️ Failed to save the question pool to " << path << std::endl;
+        std::filesystem::remove(tmpPath, ec);
+        return false;
+    }
+    std::cout << "💾 Saved " << saved << " pooled questions" << std::endl;
+    return true;
+}
+
+size_t AIQuizGenerator::restoreQuestionPool()
+{
+    std::string directory = stateDirectoryPath();
+    std::string path = (std::filesystem::path(directory) / "question_pool.log").string();
+    if (directory.empty() || !std::filesystem::exists(path))
+    {
+        return 0;
+    }
+
+    std::vector<QuizQuestion> questions;
+    RecordLog log;
+    log.open(path, RecordLog::firstRecordOffset(), [&questions](uint64_t, const std::string &payload)
+             {
+                 QuizQuestion question;
+                 if (QuestionBank::deserialize(payload, question))
+                 {
+                     questions.push_back(std::move(question));
+                 }
+             });
+    log.close();
+
+    // Served once: the file goes, and the next shutdown writes what is left
+    std::error_code ec;
+    std::filesystem::remove(path, ec);
+
+    size_t restored = 0;
+    std::lock_guard<std::mutex> lock(poolMutex);
+    for (auto &question : questions)
+    {
+        applyDifficultyModifiers(question);
+        auto &ready = questionPool[question.category + "/" + question.difficulty];
+        if (ready.size() < kPoolCapacityPerKey)
+        {
+            ready.push_back(std::move(question));
+            restored++;
+        }
+    }
+    return restored;
+}
+
+std::string AIQuizGenerator::stateDirectoryPath()
+{
+    std::lock_guard<std::mutex> lock(managerMutex);
+    return stateDirectory;
+}
+
+std::string AIQuizGenerator::stateFilePath(const ModelInstance *instance, const std::string &directory)
+{
+    // Caller holds instance->modelMutex. Saved KV cells are only valid for
+    // the same weights, adapters and context size, so all are part of the
+    // name and a changed model simply finds no state
+    std::error_code ec;
+    auto size = std::filesystem::file_size(instance->modelPath, ec);
+    auto modified = std::filesystem::last_write_time(instance->modelPath, ec).time_since_epoch().count();
+
+    std::string identity = instance->modelPath + "|" + std::to_string(size) + "|" + std::to_string(modified) +
+                           "|" + std::to_string(llama_n_ctx(instance->context));
+    for (const auto &adapter : instance->adapters)
+    {
+        size = std::filesystem::file_size(adapter.path, ec);
+        modified = std::filesystem::last_write_time(adapter.path, ec).time_since_epoch().count();
+        identity += "|" + adapter.path + "|" + std::to_string(size) + "|" + std::to_string(modified) + "|" +
+                    std::to_string(adapter.scale);
+    }
+    char fingerprint[17];
+    snprintf(fingerprint, sizeof(fingerprint), "%016llx", static_cast<unsigned long long>(stableHash(identity)));
+    return (std::filesystem::path(directory) / (instance->modelName + "-" + fingerprint + ".kv")).string();
+}
+
+bool AIQuizGenerator::saveModelState(ModelInstance *instance)
+{
+    std::string directory = stateDirectoryPath();
+
+    std::lock_guard<std::mutex> lock(instance->modelMutex);
+    if (directory.empty() || !instance->isLoaded || !instance->context || instance->kvPrefix.empty())
+    {
+        return false;
+    }
+    // Cells computed on the base weights after an adapter failed to load
+    // would be restored as the adapted model's
+    if (instance->adaptersApplied && instance->loadedAdapters.size() != instance->adapters.size())
+    {
+        return false;
+    }
+
+    std::string path = stateFilePath(instance, directory);
+
+    // Keep only the cached prompt: sequence 0 also holds the tail of the
+    // last response, and the other sequences are scratch candidates
+    const llama_pos prefix = static_cast<llama_pos>(instance->kvPrefix.size());
+    llama_kv_self_seq_rm(instance->context, 0, prefix, -1);
+
+    std::string tmpPath = path + ".tmp";
+    if (llama_state_seq_save_file(instance->context, tmpPath.c_str(), 0,
+                                  instance->kvPrefix.data(), instance->kvPrefix.size()) == 0)
+    {
+        std::cerr << "⚠️ Failed to save prompt state of " << instance->modelName << std::endl;
+        return false;
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(tmpPath, path, ec);
+    return !ec;
 }
 
-std::string AIQuizGenerator::buildPrompt(const std::string &category, const std::string &difficulty) const
+bool AIQuizGenerator::restoreModelState(ModelInstance *instance)
 {
-    auto catIt = promptTemplates.find(category);
-    if (catIt == promptTemplates.end())
+    std::string directory = stateDirectoryPath();
+
+    std::lock_guard<std::mutex> lock(instance->modelMutex);
+    if (directory.empty() || !instance->isLoaded || !instance->context)
+    {
+        return false;
+    }
+
+    std::string path = stateFilePath(instance, directory);
+    if (!std::filesystem::exists(path))
     {
-        catIt = promptTemplates.find("Science"); // Default fallback
+        return false;
     }
 
-    auto diffIt = catIt->second.find(difficulty);
-    if (diffIt == catIt->second.end())
+    std::vector<llama_token> tokens(llama_n_ctx(instance->context));
+    size_t count = 0;
+    llama_kv_self_clear(instance->context);
+    if (llama_state_seq_load_file(instance->context, path.c_str(), 0, tokens.data(), tokens.size(), &count) == 0)
     {
-        diffIt = catIt->second.find("Medium"); // Default fallback
+        std::cerr << "⚠️ Ignoring unreadable prompt state " << path << std::endl;
+        llama_kv_self_clear(instance->context);
+        instance->kvPrefix.clear();
+        return false;
     }
 
-    return diffIt->second;
+    tokens.resize(count);
+    instance->kvPrefix = std::move(tokens);
+    return true;
 }
 
-QuizQuestion AIQuizGenerator::generateQuestion(const std::string &category,
-                                               const std::string &difficulty,
-                                               const std::string &playerName)
+bool AIQuizGenerator::configureGenerationCache(const GenerationCacheConfig &config)
 {
-    auto startTime = std::chrono::high_resolution_clock::now();
+    std::lock_guard<std::mutex> lock(managerMutex);
 
-    std::cout << "🤖 Generating quiz question using dedicated Quiz Model for " << playerName
-              << " (" << category << "/" << difficulty << ")" << std::endl;
+    if (!config.path.empty())
+    {
+        std::error_code ec;
+        auto parent = std::filesystem::path(config.path).parent_path();
+        if (!parent.empty())
+        {
+            std::filesystem::create_directories(parent, ec);
+        }
+    }
 
-    if (!isModelLoaded(quizModel.get()))
+    auto cache = std::make_unique<GenerationCache>(config);
+    if (!cache->open())
     {
-        std::cerr << "❌ Quiz model not loaded" << std::endl;
-        // Return a basic fallback question
-        QuizQuestion fallback;
-        fallback.question = "What is an important concept in " + category + "?";
-        fallback.answers = {"Concept A", "Concept B", "Concept C"};
-        fallback.correctAnswerIndex = 0;
-        fallback.category = category;
-        fallback.difficulty = difficulty;
-        fallback.generated = false;
-        fallback.aiModel = "Fallback";
-        return fallback;
+        std::cerr << "❌ Failed to open generation cache at " << config.path << std::endl;
+        return false;
     }
 
-    // Build AI prompt
-    std::string prompt = buildPrompt(category, difficulty);
+    generationCache->close();
+    generationCache = std::move(cache);
 
-    // Generate AI response using dedicated quiz model
-    std::string aiResponse = generateText(quizModel.get(), prompt);
+    std::cout << "🗃️ Generation cache: " << (config.maxBytes / (1024 * 1024)) << " MB"
+              << (config.path.empty() ? " in memory" : ", persisted to " + config.path)
+              << (config.maxBytes == 0 ? " (disabled)" : "") << std::endl;
+    return true;
+}
 
-    std::cout << "🔍 Quiz AI Response: " << aiResponse.substr(0, 100) << "..." << std::endl;
+GenerationCache::Stats AIQuizGenerator::getCacheStats() const
+{
+    return generationCache->getStats();
+}
 
-    // Parse response into structured question
-    QuizQuestion question = parseAIResponse(aiResponse, category, difficulty);
-    question.aiModel = "DistilGPT-2-Quiz-Q2_K";
+size_t AIQuizGenerator::getCacheCapacity() const
+{
+    return generationCache->getConfig().maxBytes;
+}
 
-    auto endTime = std::chrono::high_resolution_clock::now();
-    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(endTime - startTime);
+bool AIQuizGenerator::flushQuestionBank()
+{
+    return questionBank && questionBank->flush();
+}
 
-    question.generationTimeMs = duration.count();
-    totalQuestionsGenerated++;
-    totalGenerationTimeMs += duration.count();
+void AIQuizGenerator::setSeed(std::optional<uint64_t> seed)
+{
+    globalSeed = seed;
+    if (seed)
+    {
+        std::cout << "🎲 Deterministic generation enabled with seed " << *seed << std::endl;
+    }
+}
 
-    std::cout << "✅ Quiz question generated in " << duration.count() << "ms: "
-              << question.question.substr(0, 50) << "..." << std::endl;
+std::optional<uint64_t> AIQuizGenerator::resolveSeed(std::optional<uint64_t> requested) const
+{
+    return requested ? requested : globalSeed;
+}
 
-    return question;
+void AIQuizGenerator::setCandidatesPerQuestion(int count)
+{
+    candidatesPerQuestion = std::max(1, std::min(kMaxCandidates, count));
+}
+
+void AIQuizGenerator::getQualityStats(int &candidates, int &rejected, int &fallbacks,
+                                      int &poolHits, double &fallbackRate) const
+{
+    candidates = totalCandidatesGenerated.load();
+    rejected = totalCandidatesRejected.load();
+    fallbacks = totalFallbacksServed.load();
+    poolHits = totalPoolHits.load();
+
+    int requests = totalQuizRequests.load();
+    fallbackRate = requests > 0 ? static_cast<double>(fallbacks) / requests : 0.0;
+}
+
+void AIQuizGenerator::getBankStats(size_t &totalEntries, int &hits, int &appended, int &duplicates) const
+{
+    totalEntries = questionBank ? questionBank->size() : 0;
+    hits = totalBankHits.load();
+    appended = totalBankAppends.load();
+    duplicates = totalDuplicatesRejected.load();
 }
 
 // NEW: Psychology question generation using dedicated psychology model
-std::vector<PsychologicalQuestion> AIQuizGenerator::generatePsychologyQuestions(int count)
+std::vector<PsychologicalQuestion> AIQuizGenerator::generatePsychologyQuestions(int count, std::optional<uint64_t> seed,
+                                                                                const std::optional<GenerationParams> &params)
 {
     std::vector<PsychologicalQuestion> questions;
 
-    if (!isModelLoaded(psychologyModel.get()))
-    {
-        std::cerr << "❌ Psychology model not loaded" << std::endl;
-        return questions;
-    }
+    auto resolved = resolveSeed(seed);
+    const GenerationParams effective = params ? *params : generationDefaults(GenerationRole::Psychology);
+
 
     std::cout << "🧠 Generating " << count << " psychology questions using dedicated Psychology Model..." << std::endl;
 
-    // Define question categories to ensure balanced assessment
-    std::vector<std::string> categories = {
-        "E/I_Social", "E/I_Energy",
-        "S/N_Information", "S/N_Future",
-        "T/F_Decisions", "T/F_Conflict",
-        "J/P_Structure", "J/P_Deadlines"};
+    // Question categories, in template order, to ensure balanced assessment
+    std::vector<std::string> categories;
+    for (const auto &entry : templates.snapshot()->psychology)
+    {
+        categories.push_back(entry.category);
+    }
 
     for (int i = 0; i < count && i < categories.size(); ++i)
     {
@@ -536,14 +2275,21 @@ std::vector<PsychologicalQuestion> AIQuizGenerator::generatePsychologyQuestions(
                   << " (Category: " << category << ")" << std::endl;
 
         // Build AI prompt for psychology question
-        std::string prompt = buildPsychologyPrompt(trait, category);
+        GenerationParams questionParams = effective;
+        std::string prompt = buildPsychologyPrompt(trait, category, &questionParams.stop);
 
-        // Generate AI response using dedicated psychology model
-        std::string aiResponse = generateText(psychologyModel.get(), prompt);
+        // Generate AI response using the psychology model routed for this category
+        ModelInstance *model = modelFor(GenerationRole::Psychology, category);
+        if (!isModelLoaded(model))
+        {
+            std::cerr << "❌ Psychology model " << model->modelName << " not loaded" << std::endl;
+            return questions;
+        }
+        std::string aiResponse = generateText(model, prompt, questionParams, resolved);
 
         // Parse response into psychological question
         PsychologicalQuestion question = parsePsychologyResponse(aiResponse, i + 1, trait, category);
-        question.aiModel = "DistilGPT-2-Psychology-Q2_K";
+        question.aiModel = model->modelName;
 
         auto endTime = std::chrono::high_resolution_clock::now();
         auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(endTime - startTime);
@@ -562,7 +2308,8 @@ std::vector<PsychologicalQuestion> AIQuizGenerator::generatePsychologyQuestions(
 }
 
 // NEW: Personality analysis using dedicated analysis model
-PersonalityResult AIQuizGenerator::analyzePersonality(const std::vector<PersonalityAnswer> &answers)
+PersonalityResult AIQuizGenerator::analyzePersonality(const std::vector<PersonalityAnswer> &answers,
+                                                      std::optional<uint64_t> seed)
 {
     auto startTime = std::chrono::high_resolution_clock::now();
 
@@ -570,13 +2317,31 @@ PersonalityResult AIQuizGenerator::analyzePersonality(const std::vector<Personal
 
     PersonalityResult result;
     result.aiGenerated = true;
-    result.analysisModel = "MBTI + DistilGPT-2-Analysis-Q2_K";
 
     // Calculate trait scores based on answers
     result.scores = calculateTraitScores(answers);
 
     // Determine personality type
     result.personalityType = determinePersonalityType(result.scores);
+    describePersonalityType(result, seed);
+    result.confidence = preferenceConfidence(result.scores.at("E"), result.scores.at("S"),
+                                             result.scores.at("T"), result.scores.at("J"));
+
+    auto endTime = std::chrono::high_resolution_clock::now();
+    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(endTime - startTime);
+
+    result.analysisTimeMs = duration.count();
+    totalPersonalityAnalyses++;
+
+    std::cout << "✅ Personality analysis complete using dedicated model: " << result.personalityType
+              << " (" << result.title << ") in " << duration.count() << "ms" << std::endl;
+
+    return result;
+}
+
+void AIQuizGenerator::describePersonalityType(PersonalityResult &result, std::optional<uint64_t> seed)
+{
+    ModelInstance *analysisModel = modelFor(GenerationRole::Analysis, result.personalityType);
 
     // Get base description
     auto descIt = personalityDescriptions.find(result.personalityType);
@@ -585,53 +2350,121 @@ PersonalityResult AIQuizGenerator::analyzePersonality(const std::vector<Personal
         result.title = descIt->second.substr(0, descIt->second.find(" - "));
 
         // Generate enhanced description using analysis model
-        if (isModelLoaded(analysisModel.get()))
+        if (isModelLoaded(analysisModel))
         {
-            result.description = generatePersonalityDescription(result.personalityType, result.scores);
+            // Unseeded requests still get a fixed seed per type: the prompt only
+            // depends on the type, so its description is decoded once and cached
+            uint64_t descriptionSeed = resolveSeed(seed).value_or(stableHash(result.personalityType));
+            result.description = generatePersonalityDescription(result.personalityType, result.scores,
+                                                                descriptionSeed, result.source);
         }
         else
         {
             result.description = descIt->second;
+            result.source = "template";
         }
     }
     else
     {
         result.title = "Unique Personality";
         result.description = "A distinctive personality pattern with unique traits.";
+        result.source = "template";
     }
+    result.analysisModel = result.source == "template" ? "MBTI" : "MBTI + " + analysisModel->modelName;
 
     // Generate strengths and growth areas
     result.strengths = generateStrengthsAndGrowthAreas(result.personalityType, true);
     result.growthAreas = generateStrengthsAndGrowthAreas(result.personalityType, false);
+}
 
-    // Calculate confidence based on how clear the preferences are
-    double totalConfidence = 0.0;
-    for (const auto &score : result.scores)
+PersonalityBatchResult AIQuizGenerator::analyzePersonalityBatch(const std::vector<std::vector<PersonalityAnswer>> &answerSets,
+                                                                std::optional<uint64_t> seed)
+{
+    auto startTime = std::chrono::high_resolution_clock::now();
+    size_t count = answerSets.size();
+
+    PersonalityBatchResult batch;
+    batch.typeIndex.resize(count);
+    batch.extraversion.resize(count);
+    batch.sensing.resize(count);
+    batch.thinking.resize(count);
+    batch.judging.resize(count);
+    batch.confidence.resize(count);
+
+    // Same rules and arithmetic as calculateTraitScores(), on four doubles
+    // per set instead of a map of eight strings
+    for (size_t i = 0; i < count; ++i)
     {
-        double preference = std::abs(score.second - 0.5); // Distance from neutral
-        totalConfidence += preference;
+        double axes[4] = {0.5, 0.5, 0.5, 0.5}; // E, S, T, J
+        for (const auto &answer : answerSets[i])
+        {
+            int axis = answer.questionId <= 2 ? 0 : answer.questionId <= 4 ? 1 : answer.questionId <= 6 ? 2 : 3;
+            double score = answer.selectedOption == 0 ? 0.8 : answer.selectedOption == 2 ? 0.2 : 0.5;
+            axes[axis] = (axes[axis] + score) / 2.0;
+        }
+        batch.extraversion[i] = axes[0];
+        batch.sensing[i] = axes[1];
+        batch.thinking[i] = axes[2];
+        batch.judging[i] = axes[3];
     }
-    result.confidence = std::min(1.0, totalConfidence / result.scores.size() * 2.0);
 
-    auto endTime = std::chrono::high_resolution_clock::now();
-    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(endTime - startTime);
+    // Then per set: its confidence and a 4-bit type code (E, S, T, J set),
+    // as determinePersonalityType() decides. Answers are scored one by one
+    // above, as for a single profile; the batch saves the per-set maps and
+    // generates one description per type
+    std::vector<uint8_t> codes(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        batch.confidence[i] = preferenceConfidence(batch.extraversion[i], batch.sensing[i],
+                                                   batch.thinking[i], batch.judging[i]);
+        codes[i] = static_cast<uint8_t>((batch.extraversion[i] > 1.0 - batch.extraversion[i]) << 3 |
+                                        (batch.sensing[i] > 1.0 - batch.sensing[i]) << 2 |
+                                        (batch.thinking[i] > 1.0 - batch.thinking[i]) << 1 |
+                                        (batch.judging[i] > 1.0 - batch.judging[i]));
+    }
 
-    result.analysisTimeMs = duration.count();
-    totalPersonalityAnalyses++;
+    // One description per distinct type, so at most 16 generations however
+    // large the batch
+    int slotOfCode[16];
+    std::fill(std::begin(slotOfCode), std::end(slotOfCode), -1);
+    for (size_t i = 0; i < count; ++i)
+    {
+        uint8_t code = codes[i];
+        if (slotOfCode[code] < 0)
+        {
+            PersonalityResult type;
+            type.aiGenerated = true;
+            type.personalityType = {(code & 8) ? 'E' : 'I', (code & 4) ? 'S' : 'N',
+                                    (code & 2) ? 'T' : 'F', (code & 1) ? 'J' : 'P'};
+            describePersonalityType(type, seed);
+            slotOfCode[code] = static_cast<int>(batch.types.size());
+            batch.types.push_back(std::move(type));
+        }
+        batch.typeIndex[i] = static_cast<uint8_t>(slotOfCode[code]);
+    }
 
-    std::cout << "✅ Personality analysis complete using dedicated model: " << result.personalityType
-              << " (" << result.title << ") in " << duration.count() << "ms" << std::endl;
+    auto endTime = std::chrono::high_resolution_clock::now();
+    batch.analysisTimeMs = std::chrono::duration_cast<std::chrono::milliseconds>(endTime - startTime).count();
+    totalPersonalityAnalyses += static_cast<int>(count);
 
-    return result;
+    std::cout << "✅ Batch personality analysis: " << count << " profiles, " << batch.types.size()
+              << " types in " << batch.analysisTimeMs << "ms" << std::endl;
+
+    return batch;
 }
 
 // Helper methods implementation (continued in next part due to length)
-std::string AIQuizGenerator::buildPsychologyPrompt(const std::string &trait, const std::string &category) const
+std::string AIQuizGenerator::buildPsychologyPrompt(const std::string &trait, const std::string &category,
+                                                  std::vector<std::string> *stops) const
 {
-    auto it = psychologyPromptTemplates.find(category);
-    if (it != psychologyPromptTemplates.end())
+    auto set = templates.snapshot();
+    if (const PsychologyTemplate *entry = set->findPsychology(category))
     {
-        return it->second;
+        if (stops)
+        {
+            stops->insert(stops->end(), entry->stop.begin(), entry->stop.end());
+        }
+        return entry->prompt;
     }
 
     // Fallback prompt
@@ -642,7 +2475,8 @@ std::string AIQuizGenerator::buildPsychologyPrompt(const std::string &trait, con
 
 QuizQuestion AIQuizGenerator::parseAIResponse(const std::string &response,
                                               const std::string &category,
-                                              const std::string &difficulty)
+                                              const std::string &difficulty,
+                                              std::mt19937_64 &rng)
 {
     QuizQuestion question;
     question.category = category;
@@ -664,14 +2498,21 @@ QuizQuestion AIQuizGenerator::parseAIResponse(const std::string &response,
     }
 
     // Extract correct answer
-    question.correctAnswerIndex = extractCorrectAnswer(response);
+    question.correctAnswerIndex = extractCorrectAnswer(response, rng);
     if (question.correctAnswerIndex < 0 || question.correctAnswerIndex > 2)
     {
         question.correctAnswerIndex = 0; // Default to first option
     }
 
     // Set difficulty modifiers
-    auto diffMod = difficultyModifiers.find(difficulty);
+    applyDifficultyModifiers(question);
+
+    return question;
+}
+
+void AIQuizGenerator::applyDifficultyModifiers(QuizQuestion &question) const
+{
+    auto diffMod = difficultyModifiers.find(question.difficulty);
     if (diffMod == difficultyModifiers.end())
     {
         diffMod = difficultyModifiers.find("Medium");
@@ -681,8 +2522,6 @@ QuizQuestion AIQuizGenerator::parseAIResponse(const std::string &response,
     question.wrongAnswerPriceMultiplier = diffMod->second.at("wrong");
     question.stealChance = diffMod->second.at("steal");
     question.stealPercentage = diffMod->second.at("amount");
-
-    return question;
 }
 
 PsychologicalQuestion AIQuizGenerator::parsePsychologyResponse(const std::string &response,
@@ -716,23 +2555,26 @@ PsychologicalQuestion AIQuizGenerator::parsePsychologyResponse(const std::string
 // Additional helper methods remain the same...
 std::string AIQuizGenerator::extractQuestion(const std::string &text) const
 {
-    std::regex question_regex(R"(Question:\s*([^?]+\?))");
+    // Compiled once: every candidate of every request is parsed with them
+    static const std::regex question_regex(R"(Question:\s*([^?]+\?))");
+    static const std::regex fallback_regex(R"(([^.!?]*\?))");
+    static const std::regex whitespace_regex(R"(\s+)");
+    static const std::regex edges_regex(R"(^\s+|\s+$)");
     std::smatch match;
 
     if (std::regex_search(text, match, question_regex))
     {
         std::string question = match[1].str();
-        question = std::regex_replace(question, std::regex(R"(\s+)"), " ");
-        question = std::regex_replace(question, std::regex(R"(^\s+|\s+$)"), "");
+        question = std::regex_replace(question, whitespace_regex, " ");
+        question = std::regex_replace(question, edges_regex, "");
         return question;
     }
 
-    std::regex fallback_regex(R"(([^.!?]*\?))");
     if (std::regex_search(text, match, fallback_regex))
     {
         std::string question = match[1].str();
-        question = std::regex_replace(question, std::regex(R"(\s+)"), " ");
-        question = std::regex_replace(question, std::regex(R"(^\s+|\s+$)"), "");
+        question = std::regex_replace(question, whitespace_regex, " ");
+        question = std::regex_replace(question, edges_regex, "");
         return question;
     }
 
@@ -740,48 +2582,61 @@ std::string AIQuizGenerator::extractQuestion(const std::string &text) const
 }
 
 std::vector<std::string> AIQuizGenerator::extractAnswers(const std::string &text) const
+{
+    std::vector<std::string> answers = extractRawAnswers(text);
+
+    while (answers.size() < 3)
+    {
+        answers.push_back("Option " + std::to_string(answers.size() + 1));
+    }
+
+    return std::vector<std::string>(answers.begin(), answers.begin() + 3);
+}
+
+std::vector<std::string> AIQuizGenerator::extractRawAnswers(const std::string &text) const
 {
     std::vector<std::string> answers;
 
-    std::regex answer_regex(R"([ABC]\)\s*([^AB\n]+))");
+    static const std::regex answer_regex(R"([ABC]\)\s*([^AB\n]+))");
+    static const std::regex whitespace_regex(R"(\s+)");
+    static const std::regex edges_regex(R"(^\s+|\s+$)");
+    static const std::regex trailing_regex(R"([,;]\s*$)");
     std::sregex_iterator iter(text.begin(), text.end(), answer_regex);
     std::sregex_iterator end;
 
     for (; iter != end; ++iter)
     {
         std::string answer = (*iter)[1].str();
-        answer = std::regex_replace(answer, std::regex(R"(\s+)"), " ");
-        answer = std::regex_replace(answer, std::regex(R"(^\s+|\s+$)"), "");
-        answer = std::regex_replace(answer, std::regex(R"([,;]\s*$)"), "");
+        answer = std::regex_replace(answer, whitespace_regex, " ");
+        answer = std::regex_replace(answer, edges_regex, "");
+        answer = std::regex_replace(answer, trailing_regex, "");
 
-        if (!answer.empty() && answers.size() < 3)
+        if (!answer.empty())
         {
             answers.push_back(answer);
         }
     }
 
-    while (answers.size() < 3)
-    {
-        answers.push_back("Option " + std::to_string(answers.size() + 1));
-    }
-
-    return std::vector<std::string>(answers.begin(), answers.begin() + 3);
+    return answers;
 }
 
 std::vector<std::string> AIQuizGenerator::extractPsychologyOptions(const std::string &text) const
 {
     std::vector<std::string> options;
 
-    std::regex option_regex(R"([ABC]\)\s*([^AB\n]+))");
+    static const std::regex option_regex(R"([ABC]\)\s*([^AB\n]+))");
+    static const std::regex whitespace_regex(R"(\s+)");
+    static const std::regex edges_regex(R"(^\s+|\s+$)");
+    static const std::regex trailing_regex(R"([,;]\s*$)");
     std::sregex_iterator iter(text.begin(), text.end(), option_regex);
     std::sregex_iterator end;
 
     for (; iter != end; ++iter)
     {
         std::string option = (*iter)[1].str();
-        option = std::regex_replace(option, std::regex(R"(\s+)"), " ");
-        option = std::regex_replace(option, std::regex(R"(^\s+|\s+$)"), "");
-        option = std::regex_replace(option, std::regex(R"([,;]\s*$)"), "");
+        option = std::regex_replace(option, whitespace_regex, " ");
+        option = std::regex_replace(option, edges_regex, "");
+        option = std::regex_replace(option, trailing_regex, "");
 
         if (!option.empty() && options.size() < 3)
         {
@@ -802,9 +2657,9 @@ std::vector<std::string> AIQuizGenerator::extractPsychologyOptions(const std::st
     return std::vector<std::string>(options.begin(), options.begin() + 3);
 }
 
-int AIQuizGenerator::extractCorrectAnswer(const std::string &text) const
+int AIQuizGenerator::extractCorrectAnswer(const std::string &text, std::mt19937_64 &rng) const
 {
-    std::regex answer_regex(R"(Answer:\s*([ABC]))");
+    static const std::regex answer_regex(R"(Answer:\s*([ABC]))");
     std::smatch match;
 
     if (std::regex_search(text, match, answer_regex))
@@ -813,10 +2668,9 @@ int AIQuizGenerator::extractCorrectAnswer(const std::string &text) const
         return answer_char - 'A';
     }
 
-    std::random_device rd;
-    std::mt19937 gen(rd());
+    // No answer line: guess from the caller's generator so seeded runs stay reproducible
     std::discrete_distribution<> dist({50, 30, 20});
-    return dist(gen);
+    return dist(rng);
 }
 
 std::unordered_map<std::string, double> AIQuizGenerator::calculateTraitScores(const std::vector<PersonalityAnswer> &answers) const
@@ -888,9 +2742,12 @@ std::string AIQuizGenerator::determinePersonalityType(const std::unordered_map<s
 }
 
 std::string AIQuizGenerator::generatePersonalityDescription(const std::string &personalityType,
-                                                            const std::unordered_map<std::string, double> &scores)
+                                                            const std::unordered_map<std::string, double> &scores,
+                                                            uint64_t seed, std::string &source)
 {
-    if (!isModelLoaded(analysisModel.get()))
+    source = "template";
+    ModelInstance *model = modelFor(GenerationRole::Analysis, personalityType);
+    if (!isModelLoaded(model))
     {
         auto it = personalityDescriptions.find(personalityType);
         if (it != personalityDescriptions.end())
@@ -903,7 +2760,26 @@ std::string AIQuizGenerator::generatePersonalityDescription(const std::string &p
     // Generate AI-powered description using dedicated analysis model
     std::string prompt = "Describe " + personalityType + " personality type. Key traits and characteristics:";
 
-    std::string aiDescription = generateText(analysisModel.get(), prompt);
+    // A cached description costs nothing; under overload it is that or the
+    // static text, never a place in the model's queue
+    GenerationParams params = generationDefaults(GenerationRole::Analysis);
+    std::vector<std::string> cached;
+    std::string aiDescription;
+    if (lookupCachedTexts(model, prompt, 1, params, seed, cached) && !cached.empty())
+    {
+        aiDescription = cached.front();
+        source = "cache";
+    }
+    else if (shouldShed(model))
+    {
+        totalShedRequests++;
+        std::cout << "🚦 Analysis model overloaded, using the static " << personalityType << " description" << std::endl;
+    }
+    else
+    {
+        aiDescription = generateText(model, prompt, params, seed);
+        source = "generated";
+    }
 
     // Clean and format the description
     if (!aiDescription.empty() && aiDescription.length() > 50)
@@ -912,6 +2788,7 @@ std::string AIQuizGenerator::generatePersonalityDescription(const std::string &p
     }
 
     // Fallback to static description
+    source = "template";
     auto it = personalityDescriptions.find(personalityType);
     return (it != personalityDescriptions.end()) ? it->second : "A distinctive personality type.";
 }
@@ -988,9 +2865,14 @@ std::vector<std::string> AIQuizGenerator::generateStrengthsAndGrowthAreas(const
 // Model management methods
 bool AIQuizGenerator::areModelsLoaded() const
 {
-    return isModelLoaded(quizModel.get()) &&
-           isModelLoaded(psychologyModel.get()) &&
-           isModelLoaded(analysisModel.get());
+    for (ModelInstance *instance : modelInstances())
+    {
+        if (!isModelLoaded(instance))
+        {
+            return false;
+        }
+    }
+    return true;
 }
 
 bool AIQuizGenerator::reloadModels()
@@ -1000,78 +2882,226 @@ bool AIQuizGenerator::reloadModels()
     std::cout << "🔄 Reloading all models..." << std::endl;
 
     // Clean up existing models
-    cleanupModel(quizModel.get());
-    cleanupModel(psychologyModel.get());
-    cleanupModel(analysisModel.get());
+    for (ModelInstance *instance : modelInstances())
+    {
+        cleanupModel(instance);
+    }
 
     // Reinitialize models
-    bool success = true;
-    success &= initializeModel(quizModel.get(), quizModel->modelPath, "Quiz-Model");
-    success &= initializeModel(psychologyModel.get(), psychologyModel->modelPath, "Psychology-Model");
-    success &= initializeModel(analysisModel.get(), analysisModel->modelPath, "Analysis-Model");
-
-    return success;
+    return loadModels();
 }
 
 std::vector<std::string> AIQuizGenerator::getLoadedModels() const
 {
     std::vector<std::string> loadedModels;
 
-    if (isModelLoaded(quizModel.get()))
+    for (ModelInstance *instance : modelInstances())
     {
-        loadedModels.push_back("Quiz-Model (" + std::to_string(quizModel->usageCount.load()) + " uses)");
+        if (isModelLoaded(instance))
+        {
+            loadedModels.push_back(instance->modelName + " (" + std::to_string(instance->usageCount.load()) + " uses)");
+        }
     }
 
-    if (isModelLoaded(psychologyModel.get()))
-    {
-        loadedModels.push_back("Psychology-Model (" + std::to_string(psychologyModel->usageCount.load()) + " uses)");
-    }
+    return loadedModels;
+}
 
-    if (isModelLoaded(analysisModel.get()))
+std::vector<std::string> AIQuizGenerator::getModelNames() const
+{
+    std::vector<std::string> names;
+    for (ModelInstance *instance : modelInstances())
     {
-        loadedModels.push_back("Analysis-Model (" + std::to_string(analysisModel->usageCount.load()) + " uses)");
+        names.push_back(instance->modelName);
     }
+    return names;
+}
 
-    return loadedModels;
+std::string AIQuizGenerator::getModelName(GenerationRole task) const
+{
+    return modelFor(task, "")->modelName;
 }
 
 void AIQuizGenerator::setTemperature(float temp)
 {
-    temperature = std::max(0.1f, std::min(1.5f, temp)); // Reduced range for small models
+    float clamped = std::max(0.1f, std::min(1.5f, temp)); // Reduced range for small models
+    std::string error;
+    updateGenerationSettings([clamped](GenerationSettings &settings, std::string &)
+                             {
+                                 for (auto &role : settings.roles)
+                                 {
+                                     role.defaults.temperature = std::min(clamped, role.limits.maxTemperature);
+                                 }
+                                 return true; },
+                             error);
 }
 
 void AIQuizGenerator::setMaxTokens(int tokens)
 {
-    maxTokens = std::max(32, std::min(256, tokens)); // Reduced for small models
+    int clamped = std::max(32, std::min(256, tokens)); // Reduced for small models
+    std::string error;
+    updateGenerationSettings([clamped](GenerationSettings &settings, std::string &)
+                             {
+                                 for (auto &role : settings.roles)
+                                 {
+                                     role.defaults.maxTokens = std::min(clamped, role.limits.maxTokens);
+                                 }
+                                 return true; },
+                             error);
 }
 
 void AIQuizGenerator::setContextSize(int size)
 {
-    contextSize = std::max(512, std::min(2048, size)); // Reduced for small models
+    contextSize = std::max(512, std::min(2048, size)); // Reduced for small models; applies on the next model load
+}
+
+std::shared_ptr<const GenerationSettings> AIQuizGenerator::getGenerationSettings() const
+{
+    return std::atomic_load(&generationSettings);
+}
+
+GenerationParams AIQuizGenerator::generationDefaults(GenerationRole role) const
+{
+    return getGenerationSettings()->forRole(role).defaults;
+}
+
+bool AIQuizGenerator::validateGenerationParams(GenerationRole role, const GenerationParams &params,
+                                               std::string &error) const
+{
+    return ::validateGenerationParams(params, getGenerationSettings()->forRole(role).limits, error);
+}
+
+bool AIQuizGenerator::updateGenerationSettings(const std::function<bool(GenerationSettings &, std::string &)> &edit,
+                                               std::string &error)
+{
+    // Edits are applied to a private copy and published whole, so requests
+    // read either the old or the new settings and concurrent edits serialize
+    std::lock_guard<std::mutex> lock(settingsMutex);
+
+    auto updated = std::make_shared<GenerationSettings>(*getGenerationSettings());
+    if (!edit(*updated, error))
+    {
+        return false;
+    }
+
+    for (size_t i = 0; i < kGenerationRoleCount; ++i)
+    {
+        const auto &role = updated->roles[i];
+        std::string roleError;
+        if (!validateGenerationLimits(role.limits, roleError) ||
+            !::validateGenerationParams(role.defaults, role.limits, roleError))
+        {
+            error = std::string(generationRoleName(static_cast<GenerationRole>(i))) + ": " + roleError;
+            return false;
+        }
+    }
+
+    std::atomic_store(&generationSettings, std::shared_ptr<const GenerationSettings>(std::move(updated)));
+    return true;
 }
 
 std::vector<std::string> AIQuizGenerator::getCategories() const
 {
-    return {"Science", "Technology", "Mathematics", "Engineering"};
+    std::vector<std::string> categories;
+    for (const auto &category : templates.snapshot()->categories)
+    {
+        categories.push_back(category.name);
+    }
+    return categories;
 }
 
 std::vector<std::string> AIQuizGenerator::getDifficulties() const
 {
-    return {"Easy", "Medium", "Hard"};
+    return templates.snapshot()->difficulties;
 }
 
 std::unordered_map<std::string, std::vector<std::string>> AIQuizGenerator::getCategoriesMap() const
 {
     std::unordered_map<std::string, std::vector<std::string>> result;
 
-    result["Science"] = {"Physics", "Chemistry", "Biology", "Earth Science"};
-    result["Technology"] = {"Programming", "Computer Science", "AI", "Networking"};
-    result["Mathematics"] = {"Algebra", "Geometry", "Calculus", "Statistics"};
-    result["Engineering"] = {"Civil", "Mechanical", "Electrical", "Software"};
+    for (const auto &category : templates.snapshot()->categories)
+    {
+        result[category.name] = category.subcategories;
+    }
 
     return result;
 }
 
+bool AIQuizGenerator::loadTemplates(const std::string &path, bool watch)
+{
+    return templates.load(path, watch);
+}
+
+void AIQuizGenerator::setTemplatesChangedCallback(std::function<void()> callback)
+{
+    std::lock_guard<std::mutex> lock(managerMutex);
+    templatesChanged = std::move(callback);
+}
+
+void AIQuizGenerator::onTemplatesReloaded(const TemplateSet &previous, const TemplateSet &current)
+{
+    // Only prompts whose text changed or disappeared lose their cached
+    // tokens; everything else stays warm across the reload
+    std::vector<std::string> currentPrompts = current.allPrompts();
+    std::unordered_set<std::string> live(currentPrompts.begin(), currentPrompts.end());
+    std::vector<std::string> stale;
+    for (auto &prompt : previous.allPrompts())
+    {
+        if (live.count(prompt) == 0)
+        {
+            stale.push_back(std::move(prompt));
+        }
+    }
+
+    size_t droppedTokens = 0;
+    for (ModelInstance *instance : modelInstances())
+    {
+        std::lock_guard<std::mutex> lock(instance->modelMutex);
+        for (const auto &prompt : stale)
+        {
+            droppedTokens += instance->tokenCache.erase(prompt);
+        }
+    }
+
+    // Pre-generated questions came from the old prompt of their key
+    size_t droppedQuestions = 0;
+    {
+        std::lock_guard<std::mutex> lock(poolMutex);
+        for (auto it = questionPool.begin(); it != questionPool.end();)
+        {
+            size_t split = it->first.find('/');
+            std::string category = it->first.substr(0, split);
+            std::string difficulty = it->first.substr(split + 1);
+
+            const std::string *before = previous.findQuizPrompt(category, difficulty);
+            const std::string *after = current.findQuizPrompt(category, difficulty);
+            if (!after || !before || *before != *after ||
+                previous.findCategory(category)->stop != current.findCategory(category)->stop)
+            {
+                droppedQuestions += it->second.size();
+                it = questionPool.erase(it);
+            }
+            else
+            {
+                ++it;
+            }
+        }
+    }
+
+    std::cout << "🔄 Templates v" << current.version << ": " << stale.size() << " prompts changed, "
+              << droppedTokens << " tokenizations and " << droppedQuestions
+              << " pre-generated questions invalidated" << std::endl;
+
+    std::function<void()> callback;
+    {
+        std::lock_guard<std::mutex> lock(managerMutex);
+        callback = templatesChanged;
+    }
+    if (callback)
+    {
+        callback();
+    }
+}
+
 std::vector<std::string> AIQuizGenerator::getPersonalityTraits() const
 {
     return {"Extroversion/Introversion", "Sensing/Intuition", "Thinking/Feeling", "Judging/Perceiving"};
@@ -1127,51 +3157,48 @@ std::string AIQuizGenerator::getModelInfo() const
 
     info << "Multi-Model Architecture:\n";
 
-    if (isModelLoaded(quizModel.get()))
-    {
-        char buf[128];
-        llama_model_desc(quizModel->model, buf, sizeof(buf));
-        info << "Quiz Model: " << buf << " (Uses: " << quizModel->usageCount.load() << ")\n";
-    }
-
-    if (isModelLoaded(psychologyModel.get()))
-    {
-        char buf[128];
-        llama_model_desc(psychologyModel->model, buf, sizeof(buf));
-        info << "Psychology Model: " << buf << " (Uses: " << psychologyModel->usageCount.load() << ")\n";
-    }
-
-    if (isModelLoaded(analysisModel.get()))
+    for (ModelInstance *instance : modelInstances())
     {
-        char buf[128];
-        llama_model_desc(analysisModel->model, buf, sizeof(buf));
-        info << "Analysis Model: " << buf << " (Uses: " << analysisModel->usageCount.load() << ")\n";
+        if (isModelLoaded(instance))
+        {
+            char buf[128];
+            llama_model_desc(instance->model, buf, sizeof(buf));
+            info << instance->modelName << ": " << buf << " (Uses: " << instance->usageCount.load() << ")";
+            std::lock_guard<std::mutex> lock(instance->modelMutex);
+            if (instance->tuning)
+            {
+                info << " [tuned: " << instance->tuning->threads << " threads, batch " << instance->tuning->batchSize
+                     << "/" << instance->tuning->ubatchSize << "]";
+            }
+            info << "\n";
+        }
     }
 
+    GenerationParams quizDefaults = generationDefaults(GenerationRole::Quiz);
     info << "Context size: " << contextSize << "\n";
-    info << "Max tokens: " << maxTokens << "\n";
-    info << "Temperature: " << temperature;
+    info << "Max tokens: " << quizDefaults.maxTokens << "\n";
+    info << "Temperature: " << quizDefaults.temperature;
 
     return info.str();
 }
 
+std::string AIQuizGenerator::getBackendInfo() const
+{
+    return llama_print_system_info();
+}
+
 size_t AIQuizGenerator::getModelMemoryUsage() const
 {
     size_t totalUsage = 0;
 
-    if (isModelLoaded(quizModel.get()))
+    // Shared weights count once
+    std::unordered_set<const llama_model *> counted;
+    for (ModelInstance *instance : modelInstances())
     {
-        totalUsage += llama_model_size(quizModel->model);
-    }
-
-    if (isModelLoaded(psychologyModel.get()))
-    {
-        totalUsage += llama_model_size(psychologyModel->model);
-    }
-
-    if (isModelLoaded(analysisModel.get()))
-    {
-        totalUsage += llama_model_size(analysisModel->model);
+        if (isModelLoaded(instance) && counted.insert(instance->model).second)
+        {
+            totalUsage += llama_model_size(instance->model);
+        }
     }
 
     return totalUsage;
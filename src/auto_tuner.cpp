@@ -0,0 +1,200 @@
+#include "auto_tuner.h"
+#include "resource_limits.h"
+#include "generation_params.h"
+#include <jsoncpp/json/json.h>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <filesystem>
+#include <chrono>
+#include <cstdio>
+
+namespace {
+
+// The head of a GGUF file holds its metadata and tensor index, so together
+// with the size it tells model files apart without reading the weights
+const size_t kFingerprintBytes = 4 * 1024 * 1024;
+
+// FNV-1a, stable across builds
+uint64_t fnv1a(const char* data, size_t size, uint64_t hash = 14695981039346656037ull) {
+    for (size_t i = 0; i < size; ++i) {
+        hash = (hash ^ static_cast<unsigned char>(data[i])) * 1099511628211ull;
+    }
+    return hash;
+}
+
+std::string cpuModel() {
+    std::ifstream cpuinfo("/proc/cpuinfo");
+    std::string line;
+    while (std::getline(cpuinfo, line)) {
+        // x86 "model name", POWER "cpu", others "Hardware"
+        size_t colon = line.find(':');
+        if (colon == std::string::npos) {
+            continue;
+        }
+        std::string key = line.substr(0, line.find_last_not_of(" \t", colon - 1) + 1);
+        if (key == "model name" || key == "cpu" || key == "Hardware") {
+            size_t start = line.find_first_not_of(" \t", colon + 1);
+            return start == std::string::npos ? "" : line.substr(start);
+        }
+    }
+    return "unknown CPU";
+}
+
+// Estimated seconds for one request: an average prompt, then a full decode
+double requestSeconds(const BenchResult& result, size_t prompts) {
+    if (result.prefillTokensPerSec <= 0 || result.decodeTokensPerSec <= 0 || prompts == 0) {
+        return -1;
+    }
+    double promptTokens = static_cast<double>(result.promptTokens) / prompts;
+    return promptTokens / result.prefillTokensPerSec + GenerationParams{}.maxTokens / result.decodeTokensPerSec;
+}
+
+} // namespace
+
+AutoTuner::AutoTuner(const AutoTuneConfig& config) : config(config) {
+    if (this->config.threadCounts.empty()) {
+        int cpus = ResourceLimits::current().cpuCount();
+        this->config.threadCounts = {std::max(1, cpus / 4), std::max(1, cpus / 2), cpus};
+    }
+    load();
+}
+
+std::string AutoTuner::hostKey() {
+    return cpuModel() + " x" + std::to_string(ResourceLimits::current().cpuCount());
+}
+
+std::string AutoTuner::modelKey(const std::string& path) {
+    std::error_code ec;
+    uint64_t size = std::filesystem::file_size(path, ec);
+    std::string sizeText = std::to_string(ec ? 0 : size);
+    uint64_t hash = fnv1a(sizeText.data(), sizeText.size());
+
+    std::ifstream file(path, std::ios::binary);
+    std::vector<char> head(kFingerprintBytes);
+    file.read(head.data(), head.size());
+    hash = fnv1a(head.data(), static_cast<size_t>(file.gcount()), hash);
+
+    char fingerprint[17];
+    snprintf(fingerprint, sizeof(fingerprint), "%016llx", static_cast<unsigned long long>(hash));
+    return fingerprint;
+}
+
+bool AutoTuner::tune(llama_model* model, const std::string& path, const std::vector<std::string>& prompts,
+                     TunedSettings& settings) {
+    const std::string key = hostKey() + "|" + modelKey(path);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto cached = entries.find(key);
+        if (!config.retune && cached != entries.end()) {
+            settings = cached->second;
+            return true;
+        }
+    }
+
+    std::vector<std::string> sample(prompts.begin(), prompts.begin() + std::min(config.prompts, prompts.size()));
+    BenchConfig grid;
+    grid.threadCounts = config.threadCounts;
+    grid.batchSizes = config.batchSizes;
+    grid.ubatchSizes = config.ubatchSizes;
+    grid.decodeTokens = config.decodeTokens;
+    grid.contextSize = config.contextSize;
+
+    std::cout << "⏱️ Tuning " << path << " for " << hostKey() << "..." << std::endl;
+    auto start = std::chrono::steady_clock::now();
+    std::vector<BenchResult> results;
+    ModelBench bench(grid);
+    if (!bench.benchWeights(model, path, sample, results)) {
+        return false;
+    }
+
+    // Fastest first; on a tie, fewer threads leave more CPU to the others
+    const BenchResult* best = nullptr;
+    double bestSeconds = 0;
+    for (const auto& result : results) {
+        double seconds = requestSeconds(result, sample.size());
+        if (seconds > 0 && (!best || seconds < bestSeconds ||
+                            (seconds == bestSeconds && result.threads < best->threads))) {
+            best = &result;
+            bestSeconds = seconds;
+        }
+    }
+    if (!best) {
+        std::cerr << "❌ Tuning measured nothing for " << path << std::endl;
+        return false;
+    }
+
+    settings.threads = best->threads;
+    settings.batchSize = best->batchSize;
+    settings.ubatchSize = best->ubatchSize;
+    settings.prefillTokensPerSec = best->prefillTokensPerSec;
+    settings.decodeTokensPerSec = best->decodeTokensPerSec;
+    std::cout << "⏱️ Tuned in " << std::chrono::duration_cast<std::chrono::milliseconds>(
+                                          std::chrono::steady_clock::now() - start).count()
+              << " ms" << std::endl;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    entries[key] = settings;
+    if (!save()) {
+        std::cerr << "⚠️ Failed to save tuning results to " << config.cachePath << std::endl;
+    }
+    return true;
+}
+
+bool AutoTuner::load() {
+    std::ifstream file(config.cachePath);
+    if (!file) {
+        return false;
+    }
+    Json::Value root;
+    Json::CharReaderBuilder builder;
+    std::string error;
+    if (!Json::parseFromStream(builder, file, &root, &error) || !root["entries"].isObject()) {
+        std::cerr << "⚠️ Ignoring unreadable tuning cache " << config.cachePath << std::endl;
+        return false;
+    }
+
+    const Json::Value& stored = root["entries"];
+    for (const auto& key : stored.getMemberNames()) {
+        const Json::Value& entry = stored[key];
+        TunedSettings settings;
+        settings.threads = entry.get("threads", 0).asInt();
+        settings.batchSize = entry.get("batchSize", 0).asInt();
+        settings.ubatchSize = entry.get("ubatchSize", 0).asInt();
+        settings.prefillTokensPerSec = entry.get("prefillTokensPerSec", 0.0).asDouble();
+        settings.decodeTokensPerSec = entry.get("decodeTokensPerSec", 0.0).asDouble();
+        if (settings.threads > 0 && settings.batchSize > 0 && settings.ubatchSize > 0 &&
+            settings.ubatchSize <= settings.batchSize) {
+            entries[key] = settings;
+        }
+    }
+    return true;
+}
+
+bool AutoTuner::save() const {
+    // Entries for other hosts are kept, so one file can serve a fleet
+    Json::Value root;
+    root["entries"] = Json::Value(Json::objectValue);
+    for (const auto& [key, settings] : entries) {
+        Json::Value entry;
+        entry["threads"] = settings.threads;
+        entry["batchSize"] = settings.batchSize;
+        entry["ubatchSize"] = settings.ubatchSize;
+        entry["prefillTokensPerSec"] = settings.prefillTokensPerSec;
+        entry["decodeTokensPerSec"] = settings.decodeTokensPerSec;
+        root["entries"][key] = entry;
+    }
+
+    std::string tmpPath = config.cachePath + ".tmp";
+    {
+        std::ofstream out(tmpPath);
+        Json::StreamWriterBuilder builder;
+        builder["indentation"] = "  ";
+        out << Json::writeString(builder, root) << std::endl;
+        if (!out) {
+            return false;
+        }
+    }
+    return std::rename(tmpPath.c_str(), config.cachePath.c_str()) == 0;
+}
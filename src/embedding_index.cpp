@@ -0,0 +1,256 @@
+#include "embedding_index.h"
+#include "simd_kernels.h"
+#include <iostream>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <mutex>
+#include <queue>
+#include <unistd.h>
+
+namespace {
+
+const uint8_t kRecordVersion = 1;
+
+// version, model tag, dimensions, id, key, scale
+const size_t kRecordHeaderSize = 1 + 8 + 4 + 8 + 4 + 4;
+
+template <typename T>
+void put(std::string& out, T value) {
+    out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+template <typename T>
+T get(const std::string& payload, size_t& pos) {
+    T value;
+    std::memcpy(&value, payload.data() + pos, sizeof(value));
+    pos += sizeof(value);
+    return value;
+}
+
+} // namespace
+
+EmbeddingIndex::~EmbeddingIndex() {
+    close();
+}
+
+bool EmbeddingIndex::open(const std::string& path, size_t dimensions, uint64_t modelTag) {
+    std::unique_lock<std::shared_mutex> lock(mutex);
+
+    if (log.isOpen()) {
+        log.close();
+    }
+    dims = dimensions;
+    tag = modelTag;
+    clearLocked();
+
+    if (path.empty()) {
+        return true;
+    }
+
+    std::string logPath = path + ".log";
+    size_t stale = 0;
+    auto replay = [this, &stale](uint64_t, const std::string& payload) {
+        size_t pos = 0;
+        if (payload.size() != kRecordHeaderSize + dims || get<uint8_t>(payload, pos) != kRecordVersion ||
+            get<uint64_t>(payload, pos) != tag || get<uint32_t>(payload, pos) != dims) {
+            stale++;
+            return;
+        }
+        uint64_t id = get<uint64_t>(payload, pos);
+        uint32_t key = get<uint32_t>(payload, pos);
+        float scale = get<float>(payload, pos);
+        if (!idSet.count(id)) {
+            insertLocked(id, key, reinterpret_cast<const int8_t*>(payload.data() + pos), scale);
+        }
+    };
+
+    if (!log.open(logPath, 0, replay)) {
+        std::cerr << "❌ Failed to open embedding index: " << logPath << std::endl;
+        return false;
+    }
+
+    // Vectors from another model (or dimension) can never match again;
+    // start the log over rather than replaying them on every start
+    if (stale > 0) {
+        log.close();
+        ::unlink(logPath.c_str());
+        clearLocked();
+        if (!log.open(logPath)) {
+            std::cerr << "❌ Failed to recreate embedding index: " << logPath << std::endl;
+            return false;
+        }
+        std::cout << "🧭 Embedding model changed, discarded " << stale << " stored vectors" << std::endl;
+    }
+    return true;
+}
+
+void EmbeddingIndex::close() {
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    if (log.isOpen()) {
+        log.sync();
+        log.close();
+    }
+}
+
+void EmbeddingIndex::clearLocked() {
+    codes.clear();
+    scales.clear();
+    ids.clear();
+    keys.clear();
+    rowsByKey.clear();
+    idSet.clear();
+}
+
+void EmbeddingIndex::normalize(std::vector<float>& vector) {
+    double norm = 0.0;
+    for (float component : vector) {
+        norm += static_cast<double>(component) * component;
+    }
+    if (norm > 0.0) {
+        float inverse = static_cast<float>(1.0 / std::sqrt(norm));
+        for (float& component : vector) {
+            component *= inverse;
+        }
+    }
+}
+
+float EmbeddingIndex::quantize(const std::vector<float>& vector, std::vector<int8_t>& out) {
+    // Symmetric per-vector scale: the largest component maps to +-127
+    float maxAbs = 0.0f;
+    for (float component : vector) {
+        maxAbs = std::max(maxAbs, std::fabs(component));
+    }
+    float scale = maxAbs > 0.0f ? maxAbs / 127.0f : 1.0f;
+
+    out.resize(vector.size());
+    for (size_t i = 0; i < vector.size(); ++i) {
+        out[i] = static_cast<int8_t>(std::lround(std::clamp(vector[i] / scale, -127.0f, 127.0f)));
+    }
+    return scale;
+}
+
+std::string EmbeddingIndex::serialize(uint64_t id, uint32_t key, const int8_t* rowCodes, float scale) const {
+    std::string out;
+    out.reserve(kRecordHeaderSize + dims);
+    put<uint8_t>(out, kRecordVersion);
+    put<uint64_t>(out, tag);
+    put<uint32_t>(out, static_cast<uint32_t>(dims));
+    put<uint64_t>(out, id);
+    put<uint32_t>(out, key);
+    put<float>(out, scale);
+    out.append(reinterpret_cast<const char*>(rowCodes), dims);
+    return out;
+}
+
+void EmbeddingIndex::insertLocked(uint64_t id, uint32_t key, const int8_t* rowCodes, float scale) {
+    codes.insert(codes.end(), rowCodes, rowCodes + dims);
+    scales.push_back(scale);
+    ids.push_back(id);
+    keys.push_back(key);
+    rowsByKey[key].push_back(static_cast<uint32_t>(ids.size() - 1));
+    idSet.insert(id);
+}
+
+bool EmbeddingIndex::add(uint64_t id, uint32_t key, const std::vector<float>& embedding) {
+    if (embedding.size() != dims || dims == 0) {
+        return false;
+    }
+
+    std::vector<float> unit = embedding;
+    normalize(unit);
+    std::vector<int8_t> rowCodes;
+    float scale = quantize(unit, rowCodes);
+
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    if (idSet.count(id)) {
+        return true;
+    }
+
+    uint64_t offset;
+    if (log.isOpen() && !log.append(serialize(id, key, rowCodes.data(), scale), offset)) {
+        return false;
+    }
+    insertLocked(id, key, rowCodes.data(), scale);
+    return true;
+}
+
+bool EmbeddingIndex::contains(uint64_t id) const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    return idSet.count(id) > 0;
+}
+
+std::vector<EmbeddingIndex::Match> EmbeddingIndex::search(const std::vector<float>& query, size_t k,
+                                                          const std::vector<uint32_t>& allowedKeys,
+                                                          float minSimilarity) const {
+    std::vector<Match> matches;
+    if (query.size() != dims || dims == 0 || k == 0) {
+        return matches;
+    }
+
+    std::vector<float> unit = query;
+    normalize(unit);
+    std::vector<int8_t> queryCodes;
+    float queryScale = quantize(unit, queryCodes);
+
+    // Min-heap of the best k so far, worst on top
+    auto worse = [](const Match& a, const Match& b) { return a.similarity > b.similarity; };
+    std::priority_queue<Match, std::vector<Match>, decltype(worse)> best(worse);
+
+    auto consider = [&](size_t row) {
+        float similarity = similarityLocked(row, queryCodes.data(), queryScale);
+        if (similarity < minSimilarity) {
+            return;
+        }
+        if (best.size() < k) {
+            best.push(Match{ids[row], keys[row], similarity});
+        } else if (similarity > best.top().similarity) {
+            best.pop();
+            best.push(Match{ids[row], keys[row], similarity});
+        }
+    };
+
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    if (allowedKeys.empty()) {
+        for (size_t row = 0; row < ids.size(); ++row) {
+            consider(row);
+        }
+    } else {
+        for (uint32_t key : allowedKeys) {
+            auto it = rowsByKey.find(key);
+            if (it != rowsByKey.end()) {
+                for (uint32_t row : it->second) {
+                    consider(row);
+                }
+            }
+        }
+    }
+
+    matches.resize(best.size());
+    for (size_t i = matches.size(); i-- > 0;) {
+        matches[i] = best.top();
+        best.pop();
+    }
+    return matches;
+}
+
+float EmbeddingIndex::similarityLocked(size_t row, const int8_t* queryCodes, float queryScale) const {
+    int32_t dot = simdKernels().dotInt8(queryCodes, codes.data() + row * dims, dims);
+    return static_cast<float>(dot) * queryScale * scales[row];
+}
+
+bool EmbeddingIndex::flush() {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    return !log.isOpen() || log.sync();
+}
+
+size_t EmbeddingIndex::size() const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    return ids.size();
+}
+
+size_t EmbeddingIndex::memoryBytes() const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    return codes.capacity() + scales.capacity() * sizeof(float) + ids.capacity() * sizeof(uint64_t) +
+           keys.capacity() * sizeof(uint32_t) + ids.size() * sizeof(uint32_t) + idSet.size() * (sizeof(uint64_t) + 2 * sizeof(void*));
+}
@@ -0,0 +1,290 @@
+#include "generation_cache.h"
+#include <iostream>
+#include <cstring>
+#include <cstdio>
+#include <functional>
+#include <unistd.h>
+
+namespace {
+
+const uint8_t kRecordVersion = 1;
+
+// Compact the backing log once it holds this many times the cache budget
+const uint64_t kCompactionFactor = 4;
+
+void putU32(std::string& out, uint32_t value) {
+    out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+void putString(std::string& out, const std::string& value) {
+    putU32(out, static_cast<uint32_t>(value.size()));
+    out.append(value);
+}
+
+bool getU32(const std::string& in, size_t& pos, uint32_t& value) {
+    if (pos + sizeof(value) > in.size()) {
+        return false;
+    }
+    std::memcpy(&value, in.data() + pos, sizeof(value));
+    pos += sizeof(value);
+    return true;
+}
+
+bool getString(const std::string& in, size_t& pos, std::string& value) {
+    uint32_t length;
+    if (!getU32(in, pos, length) || pos + length > in.size()) {
+        return false;
+    }
+    value.assign(in, pos, length);
+    pos += length;
+    return true;
+}
+
+} // namespace
+
+GenerationCache::GenerationCache(const GenerationCacheConfig& config) : config(config) {}
+
+std::string GenerationCache::makeKey(const std::string& model, const std::string& prompt, int count,
+                                     const GenerationParams& params, uint64_t seed) {
+    // Everything that can change the decoded text goes into the key
+    std::string key;
+    key.reserve(model.size() + prompt.size() + 64);
+    key.append(model);
+    key.push_back('\0');
+    key.append(std::to_string(count)).push_back('|');
+    key.append(std::to_string(params.temperature)).push_back('|');
+    key.append(std::to_string(params.maxTokens)).push_back('|');
+    key.append(std::to_string(params.topK)).push_back('|');
+    key.append(std::to_string(params.topP)).push_back('|');
+    for (const auto& stop : params.stop) {
+        putString(key, stop);
+    }
+    key.push_back('|');
+    key.append(std::to_string(seed)).push_back('\0');
+    key.append(prompt);
+    return key;
+}
+
+size_t GenerationCache::entryBytes(const std::string& key, const std::vector<std::string>& value) {
+    // Payload plus a rough allowance for list node, index slot and string headers
+    size_t bytes = key.size() + sizeof(Entry) + 64;
+    for (const auto& text : value) {
+        bytes += text.size() + sizeof(std::string);
+    }
+    return bytes;
+}
+
+GenerationCache::Shard& GenerationCache::shardFor(const std::string& key) {
+    return shards[std::hash<std::string>{}(key) % kShards];
+}
+
+bool GenerationCache::get(const std::string& key, std::vector<std::string>& value) {
+    if (!isEnabled()) {
+        return false;
+    }
+
+    Shard& shard = shardFor(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+
+    auto it = shard.index.find(key);
+    if (it == shard.index.end()) {
+        misses++;
+        return false;
+    }
+
+    shard.lru.splice(shard.lru.begin(), shard.lru, it->second);
+    value = it->second->value;
+    hits++;
+    return true;
+}
+
+bool GenerationCache::insert(const std::string& key, const std::vector<std::string>& value) {
+    const size_t shardBudget = config.maxBytes / kShards;
+    const size_t bytes = entryBytes(key, value);
+    if (bytes > shardBudget) {
+        return false; // Would evict the whole shard for one entry
+    }
+
+    Shard& shard = shardFor(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+
+    auto existing = shard.index.find(key);
+    if (existing != shard.index.end()) {
+        // Same inputs give the same output; just refresh recency
+        shard.lru.splice(shard.lru.begin(), shard.lru, existing->second);
+        return false;
+    }
+
+    while (!shard.lru.empty() && shard.bytes + bytes > shardBudget) {
+        Entry& victim = shard.lru.back();
+        shard.bytes -= victim.bytes;
+        shard.index.erase(victim.key);
+        shard.lru.pop_back();
+        evictions++;
+    }
+
+    shard.lru.push_front(Entry{key, value, bytes});
+    shard.index.emplace(shard.lru.front().key, shard.lru.begin());
+    shard.bytes += bytes;
+    insertions++;
+    return true;
+}
+
+void GenerationCache::put(const std::string& key, const std::vector<std::string>& value) {
+    if (!isEnabled() || !insert(key, value)) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(logMutex);
+    if (log.isOpen()) {
+        uint64_t offset;
+        log.append(serialize(key, value), offset);
+    }
+}
+
+std::string GenerationCache::serialize(const std::string& key, const std::vector<std::string>& value) {
+    std::string out;
+    out.push_back(static_cast<char>(kRecordVersion));
+    putString(out, key);
+    putU32(out, static_cast<uint32_t>(value.size()));
+    for (const auto& text : value) {
+        putString(out, text);
+    }
+    return out;
+}
+
+bool GenerationCache::deserialize(const std::string& payload, std::string& key, std::vector<std::string>& value) {
+    if (payload.empty() || static_cast<uint8_t>(payload[0]) != kRecordVersion) {
+        return false;
+    }
+
+    size_t pos = 1;
+    uint32_t count;
+    if (!getString(payload, pos, key) || !getU32(payload, pos, count)) {
+        return false;
+    }
+
+    value.assign(count, std::string());
+    for (auto& text : value) {
+        if (!getString(payload, pos, text)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool GenerationCache::open() {
+    if (config.path.empty() || !isEnabled()) {
+        return true;
+    }
+
+    std::lock_guard<std::mutex> lock(logMutex);
+
+    // Replaying in append order through the LRU leaves the most recent
+    // entries resident when the log holds more than the budget
+    size_t loaded = 0;
+    bool opened = log.open(config.path + ".log", 0,
+                           [this, &loaded](uint64_t, const std::string& payload) {
+        std::string key;
+        std::vector<std::string> value;
+        if (deserialize(payload, key, value) && insert(key, value)) {
+            loaded++;
+        }
+    });
+    if (!opened) {
+        return false;
+    }
+
+    // Loading is not a cache hit or insertion from the caller's point of view
+    insertions = 0;
+    evictions = 0;
+
+    std::cout << "🗃️ Generation cache opened: " << loaded << " entries from " << config.path << ".log" << std::endl;
+
+    if (log.size() > kCompactionFactor * config.maxBytes) {
+        return compact();
+    }
+    return true;
+}
+
+bool GenerationCache::compact() {
+    // Caller holds logMutex. Write the live entries, oldest first, to a
+    // fresh log and swap it in; the old log stays valid until the rename
+    std::string logPath = config.path + ".log";
+    std::string tmpPath = logPath + ".tmp";
+    ::unlink(tmpPath.c_str());
+
+    RecordLog fresh;
+    if (!fresh.open(tmpPath)) {
+        return false;
+    }
+
+    uint64_t offset;
+    size_t written = 0;
+    for (auto& shard : shards) {
+        std::lock_guard<std::mutex> shardLock(shard.mutex);
+        for (auto it = shard.lru.rbegin(); it != shard.lru.rend(); ++it) {
+            if (!fresh.append(serialize(it->key, it->value), offset)) {
+                fresh.close();
+                ::unlink(tmpPath.c_str());
+                return false;
+            }
+            written++;
+        }
+    }
+
+    uint64_t freshSize = fresh.size();
+    if (!fresh.sync()) {
+        fresh.close();
+        ::unlink(tmpPath.c_str());
+        return false;
+    }
+    fresh.close();
+
+    uint64_t oldSize = log.size();
+    log.close();
+    if (std::rename(tmpPath.c_str(), logPath.c_str()) != 0) {
+        std::cerr << "❌ Failed to replace generation cache log: " << logPath << std::endl;
+        ::unlink(tmpPath.c_str());
+        return log.open(logPath, oldSize);
+    }
+
+    std::cout << "🗜️ Compacted generation cache log: " << oldSize << " -> " << freshSize
+              << " bytes (" << written << " entries)" << std::endl;
+    return log.open(logPath, freshSize);
+}
+
+bool GenerationCache::flush() {
+    std::lock_guard<std::mutex> lock(logMutex);
+    if (!log.isOpen()) {
+        return true;
+    }
+
+    if (log.size() > kCompactionFactor * config.maxBytes) {
+        return compact();
+    }
+    return log.sync();
+}
+
+void GenerationCache::close() {
+    std::lock_guard<std::mutex> lock(logMutex);
+    if (log.isOpen()) {
+        log.sync();
+        log.close();
+    }
+}
+
+GenerationCache::Stats GenerationCache::getStats() const {
+    Stats stats;
+    stats.hits = hits.load();
+    stats.misses = misses.load();
+    stats.insertions = insertions.load();
+    stats.evictions = evictions.load();
+
+    for (const auto& shard : shards) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        stats.entries += shard.lru.size();
+        stats.bytes += shard.bytes;
+    }
+    return stats;
+}
@@ -0,0 +1,75 @@
+#include "generation_params.h"
+
+namespace {
+
+// Absolute bounds no configured limit may exceed (sized for the small models)
+const int kHardMaxTokens = 512;
+const float kHardMaxTemperature = 2.0f;
+
+} // namespace
+
+const char* generationRoleName(GenerationRole role) {
+    switch (role) {
+        case GenerationRole::Quiz: return "quiz";
+        case GenerationRole::Psychology: return "psychology";
+        case GenerationRole::Analysis: return "analysis";
+    }
+    return "unknown";
+}
+
+bool parseGenerationRole(const std::string& name, GenerationRole& role) {
+    for (size_t i = 0; i < kGenerationRoleCount; ++i) {
+        if (name == generationRoleName(static_cast<GenerationRole>(i))) {
+            role = static_cast<GenerationRole>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool validateGenerationLimits(const GenerationLimits& limits, std::string& error) {
+    if (limits.maxTokens < 1 || limits.maxTokens > kHardMaxTokens) {
+        error = "limits.maxTokens must be between 1 and " + std::to_string(kHardMaxTokens);
+        return false;
+    }
+    if (!(limits.maxTemperature >= 0.0f && limits.maxTemperature <= kHardMaxTemperature)) {
+        error = "limits.maxTemperature must be between 0 and " + std::to_string(kHardMaxTemperature);
+        return false;
+    }
+    if (limits.maxTopK < 0) {
+        error = "limits.maxTopK must not be negative";
+        return false;
+    }
+    return true;
+}
+
+bool validateGenerationParams(const GenerationParams& params, const GenerationLimits& limits, std::string& error) {
+    if (params.maxTokens < 1 || params.maxTokens > limits.maxTokens) {
+        error = "maxTokens must be between 1 and " + std::to_string(limits.maxTokens);
+        return false;
+    }
+    // Written so that NaN fails too
+    if (!(params.temperature >= 0.0f && params.temperature <= limits.maxTemperature)) {
+        error = "temperature must be between 0 and " + std::to_string(limits.maxTemperature);
+        return false;
+    }
+    if (params.topK < 0 || params.topK > limits.maxTopK) {
+        error = "top_k must be between 0 and " + std::to_string(limits.maxTopK);
+        return false;
+    }
+    if (!(params.topP > 0.0f && params.topP <= 1.0f)) {
+        error = "top_p must be greater than 0 and at most 1";
+        return false;
+    }
+    if (params.stop.size() > limits.maxStopSequences) {
+        error = "at most " + std::to_string(limits.maxStopSequences) + " stop sequences are allowed";
+        return false;
+    }
+    for (const auto& stop : params.stop) {
+        if (stop.empty() || stop.size() > limits.maxStopLength) {
+            error = "stop sequences must be 1 to " + std::to_string(limits.maxStopLength) + " bytes long";
+            return false;
+        }
+    }
+    return true;
+}
@@ -1,21 +1,51 @@
 #include "http_server.h"
+#include "simd_kernels.h"
+#include "resource_limits.h"
 #include <iostream>
 #include <sstream>
 #include <iomanip>
 #include <thread>
 
+namespace {
+
+// Topics are subcategory names or short phrases; longer text is not a topic
+const size_t kMaxTopicLength = 128;
+
+// Questionnaires per /api/psychology/analyze/batch request, and how many of
+// their NDJSON lines are written per chunk
+const size_t kMaxBatchProfiles = 20000;
+const size_t kBatchLinesPerChunk = 256;
+
+std::vector<PersonalityAnswer> parsePersonalityAnswers(const Json::Value& answersJson) {
+    std::vector<PersonalityAnswer> answers;
+    answers.reserve(answersJson.size());
+    for (const auto& answerJson : answersJson) {
+        PersonalityAnswer answer;
+        answer.questionId = answerJson.get("questionId", 1).asInt();
+        answer.selectedOption = answerJson.get("selectedOption", 0).asInt();
+        answer.trait = answerJson.get("trait", "E/I").asString();
+        answers.push_back(answer);
+    }
+    return answers;
+}
+
+} // namespace
+
 HttpServer::HttpServer(const std::string& host, int port, const std::string& modelPath) 
+    // Same model for all three purposes; the tasks share its weights
+    : HttpServer(host, port, ModelZooConfig::forRoles(modelPath, modelPath, modelPath)) {
+}
+
+HttpServer::HttpServer(const std::string& host, int port, const ModelZooConfig& zoo) 
     : host(host), port(port), startTime(std::chrono::steady_clock::now()) {
     
     server = std::make_unique<httplib::Server>();
     
     std::cout << "🚀 Initializing AI Quiz Server..." << std::endl;
     std::cout << "📍 Host: " << host << ":" << port << std::endl;
-    std::cout << "🤖 Model: " << modelPath << std::endl;
+    std::cout << "🤖 Models: " << zoo.models.size() << " configured, " << zoo.routes.size() << " routes" << std::endl;
     
-    // Initialize AI generator with same model for all three purposes
-    // (for now using single model - can be extended to use separate models)
-    aiGenerator = std::make_unique<AIQuizGenerator>(modelPath, modelPath, modelPath);
+    aiGenerator = std::make_unique<AIQuizGenerator>(zoo);
     
     // Configure server with detailed logging
     server->set_logger([](const httplib::Request& req, const httplib::Response& res) {
@@ -31,8 +61,21 @@ HttpServer::HttpServer(const std::string& host, int port, const std::string& mod
     // Set server timeouts for AI generation
     server->set_read_timeout(60);  // Increased for psychology analysis
     server->set_write_timeout(60); // Increased for psychology analysis
-    
+
+    // Headers and body go out in separate writes; with Nagle on, every
+    // keep-alive response waits ~40 ms for the client's delayed ACK
+    server->set_tcp_nodelay(true);
+
+    // httplib sizes its pool from the host's cores, dozens of workers in a
+    // 4-CPU pod; size it from the CPUs we may use instead
+    int workers = ResourceLimits::current().httpWorkers();
+    server->new_task_queue = [workers] { return new httplib::ThreadPool(workers); };
+
     setupRoutes();
+    rebuildCatalogBodies();
+    
+    // Categories come from the template file, so re-serve them whenever it changes
+    aiGenerator->setTemplatesChangedCallback([this]() { rebuildCatalogBodies(); });
     std::cout << "✅ HttpServer initialized" << std::endl;
 }
 
@@ -59,6 +102,11 @@ void HttpServer::setupRoutes() {
         handleGenerateQuiz(req, res);
     });
     
+    // Banked questions nearest a topic or subcategory
+    server->Get("/api/questions/search", [this](const httplib::Request& req, httplib::Response& res) {
+        handleSearchQuestions(req, res);
+    });
+    
     // Categories endpoint
     server->Get("/api/quiz/categories", [this](const httplib::Request& req, httplib::Response& res) {
         handleGetCategories(req, res);
@@ -87,10 +135,32 @@ void HttpServer::setupRoutes() {
         handleAnalyzePersonality(req, res);
     });
     
+    server->Post("/api/psychology/analyze/batch", [this](const httplib::Request& req, httplib::Response& res) {
+        handleAnalyzePersonalityBatch(req, res);
+    });
+    
     server->Get("/api/psychology/traits", [this](const httplib::Request& req, httplib::Response& res) {
         handleGetPersonalityTraits(req, res);
     });
     
+    // Admin: runtime generation defaults and limits
+    server->Get("/api/admin/generation", [this](const httplib::Request& req, httplib::Response& res) {
+        handleGetGenerationSettings(req, res);
+    });
+    
+    server->Put("/api/admin/generation", [this](const httplib::Request& req, httplib::Response& res) {
+        handleUpdateGenerationSettings(req, res);
+    });
+    
+    // Admin: LoRA adapters of the zoo's models, swapped without reloading weights
+    server->Get("/api/admin/adapters", [this](const httplib::Request& req, httplib::Response& res) {
+        handleGetAdapters(req, res);
+    });
+    
+    server->Put("/api/admin/adapters", [this](const httplib::Request& req, httplib::Response& res) {
+        handleUpdateAdapters(req, res);
+    });
+    
     std::cout << "📡 Routes configured successfully" << std::endl;
 }
 
@@ -102,7 +172,7 @@ void HttpServer::handleHealthCheck(const httplib::Request& req, httplib::Respons
     response["service"] = "C++ AI Quiz Generator API";
     response["version"] = "2.0.0";
     response["domain"] = "api.aeonglitch.me";
-    response["aiModel"] = "DistilGPT-2";
+    response["aiModel"] = aiGenerator ? aiGenerator->getModelName(GenerationRole::Quiz) : "";
     response["modelLoaded"] = isAIModelLoaded();
     response["uptime"] = getUptime();
     response["totalRequests"] = getTotalRequests();
@@ -129,7 +199,7 @@ void HttpServer::handleHealthCheck(const httplib::Request& req, httplib::Respons
         response["psychologyStats"]["totalAnalyses"] = totalAnalyses;
     }
     
-    sendSuccessResponse(res, response);
+    sendSuccessResponse(req, res, response);
 }
 
 void HttpServer::handleGenerateQuiz(const httplib::Request& req, httplib::Response& res) {
@@ -154,26 +224,64 @@ void HttpServer::handleGenerateQuiz(const httplib::Request& req, httplib::Respon
         std::string difficulty = requestJson.get("difficulty", "Medium").asString();
         std::string playerName = requestJson.get("playerName", "Unknown").asString();
         
+        // Free text or a subcategory from /api/quiz/categories
+        const Json::Value& topicValue = requestJson.isMember("topic") ? requestJson["topic"] : requestJson["subcategory"];
+        if (!topicValue.isNull() && (!topicValue.isString() || topicValue.asString().size() > kMaxTopicLength)) {
+            failedGenerations++;
+            sendErrorResponse(res, 400, "topic must be a string of at most " + std::to_string(kMaxTopicLength) + " bytes");
+            return;
+        }
+        std::string topic = topicValue.isString() ? topicValue.asString() : "";
+        
+        std::optional<uint64_t> seed;
+        if (!parseSeed(requestJson, seed)) {
+            failedGenerations++;
+            sendErrorResponse(res, 400, "Seed must be a non-negative integer");
+            return;
+        }
+        
+        std::optional<GenerationParams> params;
+        std::string paramsError;
+        if (!parseGenerationParams(requestJson, GenerationRole::Quiz, params, paramsError)) {
+            failedGenerations++;
+            sendErrorResponse(res, 400, paramsError);
+            return;
+        }
+        
         std::cout << "🎯 Generating AI quiz: " << category << "/" << difficulty 
                   << " for " << playerName << std::endl;
         
         // Generate question using AI
         auto startTime = std::chrono::high_resolution_clock::now();
-        QuizQuestion question = aiGenerator->generateQuestion(category, difficulty, playerName);
+        QuizQuestion question = aiGenerator->generateQuestion(category, difficulty, playerName, seed, params, topic);
         auto endTime = std::chrono::high_resolution_clock::now();
         
         auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(endTime - startTime);
         
+        if (question.retryAfterSeconds > 0) {
+            failedGenerations++;
+            std::cout << "⏳ No question to serve, client retries in " << question.retryAfterSeconds << "s" << std::endl;
+            // "fallback": no candidate passed the quality checks; otherwise the model was overloaded
+            sendErrorResponse(res, 503, question.source == "fallback" ? "No question available yet, retry later"
+                                                                       : "Quiz model overloaded, retry later");
+            res.set_header("Retry-After", std::to_string(question.retryAfterSeconds));
+            return;
+        }
+        
         // Build response
         Json::Value response;
         response["success"] = true;
         response["question"] = questionToJson(question);
         response["timestamp"] = getCurrentTimestamp();
         response["aiGenerated"] = question.generated;
+        response["source"] = question.source;
         response["aiModel"] = question.aiModel;
         response["generationTime"] = duration.count();
         response["generationTimeUnit"] = "milliseconds";
         response["serverProcessingTime"] = duration.count() - question.generationTimeMs;
+        if (seed) {
+            response["seed"] = static_cast<Json::UInt64>(*seed);
+        }
         
         if (question.generated) {
             successfulGenerations++;
@@ -183,7 +291,7 @@ void HttpServer::handleGenerateQuiz(const httplib::Request& req, httplib::Respon
             std::cout << "⚠️ Used fallback question due to AI generation failure" << std::endl;
         }
         
-        sendSuccessResponse(res, response);
+        sendSuccessResponse(req, res, response);
         
     } catch (const std::exception& e) {
         failedGenerations++;
@@ -214,10 +322,23 @@ void HttpServer::handleGeneratePsychologyQuestions(const httplib::Request& req,
             return;
         }
         
+        std::optional<uint64_t> seed;
+        if (!parseSeed(requestJson, seed)) {
+            sendErrorResponse(res, 400, "Seed must be a non-negative integer");
+            return;
+        }
+        
+        std::optional<GenerationParams> params;
+        std::string paramsError;
+        if (!parseGenerationParams(requestJson, GenerationRole::Psychology, params, paramsError)) {
+            sendErrorResponse(res, 400, paramsError);
+            return;
+        }
+        
         std::cout << "🧠 Generating " << count << " psychology questions..." << std::endl;
         
         auto startTime = std::chrono::high_resolution_clock::now();
-        auto questions = aiGenerator->generatePsychologyQuestions(count);
+        auto questions = aiGenerator->generatePsychologyQuestions(count, seed, params);
         auto endTime = std::chrono::high_resolution_clock::now();
         
         auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(endTime - startTime);
@@ -253,7 +374,7 @@ void HttpServer::handleGeneratePsychologyQuestions(const httplib::Request& req,
         std::cout << "✅ Generated " << questions.size() << " psychology questions in " 
                   << duration.count() << "ms" << std::endl;
         
-        sendSuccessResponse(res, response);
+        sendSuccessResponse(req, res, response);
         
     } catch (const std::exception& e) {
         std::cerr << "❌ Error generating psychology questions: " << e.what() << std::endl;
@@ -283,24 +404,23 @@ void HttpServer::handleAnalyzePersonality(const httplib::Request& req, httplib::
         }
         
         // Parse answers
-        std::vector<PersonalityAnswer> answers;
-        for (const auto& answerJson : requestJson["answers"]) {
-            PersonalityAnswer answer;
-            answer.questionId = answerJson.get("questionId", 1).asInt();
-            answer.selectedOption = answerJson.get("selectedOption", 0).asInt();
-            answer.trait = answerJson.get("trait", "E/I").asString();
-            answers.push_back(answer);
-        }
+        std::vector<PersonalityAnswer> answers = parsePersonalityAnswers(requestJson["answers"]);
         
         if (answers.empty()) {
             sendErrorResponse(res, 400, "No answers provided");
             return;
         }
         
+        std::optional<uint64_t> seed;
+        if (!parseSeed(requestJson, seed)) {
+            sendErrorResponse(res, 400, "Seed must be a non-negative integer");
+            return;
+        }
+        
         std::cout << "🔍 Analyzing personality from " << answers.size() << " answers..." << std::endl;
         
         auto startTime = std::chrono::high_resolution_clock::now();
-        PersonalityResult result = aiGenerator->analyzePersonality(answers);
+        PersonalityResult result = aiGenerator->analyzePersonality(answers, seed);
         auto endTime = std::chrono::high_resolution_clock::now();
         
         auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(endTime - startTime);
@@ -313,6 +433,7 @@ void HttpServer::handleAnalyzePersonality(const httplib::Request& req, httplib::
         response["description"] = result.description;
         response["confidence"] = result.confidence;
         response["aiGenerated"] = result.aiGenerated;
+        response["source"] = result.source;
         response["analysisModel"] = result.analysisModel;
         response["analysisTime"] = duration.count();
         response["timestamp"] = getCurrentTimestamp();
@@ -341,7 +462,7 @@ void HttpServer::handleAnalyzePersonality(const httplib::Request& req, httplib::
         std::cout << "✅ Personality analysis complete: " << result.personalityType 
                   << " in " << duration.count() << "ms" << std::endl;
         
-        sendSuccessResponse(res, response);
+        sendSuccessResponse(req, res, response);
         
     } catch (const std::exception& e) {
         std::cerr << "❌ Error analyzing personality: " << e.what() << std::endl;
@@ -349,34 +470,135 @@ void HttpServer::handleAnalyzePersonality(const httplib::Request& req, httplib::
     }
 }
 
-// NEW: Get personality traits information
-void HttpServer::handleGetPersonalityTraits(const httplib::Request& req, httplib::Response& res) {
+// Many questionnaires in one request, answered as NDJSON: one line per
+// profile, in request order, written while the response streams
+void HttpServer::handleAnalyzePersonalityBatch(const httplib::Request& req, httplib::Response& res) {
     totalRequests++;
     
     try {
-        Json::Value response;
-        response["success"] = true;
+        if (!isAIModelLoaded()) {
+            sendErrorResponse(res, 503, "AI model not loaded");
+            return;
+        }
         
-        // Get personality traits
-        auto traits = aiGenerator->getPersonalityTraits();
-        Json::Value traitsArray(Json::arrayValue);
-        for (const auto& trait : traits) {
-            traitsArray.append(trait);
+        Json::Value requestJson;
+        if (!parseJsonRequest(req.body, requestJson)) {
+            sendErrorResponse(res, 400, "Invalid JSON in request body");
+            return;
         }
-        response["traits"] = traitsArray;
         
-        // Get personality types
-        auto types = aiGenerator->getPersonalityTypes();
-        Json::Value typesArray(Json::arrayValue);
-        for (const auto& type : types) {
-            typesArray.append(type);
+        const Json::Value& profiles = requestJson["profiles"];
+        if (!profiles.isArray() || profiles.empty()) {
+            sendErrorResponse(res, 400, "Missing or empty 'profiles' array");
+            return;
+        }
+        if (profiles.size() > kMaxBatchProfiles) {
+            sendErrorResponse(res, 400, "At most " + std::to_string(kMaxBatchProfiles) + " profiles per batch");
+            return;
         }
-        response["types"] = typesArray;
         
-        response["timestamp"] = getCurrentTimestamp();
-        response["modelLoaded"] = isAIModelLoaded();
+        std::optional<uint64_t> seed;
+        if (!parseSeed(requestJson, seed)) {
+            sendErrorResponse(res, 400, "Seed must be a non-negative integer");
+            return;
+        }
         
-        sendSuccessResponse(res, response);
+        // Each profile is {"id": <optional, echoed back>, "answers": [...]}
+        auto answerSets = std::make_shared<std::vector<std::vector<PersonalityAnswer>>>();
+        auto ids = std::make_shared<std::vector<std::string>>(); // Serialized, empty when absent
+        answerSets->reserve(profiles.size());
+        ids->reserve(profiles.size());
+        for (Json::ArrayIndex i = 0; i < profiles.size(); ++i) {
+            const Json::Value& profile = profiles[i];
+            if (!profile.isObject() || !profile["answers"].isArray() || profile["answers"].empty()) {
+                sendErrorResponse(res, 400, "Profile " + std::to_string(i) + " needs a non-empty 'answers' array");
+                return;
+            }
+            answerSets->push_back(parsePersonalityAnswers(profile["answers"]));
+            ids->push_back(profile.isMember("id") ? serializeJson(profile["id"]) : std::string());
+        }
+        
+        std::cout << "🔍 Analyzing " << answerSets->size() << " personality profiles as a batch..." << std::endl;
+        auto batch = std::make_shared<PersonalityBatchResult>(aiGenerator->analyzePersonalityBatch(*answerSets, seed));
+        answerSets.reset();
+        
+        // The per-type part of every line is serialized once: the type's
+        // object without its closing brace, for the per-profile fields to follow
+        auto typePrefixes = std::make_shared<std::vector<std::string>>();
+        for (const auto& type : batch->types) {
+            Json::Value json;
+            json["personalityType"] = type.personalityType;
+            json["title"] = type.title;
+            json["description"] = type.description;
+            json["aiGenerated"] = type.aiGenerated;
+            json["source"] = type.source;
+            json["analysisModel"] = type.analysisModel;
+            Json::Value strengthsArray(Json::arrayValue);
+            for (const auto& strength : type.strengths) {
+                strengthsArray.append(strength);
+            }
+            json["strengths"] = strengthsArray;
+            Json::Value growthArray(Json::arrayValue);
+            for (const auto& growth : type.growthAreas) {
+                growthArray.append(growth);
+            }
+            json["growthAreas"] = growthArray;
+            std::string text = serializeJson(json);
+            text.pop_back();
+            typePrefixes->push_back(std::move(text));
+        }
+        
+        auto next = std::make_shared<size_t>(0);
+        res.set_chunked_content_provider("application/x-ndjson",
+            [batch, ids, typePrefixes, next](size_t, httplib::DataSink& sink) {
+                auto number = [](double value) { return Json::valueToString(value); };
+                std::string chunk;
+                size_t end = std::min(*next + kBatchLinesPerChunk, ids->size());
+                for (size_t i = *next; i < end; ++i) {
+                    double e = batch->extraversion[i];
+                    double s = batch->sensing[i];
+                    double t = batch->thinking[i];
+                    double j = batch->judging[i];
+                    chunk += "{\"index\":" + std::to_string(i);
+                    if (!(*ids)[i].empty()) {
+                        chunk += ",\"id\":" + (*ids)[i];
+                    }
+                    chunk += ',';
+                    chunk.append((*typePrefixes)[batch->typeIndex[i]], 1, std::string::npos);
+                    chunk += ",\"confidence\":" + number(batch->confidence[i]);
+                    chunk += ",\"scores\":{\"E\":" + number(e) + ",\"I\":" + number(1.0 - e) +
+                             ",\"S\":" + number(s) + ",\"N\":" + number(1.0 - s) +
+                             ",\"T\":" + number(t) + ",\"F\":" + number(1.0 - t) +
+                             ",\"J\":" + number(j) + ",\"P\":" + number(1.0 - j) + "}}\n";
+                }
+                *next = end;
+                if (!chunk.empty() && !sink.write(chunk.data(), chunk.size())) {
+                    return false;
+                }
+                if (*next == ids->size()) {
+                    sink.done();
+                }
+                return true;
+            });
+        res.set_header("X-Profile-Count", std::to_string(ids->size()));
+        res.set_header("X-Type-Count", std::to_string(batch->types.size()));
+        res.status = 200;
+        setCORSHeaders(res);
+        
+    } catch (const std::exception& e) {
+        std::cerr << "❌ Error analyzing personality batch: " << e.what() << std::endl;
+        sendErrorResponse(res, 500, e.what());
+    }
+}
+
+// NEW: Get personality traits information
+void HttpServer::handleGetPersonalityTraits(const httplib::Request& req, httplib::Response& res) {
+    totalRequests++;
+    
+    try {
+        // Served from the body built (and compressed) at startup
+        auto body = currentCatalogBody(traitsBody);
+        sendPrecompressedResponse(req, res, *body);
         
     } catch (const std::exception& e) {
         std::cerr << "❌ Error getting personality traits: " << e.what() << std::endl;
@@ -384,38 +606,68 @@ void HttpServer::handleGetPersonalityTraits(const httplib::Request& req, httplib
     }
 }
 
-void HttpServer::handleGetCategories(const httplib::Request& req, httplib::Response& res) {
+void HttpServer::handleSearchQuestions(const httplib::Request& req, httplib::Response& res) {
     totalRequests++;
     
     try {
-        Json::Value response;
-        response["success"] = true;
+        if (!aiGenerator || !aiGenerator->isEmbeddingIndexEnabled()) {
+            sendErrorResponse(res, 503, "Embedding index not enabled");
+            return;
+        }
+        
+        std::string topic = req.get_param_value("topic");
+        if (topic.empty() || topic.size() > kMaxTopicLength) {
+            sendErrorResponse(res, 400, "topic is required and at most " + std::to_string(kMaxTopicLength) + " bytes");
+            return;
+        }
         
-        // Get categories map
-        auto categoriesMap = aiGenerator->getCategoriesMap();
-        Json::Value categories;
-        for (const auto& pair : categoriesMap) {
-            Json::Value subcategories(Json::arrayValue);
-            for (const auto& sub : pair.second) {
-                subcategories.append(sub);
+        int limit = 10;
+        if (req.has_param("limit")) {
+            try {
+                limit = std::stoi(req.get_param_value("limit"));
+            } catch (const std::exception&) {
+                limit = 0;
+            }
+            if (limit < 1 || limit > 50) {
+                sendErrorResponse(res, 400, "limit must be between 1 and 50");
+                return;
             }
-            categories[pair.first] = subcategories;
         }
-        response["categories"] = categories;
         
-        // Get difficulties
-        auto difficulties = aiGenerator->getDifficulties();
-        Json::Value diffArray(Json::arrayValue);
-        for (const auto& diff : difficulties) {
-            diffArray.append(diff);
+        auto startTime = std::chrono::high_resolution_clock::now();
+        auto matches = aiGenerator->searchQuestions(topic, req.get_param_value("category"),
+                                                    req.get_param_value("difficulty"), static_cast<size_t>(limit));
+        auto duration = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::high_resolution_clock::now() - startTime);
+        
+        Json::Value results(Json::arrayValue);
+        for (const auto& match : matches) {
+            Json::Value entry = questionToJson(match.first);
+            entry["similarity"] = match.second;
+            results.append(entry);
         }
-        response["difficulties"] = diffArray;
         
+        Json::Value response;
+        response["success"] = true;
+        response["topic"] = topic;
+        response["results"] = results;
+        response["searchTimeUs"] = static_cast<Json::Int64>(duration.count());
         response["timestamp"] = getCurrentTimestamp();
-        response["aiModel"] = "DistilGPT-2";
-        response["modelLoaded"] = isAIModelLoaded();
+        sendSuccessResponse(req, res, response);
         
-        sendSuccessResponse(res, response);
+    } catch (const std::exception& e) {
+        std::cerr << "❌ Error searching questions: " << e.what() << std::endl;
+        sendErrorResponse(res, 500, e.what());
+    }
+}
+
+void HttpServer::handleGetCategories(const httplib::Request& req, httplib::Response& res) {
+    totalRequests++;
+    
+    try {
+        // Served from the body built (and compressed) at startup
+        auto body = currentCatalogBody(categoriesBody);
+        sendPrecompressedResponse(req, res, *body);
         
     } catch (const std::exception& e) {
         std::cerr << "❌ Error getting categories: " << e.what() << std::endl;
@@ -423,6 +675,84 @@ void HttpServer::handleGetCategories(const httplib::Request& req, httplib::Respo
     }
 }
 
+void HttpServer::rebuildCatalogBodies() {
+    // Catalog content only changes when models or templates are reloaded, so
+    // serialize and compress it once instead of on every request. Its
+    // timestamp is when it was built, and it is rebuilt whenever the model
+    // state it reports changes
+    const bool modelLoaded = isAIModelLoaded();
+    const std::string timestamp = getCurrentTimestamp();
+    
+    Json::Value categoriesResponse;
+    categoriesResponse["success"] = true;
+    
+    // Get categories map
+    auto categoriesMap = aiGenerator->getCategoriesMap();
+    Json::Value categories;
+    for (const auto& pair : categoriesMap) {
+        Json::Value subcategories(Json::arrayValue);
+        for (const auto& sub : pair.second) {
+            subcategories.append(sub);
+        }
+        categories[pair.first] = subcategories;
+    }
+    categoriesResponse["categories"] = categories;
+    
+    // Get difficulties
+    auto difficulties = aiGenerator->getDifficulties();
+    Json::Value diffArray(Json::arrayValue);
+    for (const auto& diff : difficulties) {
+        diffArray.append(diff);
+    }
+    categoriesResponse["difficulties"] = diffArray;
+    
+    categoriesResponse["timestamp"] = timestamp;
+    categoriesResponse["aiModel"] = aiGenerator->getModelName(GenerationRole::Quiz);
+    Json::Value modelNames(Json::arrayValue);
+    for (const auto& name : aiGenerator->getModelNames()) {
+        modelNames.append(name);
+    }
+    categoriesResponse["models"] = modelNames;
+    categoriesResponse["modelLoaded"] = modelLoaded;
+    
+    Json::Value traitsResponse;
+    traitsResponse["success"] = true;
+    
+    // Get personality traits
+    auto traits = aiGenerator->getPersonalityTraits();
+    Json::Value traitsArray(Json::arrayValue);
+    for (const auto& trait : traits) {
+        traitsArray.append(trait);
+    }
+    traitsResponse["traits"] = traitsArray;
+    
+    // Get personality types
+    auto types = aiGenerator->getPersonalityTypes();
+    Json::Value typesArray(Json::arrayValue);
+    for (const auto& type : types) {
+        typesArray.append(type);
+    }
+    traitsResponse["types"] = typesArray;
+    
+    traitsResponse["timestamp"] = timestamp;
+    traitsResponse["modelLoaded"] = modelLoaded;
+    
+    std::atomic_store(&categoriesBody, std::make_shared<const PrecompressedBody>(
+        compressor.precompress(serializeJson(categoriesResponse))));
+    std::atomic_store(&traitsBody, std::make_shared<const PrecompressedBody>(
+        compressor.precompress(serializeJson(traitsResponse))));
+    catalogModelLoaded = modelLoaded;
+}
+
+std::shared_ptr<const PrecompressedBody> HttpServer::currentCatalogBody(
+    const std::shared_ptr<const PrecompressedBody>& body) {
+    // Models load, fail and reload after the bodies were built
+    if (isAIModelLoaded() != catalogModelLoaded.load()) {
+        rebuildCatalogBodies();
+    }
+    return std::atomic_load(&body);
+}
+
 void HttpServer::handleGetStats(const httplib::Request& req, httplib::Response& res) {
     totalRequests++;
     
@@ -451,13 +781,66 @@ void HttpServer::handleGetStats(const httplib::Request& req, httplib::Response&
         aiGenerator->getPsychologyStats(totalPsychQuestions, totalAnalyses);
         response["psychology"]["totalPsychQuestions"] = totalPsychQuestions;
         response["psychology"]["totalAnalyses"] = totalAnalyses;
+        
+        // Add question bank stats
+        size_t bankEntries;
+        int bankHits, bankAppends, bankDuplicates;
+        aiGenerator->getBankStats(bankEntries, bankHits, bankAppends, bankDuplicates);
+        response["bank"]["entries"] = static_cast<Json::UInt64>(bankEntries);
+        response["bank"]["hits"] = bankHits;
+        response["bank"]["appended"] = bankAppends;
+        response["bank"]["duplicatesRejected"] = bankDuplicates;
+        
+        // Add embedding index stats
+        size_t indexedQuestions, indexBytes;
+        int topicHits;
+        aiGenerator->getEmbeddingIndexStats(indexedQuestions, indexBytes, topicHits);
+        response["embeddingIndex"]["entries"] = static_cast<Json::UInt64>(indexedQuestions);
+        response["embeddingIndex"]["memoryBytes"] = static_cast<Json::UInt64>(indexBytes);
+        response["embeddingIndex"]["topicHits"] = topicHits;
+        
+        // Add player history stats
+        size_t activePlayers, historyBytes;
+        int historyExhausted;
+        aiGenerator->getPlayerHistoryStats(activePlayers, historyBytes, historyExhausted);
+        response["players"]["active"] = static_cast<Json::UInt64>(activePlayers);
+        response["players"]["historyMemoryBytes"] = static_cast<Json::UInt64>(historyBytes);
+        response["players"]["bankExhausted"] = historyExhausted;
+        
+        // Add generation quality stats
+        int candidates, rejected, fallbacks, poolHits;
+        double fallbackRate;
+        aiGenerator->getQualityStats(candidates, rejected, fallbacks, poolHits, fallbackRate);
+        response["quality"]["candidatesGenerated"] = candidates;
+        response["quality"]["candidatesRejected"] = rejected;
+        response["quality"]["fallbacksServed"] = fallbacks;
+        response["quality"]["fallbackRate"] = fallbackRate;
+        response["quality"]["poolHits"] = poolHits;
+        
+        // Add load shedding stats
+        int shed, sloMs, quizWaitMs;
+        aiGenerator->getSheddingStats(shed, sloMs, quizWaitMs);
+        response["shedding"]["requestsShed"] = shed;
+        response["shedding"]["latencySloMs"] = sloMs;
+        response["shedding"]["estimatedQuizWaitMs"] = quizWaitMs;
+        
+        // Add generation cache stats
+        GenerationCache::Stats cacheStats = aiGenerator->getCacheStats();
+        uint64_t lookups = cacheStats.hits + cacheStats.misses;
+        response["cache"]["hits"] = static_cast<Json::UInt64>(cacheStats.hits);
+        response["cache"]["misses"] = static_cast<Json::UInt64>(cacheStats.misses);
+        response["cache"]["hitRate"] = lookups > 0 ? static_cast<double>(cacheStats.hits) / lookups : 0.0;
+        response["cache"]["evictions"] = static_cast<Json::UInt64>(cacheStats.evictions);
+        response["cache"]["entries"] = static_cast<Json::UInt64>(cacheStats.entries);
+        response["cache"]["bytes"] = static_cast<Json::UInt64>(cacheStats.bytes);
+        response["cache"]["capacityBytes"] = static_cast<Json::UInt64>(aiGenerator->getCacheCapacity());
     } else {
         response["ai"]["status"] = "Model not loaded";
     }
     
     response["timestamp"] = getCurrentTimestamp();
     
-    sendSuccessResponse(res, response);
+    sendSuccessResponse(req, res, response);
 }
 
 void HttpServer::handleGetModelInfo(const httplib::Request& req, httplib::Response& res) {
@@ -478,13 +861,32 @@ void HttpServer::handleGetModelInfo(const httplib::Request& req, httplib::Respon
             modelsArray.append(model);
         }
         response["loadedModels"] = modelsArray;
+        response["cpu"]["ggml"] = aiGenerator->getBackendInfo();
     } else {
         response["error"] = "AI model not loaded";
     }
     
+    // Which kernel build this CPU runs, so a slow node can be told apart
+    // from one that fell back to the generic path
+    response["cpu"]["kernels"] = simdKernels().name;
+    Json::Value supported(Json::arrayValue);
+    for (const auto& name : supportedSimdKernels()) {
+        supported.append(name);
+    }
+    response["cpu"]["supportedKernels"] = supported;
+    Json::Value features(Json::arrayValue);
+    for (const auto& feature : cpuFeatures()) {
+        features.append(feature);
+    }
+    response["cpu"]["features"] = features;
+    const ResourceLimits& limits = ResourceLimits::current();
+    response["cpu"]["limit"] = limits.cpus;
+    response["cpu"]["limitSource"] = limits.cpuSource;
+    response["memoryLimitMb"] = static_cast<Json::UInt64>(limits.memoryBytes / (1024 * 1024));
+    
     response["timestamp"] = getCurrentTimestamp();
     
-    sendSuccessResponse(res, response);
+    sendSuccessResponse(req, res, response);
 }
 
 Json::Value HttpServer::questionToJson(const QuizQuestion& question) const {
@@ -499,6 +901,7 @@ Json::Value HttpServer::questionToJson(const QuizQuestion& question) const {
     json["stealChance"] = question.stealChance;
     json["stealPercentage"] = question.stealPercentage;
     json["generated"] = question.generated;
+    json["source"] = question.source;
     json["aiModel"] = question.aiModel;
     json["generationTimeMs"] = question.generationTimeMs;
     
@@ -526,8 +929,8 @@ std::string HttpServer::getCurrentTimestamp() const {
 
 void HttpServer::setCORSHeaders(httplib::Response& res) const {
     res.set_header("Access-Control-Allow-Origin", "*");
-    res.set_header("Access-Control-Allow-Methods", "GET, POST, OPTIONS");
-    res.set_header("Access-Control-Allow-Headers", "Content-Type, Authorization");
+    res.set_header("Access-Control-Allow-Methods", "GET, POST, PUT, OPTIONS");
+    res.set_header("Access-Control-Allow-Headers", "Content-Type, Authorization, X-Admin-Token");
     res.set_header("Access-Control-Max-Age", "86400");
 }
 
@@ -543,6 +946,316 @@ bool HttpServer::parseJsonRequest(const std::string& body, Json::Value& json) co
     return Json::parseFromStream(builder, stream, &json, &errors);
 }
 
+bool HttpServer::parseSeed(const Json::Value& json, std::optional<uint64_t>& seed) const {
+    if (!json.isObject() || !json.isMember("seed") || json["seed"].isNull()) {
+        return true; // Unseeded
+    }
+    
+    const Json::Value& value = json["seed"];
+    if (!value.isUInt64()) {
+        return false;
+    }
+    
+    seed = value.asUInt64();
+    return true;
+}
+
+bool HttpServer::parseGenerationParams(const Json::Value& json, GenerationRole role,
+                                       std::optional<GenerationParams>& params, std::string& error) const {
+    static const char* const kKeys[] = {"maxTokens", "temperature", "top_k", "top_p", "stop"};
+    
+    bool overridden = false;
+    for (const char* key : kKeys) {
+        overridden = overridden || (json.isObject() && json.isMember(key));
+    }
+    if (!overridden) {
+        return true; // Role defaults apply
+    }
+    
+    GenerationParams requested = aiGenerator->getGenerationSettings()->forRole(role).defaults;
+    if (!applyGenerationParams(json, requested, error) ||
+        !aiGenerator->validateGenerationParams(role, requested, error)) {
+        return false;
+    }
+    
+    params = std::move(requested);
+    return true;
+}
+
+bool HttpServer::applyGenerationParams(const Json::Value& json, GenerationParams& params, std::string& error) const {
+    if (json.isMember("maxTokens")) {
+        if (!json["maxTokens"].isInt()) {
+            error = "maxTokens must be an integer";
+            return false;
+        }
+        params.maxTokens = json["maxTokens"].asInt();
+    }
+    
+    if (json.isMember("temperature")) {
+        if (!json["temperature"].isNumeric()) {
+            error = "temperature must be a number";
+            return false;
+        }
+        params.temperature = json["temperature"].asFloat();
+    }
+    
+    if (json.isMember("top_k")) {
+        if (!json["top_k"].isInt()) {
+            error = "top_k must be an integer";
+            return false;
+        }
+        params.topK = json["top_k"].asInt();
+    }
+    
+    if (json.isMember("top_p")) {
+        if (!json["top_p"].isNumeric()) {
+            error = "top_p must be a number";
+            return false;
+        }
+        params.topP = json["top_p"].asFloat();
+    }
+    
+    if (json.isMember("stop")) {
+        const Json::Value& stop = json["stop"];
+        params.stop.clear();
+        if (stop.isString()) {
+            params.stop.push_back(stop.asString());
+        } else if (stop.isArray()) {
+            for (const auto& sequence : stop) {
+                if (!sequence.isString()) {
+                    error = "stop must be a string or an array of strings";
+                    return false;
+                }
+                params.stop.push_back(sequence.asString());
+            }
+        } else if (!stop.isNull()) {
+            error = "stop must be a string or an array of strings";
+            return false;
+        }
+    }
+    
+    return true;
+}
+
+bool HttpServer::applyGenerationLimits(const Json::Value& json, GenerationLimits& limits, std::string& error) const {
+    for (const char* key : {"maxTokens", "maxTopK", "maxStopSequences", "maxStopLength"}) {
+        if (json.isMember(key) && (!json[key].isInt() || json[key].asInt() < 0)) {
+            error = std::string("limits.") + key + " must be a non-negative integer";
+            return false;
+        }
+    }
+    if (json.isMember("maxTemperature") && !json["maxTemperature"].isNumeric()) {
+        error = "limits.maxTemperature must be a number";
+        return false;
+    }
+    
+    limits.maxTokens = json.get("maxTokens", limits.maxTokens).asInt();
+    limits.maxTemperature = json.get("maxTemperature", limits.maxTemperature).asFloat();
+    limits.maxTopK = json.get("maxTopK", limits.maxTopK).asInt();
+    limits.maxStopSequences = json.get("maxStopSequences", static_cast<Json::UInt64>(limits.maxStopSequences)).asUInt64();
+    limits.maxStopLength = json.get("maxStopLength", static_cast<Json::UInt64>(limits.maxStopLength)).asUInt64();
+    return true;
+}
+
+Json::Value HttpServer::generationSettingsToJson(const GenerationSettings& settings) const {
+    Json::Value roles;
+    for (size_t i = 0; i < kGenerationRoleCount; ++i) {
+        const auto& role = settings.roles[i];
+        
+        Json::Value defaults;
+        defaults["maxTokens"] = role.defaults.maxTokens;
+        defaults["temperature"] = role.defaults.temperature;
+        defaults["top_k"] = role.defaults.topK;
+        defaults["top_p"] = role.defaults.topP;
+        Json::Value stop(Json::arrayValue);
+        for (const auto& sequence : role.defaults.stop) {
+            stop.append(sequence);
+        }
+        defaults["stop"] = stop;
+        
+        Json::Value limits;
+        limits["maxTokens"] = role.limits.maxTokens;
+        limits["maxTemperature"] = role.limits.maxTemperature;
+        limits["maxTopK"] = role.limits.maxTopK;
+        limits["maxStopSequences"] = static_cast<Json::UInt64>(role.limits.maxStopSequences);
+        limits["maxStopLength"] = static_cast<Json::UInt64>(role.limits.maxStopLength);
+        
+        const char* name = generationRoleName(static_cast<GenerationRole>(i));
+        roles[name]["defaults"] = defaults;
+        roles[name]["limits"] = limits;
+    }
+    return roles;
+}
+
+std::string HttpServer::serializeJson(const Json::Value& data) const {
+    Json::StreamWriterBuilder builder;
+    builder["indentation"] = "";
+    return Json::writeString(builder, data);
+}
+
+bool HttpServer::authorizeAdmin(const httplib::Request& req, httplib::Response& res) const {
+    if (adminToken.empty()) {
+        if (req.remote_addr == "127.0.0.1" || req.remote_addr == "::1") {
+            return true;
+        }
+        sendErrorResponse(res, 403, "Admin endpoints are limited to localhost unless an admin token is configured");
+        return false;
+    }
+    
+    // Compare without an early exit so timing does not reveal the matching prefix
+    std::string supplied = req.get_header_value("X-Admin-Token");
+    unsigned char diff = supplied.size() == adminToken.size() ? 0 : 1;
+    for (size_t i = 0; i < supplied.size() && i < adminToken.size(); ++i) {
+        diff |= static_cast<unsigned char>(supplied[i] ^ adminToken[i]);
+    }
+    if (diff != 0) {
+        sendErrorResponse(res, 401, "Missing or invalid X-Admin-Token");
+        return false;
+    }
+    return true;
+}
+
+void HttpServer::handleGetGenerationSettings(const httplib::Request& req, httplib::Response& res) {
+    totalRequests++;
+    if (!authorizeAdmin(req, res)) {
+        return;
+    }
+    
+    Json::Value response;
+    response["success"] = true;
+    response["roles"] = generationSettingsToJson(*aiGenerator->getGenerationSettings());
+    response["timestamp"] = getCurrentTimestamp();
+    sendSuccessResponse(req, res, response);
+}
+
+void HttpServer::handleUpdateGenerationSettings(const httplib::Request& req, httplib::Response& res) {
+    totalRequests++;
+    if (!authorizeAdmin(req, res)) {
+        return;
+    }
+    
+    try {
+        Json::Value requestJson;
+        if (!parseJsonRequest(req.body, requestJson) || !requestJson.isObject()) {
+            sendErrorResponse(res, 400, "Expected a JSON object keyed by role");
+            return;
+        }
+        
+        // Partial update: only the roles and fields present change. The
+        // whole edit is validated and published at once, or not at all
+        std::string error;
+        bool updated = aiGenerator->updateGenerationSettings(
+            [this, &requestJson](GenerationSettings& settings, std::string& editError) {
+                for (const auto& name : requestJson.getMemberNames()) {
+                    GenerationRole role;
+                    if (!parseGenerationRole(name, role)) {
+                        editError = "unknown role '" + name + "'";
+                        return false;
+                    }
+                    
+                    const Json::Value& roleJson = requestJson[name];
+                    auto& target = settings.forRole(role);
+                    if (roleJson.isMember("limits") &&
+                        !applyGenerationLimits(roleJson["limits"], target.limits, editError)) {
+                        return false;
+                    }
+                    if (roleJson.isMember("defaults") &&
+                        !applyGenerationParams(roleJson["defaults"], target.defaults, editError)) {
+                        return false;
+                    }
+                }
+                return true;
+            },
+            error);
+        
+        if (!updated) {
+            sendErrorResponse(res, 400, error);
+            return;
+        }
+        
+        std::cout << "🎛️ Generation settings updated by " << req.remote_addr << std::endl;
+        
+        Json::Value response;
+        response["success"] = true;
+        response["roles"] = generationSettingsToJson(*aiGenerator->getGenerationSettings());
+        response["timestamp"] = getCurrentTimestamp();
+        sendSuccessResponse(req, res, response);
+        
+    } catch (const std::exception& e) {
+        std::cerr << "❌ Error updating generation settings: " << e.what() << std::endl;
+        sendErrorResponse(res, 500, e.what());
+    }
+}
+
+Json::Value HttpServer::adaptersToJson() const {
+    Json::Value models(Json::arrayValue);
+    for (const auto& state : aiGenerator->getModelAdapters()) {
+        Json::Value model;
+        model["model"] = state.model;
+        model["basePath"] = state.basePath;
+        model["applied"] = state.applied;
+        model["adapters"] = Json::Value(Json::arrayValue);
+        for (const auto& adapter : state.adapters) {
+            Json::Value entry;
+            entry["path"] = adapter.path;
+            entry["scale"] = adapter.scale;
+            model["adapters"].append(entry);
+        }
+        models.append(model);
+    }
+    return models;
+}
+
+void HttpServer::handleGetAdapters(const httplib::Request& req, httplib::Response& res) {
+    totalRequests++;
+    if (!authorizeAdmin(req, res)) {
+        return;
+    }
+    
+    Json::Value response;
+    response["success"] = true;
+    response["models"] = adaptersToJson();
+    response["timestamp"] = getCurrentTimestamp();
+    sendSuccessResponse(req, res, response);
+}
+
+void HttpServer::handleUpdateAdapters(const httplib::Request& req, httplib::Response& res) {
+    totalRequests++;
+    if (!authorizeAdmin(req, res)) {
+        return;
+    }
+    
+    try {
+        // {"model": name, "adapters": [...]}; an empty list restores the base model
+        Json::Value requestJson;
+        if (!parseJsonRequest(req.body, requestJson) || !requestJson.isObject() ||
+            !requestJson["model"].isString() || !requestJson.isMember("adapters")) {
+            sendErrorResponse(res, 400, "Expected {\"model\": name, \"adapters\": [...]}");
+            return;
+        }
+        
+        std::vector<LoraAdapterSpec> adapters;
+        std::string error;
+        if (!ModelZooConfig::parseAdapters(requestJson["adapters"], adapters, error) ||
+            !aiGenerator->setModelAdapters(requestJson["model"].asString(), adapters, error)) {
+            sendErrorResponse(res, 400, error);
+            return;
+        }
+        
+        std::cout << "🧩 Adapters of " << requestJson["model"].asString() << " updated by " << req.remote_addr << std::endl;
+        
+        Json::Value response;
+        response["success"] = true;
+        response["models"] = adaptersToJson();
+        response["timestamp"] = getCurrentTimestamp();
+        sendSuccessResponse(req, res, response);
+        
+    } catch (const std::exception& e) {
+        std::cerr << "❌ Error updating adapters: " << e.what() << std::endl;
+        sendErrorResponse(res, 500, e.what());
+    }
+}
+
 void HttpServer::sendErrorResponse(httplib::Response& res, int code, 
                                  const std::string& message) const {
     Json::Value error;
@@ -551,21 +1264,41 @@ void HttpServer::sendErrorResponse(httplib::Response& res, int code,
     error["timestamp"] = getCurrentTimestamp();
     error["aiModelLoaded"] = isAIModelLoaded();
     
-    Json::StreamWriterBuilder builder;
-    builder["indentation"] = "";
-    std::string jsonString = Json::writeString(builder, error);
-    
-    res.set_content(jsonString, "application/json");
+    res.set_content(serializeJson(error), "application/json");
     res.status = code;
     setCORSHeaders(res);
 }
 
-void HttpServer::sendSuccessResponse(httplib::Response& res, const Json::Value& data) const {
-    Json::StreamWriterBuilder builder;
-    builder["indentation"] = "";
-    std::string jsonString = Json::writeString(builder, data);
+void HttpServer::sendSuccessResponse(const httplib::Request& req, httplib::Response& res,
+                                     const Json::Value& data) const {
+    std::string jsonString = serializeJson(data);
     
-    res.set_content(jsonString, "application/json");
+    // Handlers run on the HTTP worker pool after the model lock is released,
+    // so compressing here never holds up inference
+    ContentEncoding encoding = compressor.negotiate(req.get_header_value("Accept-Encoding"));
+    std::string compressed;
+    if (encoding != ContentEncoding::Identity && compressor.compress(jsonString, encoding, compressed)) {
+        res.set_header("Content-Encoding", ResponseCompressor::encodingName(encoding));
+        res.set_content(std::move(compressed), "application/json");
+    } else {
+        res.set_content(std::move(jsonString), "application/json");
+    }
+    
+    res.set_header("Vary", "Accept-Encoding");
+    res.status = 200;
+    setCORSHeaders(res);
+}
+
+void HttpServer::sendPrecompressedResponse(const httplib::Request& req, httplib::Response& res,
+                                           const PrecompressedBody& body) const {
+    ContentEncoding encoding = compressor.negotiate(req.get_header_value("Accept-Encoding"));
+    const std::string& content = body.forEncoding(encoding);
+    
+    if (&content != &body.identity) {
+        res.set_header("Content-Encoding", ResponseCompressor::encodingName(encoding));
+    }
+    res.set_content(content, "application/json");
+    res.set_header("Vary", "Accept-Encoding");
     res.status = 200;
     setCORSHeaders(res);
 }
@@ -577,21 +1310,30 @@ bool HttpServer::start() {
         std::cout << "⚠️ Warning: AI model not loaded, some features may not work" << std::endl;
     }
     
-    // Start server in a separate thread to avoid blocking
-    std::thread serverThread([this]() {
-        if (server->listen(host.c_str(), port)) {
-            std::cout << "✅ Server started successfully!" << std::endl;
+    // Bind here so the caller learns the real outcome; once bound, the
+    // kernel queues connections even before the accept loop runs
+    if (!server->bind_to_port(host, port)) {
+        std::cerr << "❌ Failed to bind " << host << ":" << port << std::endl;
+        return false;
+    }
+    
+    // Accept in a separate thread to avoid blocking
+    listenerThread = std::thread([this]() {
+        if (server->listen_after_bind()) {
+            std::cout << "🔌 Listener on " << host << ":" << port << " closed" << std::endl;
         } else {
-            std::cerr << "❌ Failed to start server on " << host << ":" << port << std::endl;
+            std::cerr << "❌ Listener on " << host << ":" << port << " failed" << std::endl;
         }
+        
+        {
+            std::lock_guard<std::mutex> lock(listenerMutex);
+            listenerDone = true;
+        }
+        listenerCv.notify_all();
     });
     
-    // Wait a moment to let the server start
-    std::this_thread::sleep_for(std::chrono::milliseconds(500));
-    
-    // Keep the main thread alive
-    serverThread.detach();
-    
+    server->wait_until_ready();
+    std::cout << "✅ Listening on " << host << ":" << port << std::endl;
     return true;
 }
 
@@ -602,6 +1344,44 @@ void HttpServer::stop() {
     }
 }
 
+HttpServer::~HttpServer() {
+    shutdown(std::chrono::milliseconds(0));
+}
+
+void HttpServer::shutdown(std::chrono::milliseconds drainTimeout) {
+    if (shuttingDown.exchange(true)) {
+        return;
+    }
+    
+    auto drainStart = std::chrono::steady_clock::now();
+    std::cout << "🛑 Draining: refusing new connections, waiting up to "
+              << std::chrono::duration_cast<std::chrono::seconds>(drainTimeout).count()
+              << "s for in-flight requests" << std::endl;
+    
+    // Background refills would only compete with the requests being drained
+    aiGenerator->beginShutdown();
+    
+    // Closing the listening socket ends the accept loop; listen() then
+    // returns once the worker pool has served every accepted connection
+    server->stop();
+    
+    if (listenerThread.joinable()) {
+        std::unique_lock<std::mutex> lock(listenerMutex);
+        if (!listenerCv.wait_for(lock, drainTimeout, [this]() { return listenerDone; })) {
+            std::cerr << "⚠️ Drain deadline reached, cancelling in-flight generation" << std::endl;
+            aiGenerator->cancelGeneration();
+        }
+        lock.unlock();
+        listenerThread.join();
+    }
+    
+    auto drained = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - drainStart);
+    std::cout << "✅ Requests drained in " << drained.count() << "ms" << std::endl;
+    
+    aiGenerator->shutdown();
+}
+
 void HttpServer::setHost(const std::string& newHost) {
     host = newHost;
 }
@@ -610,6 +1390,11 @@ void HttpServer::setPort(int newPort) {
     port = newPort;
 }
 
+void HttpServer::setCompressionConfig(const CompressionConfig& config) {
+    compressor = ResponseCompressor(config);
+    rebuildCatalogBodies();
+}
+
 bool HttpServer::isRunning() const {
     return server && server->is_running();
 }
@@ -647,9 +1432,93 @@ bool HttpServer::isModelLoading() const {
     return false; // There is no async loading in this implementation
 }
 
+bool HttpServer::enableQuestionBank(const QuestionBankConfig& config) {
+    return aiGenerator && aiGenerator->enableQuestionBank(config);
+}
+
+void HttpServer::setPlayerHistoryConfig(const PlayerHistoryConfig& config) {
+    if (aiGenerator) {
+        aiGenerator->setPlayerHistoryConfig(config);
+    }
+}
+
+bool HttpServer::enableEmbeddingIndex(const EmbeddingIndexConfig& config) {
+    return aiGenerator && aiGenerator->enableEmbeddingIndex(config);
+}
+
+size_t HttpServer::indexBankedQuestions(size_t maxQuestions) {
+    return aiGenerator->indexBankedQuestions(maxQuestions);
+}
+
+void HttpServer::refillPools() {
+    aiGenerator->refillPools();
+}
+
+void HttpServer::runMaintenance() {
+    aiGenerator->runMaintenance();
+}
+
+size_t HttpServer::evictIdleModels(std::chrono::seconds idleTimeout) {
+    return aiGenerator->evictIdleModels(idleTimeout);
+}
+
+bool HttpServer::configureStateDirectory(const std::string& directory) {
+    return aiGenerator->configureStateDirectory(directory);
+}
+
+bool HttpServer::enableAutoTune(const AutoTuneConfig& config) {
+    return aiGenerator && aiGenerator->enableAutoTune(config);
+}
+
+void HttpServer::setAdminToken(const std::string& token) {
+    adminToken = token;
+}
+
+bool HttpServer::loadTemplates(const std::string& path) {
+    return aiGenerator && aiGenerator->loadTemplates(path);
+}
+
+bool HttpServer::configureGenerationCache(const GenerationCacheConfig& config) {
+    return aiGenerator && aiGenerator->configureGenerationCache(config);
+}
+
+void HttpServer::setSeed(std::optional<uint64_t> seed) {
+    if (aiGenerator) {
+        aiGenerator->setSeed(seed);
+    }
+}
+
+void HttpServer::setCandidatesPerQuestion(int count) {
+    if (aiGenerator) {
+        aiGenerator->setCandidatesPerQuestion(count);
+    }
+}
+
+void HttpServer::setLatencySlo(int milliseconds) {
+    if (aiGenerator) {
+        aiGenerator->setLatencySlo(milliseconds);
+    }
+}
+
+void HttpServer::setPrefillLatencyTarget(int milliseconds) {
+    if (aiGenerator) {
+        aiGenerator->setPrefillLatencyTarget(milliseconds);
+    }
+}
+
+bool HttpServer::setThreadPoolConfig(const ThreadPoolConfig& config, std::string& error) {
+    if (!aiGenerator) {
+        error = "AI generator not initialized";
+        return false;
+    }
+    return aiGenerator->setThreadPoolConfig(config, error);
+}
+
 bool HttpServer::reloadAIModel() {
     if (aiGenerator) {
-        return aiGenerator->reloadModels();
+        bool reloaded = aiGenerator->reloadModels();
+        rebuildCatalogBodies();
+        return reloaded;
     }
     return false;
 }
\ No newline at end of file
@@ -0,0 +1,170 @@
+#include "inference_pools.h"
+#include "resource_limits.h"
+#include "llama.h"
+#include "ggml-backend.h"
+#include "ggml-cpu.h"
+#include <iostream>
+#include <algorithm>
+
+namespace {
+
+using ThreadpoolNewFn = decltype(ggml_threadpool_new);
+using ThreadpoolFreeFn = decltype(ggml_threadpool_free);
+
+// With GGML_BACKEND_DL the CPU backend is a module loaded at runtime, so its
+// threadpool functions are not linked in and are looked up by name
+struct ThreadpoolApi {
+    ThreadpoolNewFn* create = nullptr;
+    ThreadpoolFreeFn* destroy = nullptr;
+};
+
+const ThreadpoolApi& threadpoolApi() {
+    static const ThreadpoolApi api = []() {
+        ThreadpoolApi resolved;
+        ggml_backend_dev_t cpu = ggml_backend_dev_by_type(GGML_BACKEND_DEVICE_TYPE_CPU);
+        ggml_backend_reg_t reg = cpu ? ggml_backend_dev_backend_reg(cpu) : nullptr;
+        if (reg) {
+            resolved.create = reinterpret_cast<ThreadpoolNewFn*>(ggml_backend_reg_get_proc_address(reg, "ggml_threadpool_new"));
+            resolved.destroy = reinterpret_cast<ThreadpoolFreeFn*>(ggml_backend_reg_get_proc_address(reg, "ggml_threadpool_free"));
+        }
+        return resolved;
+    }();
+    return api;
+}
+
+} // namespace
+
+bool ThreadPoolConfig::parsePriority(const std::string& name, int& priority) {
+    static const std::pair<const char*, ggml_sched_priority> kPriorities[] = {
+        {"normal", GGML_SCHED_PRIO_NORMAL},
+        {"medium", GGML_SCHED_PRIO_MEDIUM},
+        {"high", GGML_SCHED_PRIO_HIGH},
+        {"realtime", GGML_SCHED_PRIO_REALTIME},
+    };
+    for (const auto& entry : kPriorities) {
+        if (name == entry.first) {
+            priority = entry.second;
+            return true;
+        }
+    }
+    return false;
+}
+
+InferencePool::Turn::Turn(InferencePool& pool, Work work, std::chrono::milliseconds maxYield) : pool(pool) {
+    std::unique_lock<std::mutex> lock(pool.mutex);
+    if (work == Work::Step) {
+        pool.waitingSteps++;
+        pool.released.wait(lock, [&pool]() { return !pool.busy; });
+        pool.waitingSteps--;
+    } else {
+        // Let waiting steps go first, then compete like one
+        pool.released.wait_for(lock, maxYield, [&pool]() { return !pool.busy && pool.waitingSteps == 0; });
+        pool.released.wait(lock, [&pool]() { return !pool.busy; });
+    }
+    pool.busy = true;
+}
+
+InferencePool::Turn::~Turn() {
+    {
+        std::lock_guard<std::mutex> lock(pool.mutex);
+        pool.busy = false;
+    }
+    pool.released.notify_all();
+}
+
+InferencePool::~InferencePool() {
+    if (threadpool) {
+        threadpoolApi().destroy(threadpool);
+    }
+}
+
+bool InferencePools::configure(const ThreadPoolConfig& newConfig, std::string& error) {
+    int priority;
+    if (newConfig.pools < 1 || newConfig.pools > 16) {
+        error = "pools must be between 1 and 16";
+        return false;
+    }
+    if (newConfig.threads < 0 || newConfig.threads > GGML_MAX_N_THREADS) {
+        error = "threads must be between 0 and " + std::to_string(GGML_MAX_N_THREADS);
+        return false;
+    }
+    if (newConfig.poll < 0 || newConfig.poll > 100) {
+        error = "poll must be between 0 and 100";
+        return false;
+    }
+    if (!ThreadPoolConfig::parsePriority(newConfig.priority, priority)) {
+        error = "priority must be normal, medium, high or realtime";
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    config = newConfig;
+    // Contexts still hold the old pools, which are freed once the last one moves
+    pools.clear();
+    next = 0;
+    return true;
+}
+
+ThreadPoolConfig InferencePools::getConfig() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return config;
+}
+
+std::shared_ptr<InferencePool> InferencePools::assign() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (pools.empty() && !createPools()) {
+        return nullptr;
+    }
+    return pools[next++ % pools.size()];
+}
+
+bool InferencePools::createPools() {
+    if (unavailable) {
+        return false;
+    }
+    const ThreadpoolApi& api = threadpoolApi();
+    if (!api.create || !api.destroy) {
+        std::cerr << "⚠️ The CPU backend has no threadpool API, each context keeps its own threads" << std::endl;
+        unavailable = true;
+        return false;
+    }
+
+    int threads = config.threads > 0 ? config.threads
+                                     : std::max(1, ResourceLimits::current().cpuCount() / config.pools);
+    int priority = GGML_SCHED_PRIO_NORMAL;
+    ThreadPoolConfig::parsePriority(config.priority, priority);
+
+    for (int i = 0; i < config.pools; ++i) {
+        ggml_threadpool_params params = ggml_threadpool_params_default(threads);
+        params.prio = static_cast<ggml_sched_priority>(priority);
+        params.poll = static_cast<uint32_t>(config.poll);
+        params.strict_cpu = config.strictCpu;
+
+        auto pool = std::make_shared<InferencePool>();
+        pool->threadpool = api.create(&params);
+        pool->threads = threads;
+        if (!pool->threadpool) {
+            std::cerr << "❌ Failed to create inference threadpool " << i << std::endl;
+            pools.clear();
+            return false;
+        }
+        pools.push_back(std::move(pool));
+    }
+
+    std::cout << "🧵 Inference threadpools: " << config.pools << " x " << threads << " threads, poll "
+              << config.poll << ", priority " << config.priority << std::endl;
+    return true;
+}
+
+void InferencePools::attach(llama_context* context, const std::shared_ptr<InferencePool>& pool, int maxThreads) {
+    if (!pool) {
+        llama_detach_threadpool(context);
+        return;
+    }
+    // The graph is split between the pool's workers, so use all of them
+    // unless the model runs faster on fewer (small models spend more on
+    // synchronizing threads than they save)
+    int threads = maxThreads > 0 ? std::min(maxThreads, pool->threads) : pool->threads;
+    llama_attach_threadpool(context, pool->threadpool, pool->threadpool);
+    llama_set_n_threads(context, threads, threads);
+}
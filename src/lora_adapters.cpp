@@ -0,0 +1,50 @@
+#include "lora_adapters.h"
+#include "llama.h"
+#include <iostream>
+#include <filesystem>
+
+LoraAdapter::~LoraAdapter() {
+    if (adapter) {
+        llama_adapter_lora_free(adapter);
+    }
+}
+
+std::shared_ptr<LoraAdapter> LoraAdapterCache::get(const std::shared_ptr<llama_model>& weights,
+                                                   const std::string& path, std::string& error) {
+    // Loads are rare and brief, so they simply serialize
+    std::lock_guard<std::mutex> lock(mutex);
+    auto key = std::make_pair(static_cast<const llama_model*>(weights.get()), path);
+    if (auto loaded = adapters[key].lock()) {
+        return loaded;
+    }
+
+    if (!std::filesystem::is_regular_file(path)) {
+        error = "no adapter file " + path;
+        return nullptr;
+    }
+    auto loaded = std::make_shared<LoraAdapter>();
+    loaded->adapter = llama_adapter_lora_init(weights.get(), path.c_str());
+    if (!loaded->adapter) {
+        error = path + " is not a LoRA adapter for this model";
+        return nullptr;
+    }
+    loaded->weights = weights;
+    loaded->path = path;
+    adapters[key] = loaded;
+
+    // Forget adapters freed since, so the map tracks only live ones
+    for (auto it = adapters.begin(); it != adapters.end();) {
+        it = it->second.expired() ? adapters.erase(it) : std::next(it);
+    }
+
+    std::cout << "🧩 Loaded LoRA adapter " << path << std::endl;
+    return loaded;
+}
+
+void LoraAdapterCache::apply(llama_context* context, const std::vector<std::shared_ptr<LoraAdapter>>& adapters,
+                             const std::vector<LoraAdapterSpec>& specs) {
+    llama_clear_adapter_lora(context);
+    for (size_t i = 0; i < adapters.size() && i < specs.size(); ++i) {
+        llama_set_adapter_lora(context, adapters[i]->adapter, specs[i].scale);
+    }
+}
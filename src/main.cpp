@@ -1,24 +1,23 @@
 #include "http_server.h"
+#include "supervisor.h"
+#include "model_bench.h"
+#include "template_registry.h"
+#include "simd_kernels.h"
+#include "resource_limits.h"
 #include <iostream>
 #include <signal.h>
 #include <memory>
 #include <chrono>
 #include <thread>
 #include <iomanip>
+#include <cstdlib>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
 
-// Global server instance for signal handling
+// Global server instance, drained by the supervisor on shutdown
 std::unique_ptr<HttpServer> g_server;
 
-void signalHandler(int signal) {
-    std::cout << "\n🛑 Received signal " << signal << ". Shutting down gracefully..." << std::endl;
-    
-    if (g_server) {
-        g_server->stop();
-    }
-    
-    exit(0);
-}
-
 void printBanner() {
     std::cout << R"(
  █████╗ ███████╗ ██████╗ ███╗   ██╗     █████╗ ██╗
@@ -49,6 +48,18 @@ void printServerInfo(const std::string& host, int port, const std::string& model
     std::cout << "└─────────────────────────────────────────────────┘" << std::endl;
 }
 
+void printResourceLimits() {
+    const ResourceLimits& limits = ResourceLimits::current();
+    std::cout << "📦 CPU limit: " << limits.cpus << " (" << limits.cpuSource << "), using "
+              << limits.cpuCount() << std::endl;
+    if (limits.memoryBytes > 0) {
+        std::cout << "📦 Memory limit: " << (limits.memoryBytes / (1024 * 1024)) << " MB ("
+                  << limits.memorySource << ")" << std::endl;
+    }
+    std::cout << "📦 HTTP workers: " << limits.httpWorkers()
+              << ", default generation cache: " << (limits.generationCacheBytes() / (1024 * 1024)) << " MB" << std::endl;
+}
+
 void printEndpoints() {
     std::cout << "\n🔌 Available API Endpoints:" << std::endl;
     std::cout << "├─ GET  /                       → Status & health check" << std::endl;
@@ -60,7 +71,8 @@ void printEndpoints() {
     std::cout << "├─ Psychology Analysis:" << std::endl;
     std::cout << "│  ├─ GET  /api/psychology/traits   → Get personality traits" << std::endl;
     std::cout << "│  ├─ POST /api/psychology/generate → Create psychology questions" << std::endl;
-    std::cout << "│  └─ POST /api/psychology/analyze  → Analyze personality profile" << std::endl;
+    std::cout << "│  ├─ POST /api/psychology/analyze  → Analyze personality profile" << std::endl;
+    std::cout << "│  └─ POST /api/psychology/analyze/batch → Analyze many profiles (NDJSON)" << std::endl;
     std::cout << "│" << std::endl;
     std::cout << "└─ System Information:" << std::endl;
     std::cout << "   ├─ GET  /api/stats         → Detailed server statistics" << std::endl;
@@ -126,6 +138,56 @@ void printExpectedPerformance() {
     std::cout << "└─ Throughput:       1000-3000 operations/hour\n" << std::endl;
 }
 
+// Comma-separated positive integers, e.g. "1,4,8"
+std::vector<int> parseIntList(const std::string& text) {
+    std::vector<int> values;
+    std::stringstream stream(text);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        int value = std::stoi(item);
+        if (value < 1) {
+            throw std::invalid_argument("expected positive integers: " + text);
+        }
+        values.push_back(value);
+    }
+    return values;
+}
+
+int runBenchmark(const std::string& modelsConfigPath, const std::string& modelPath,
+                 const std::string& templatesPath, const BenchConfig& config, const std::string& jsonPath) {
+    ModelZooConfig zoo = ModelZooConfig::forRoles(modelPath, modelPath, modelPath);
+    std::string error;
+    if (!modelsConfigPath.empty() && !ModelZooConfig::load(modelsConfigPath, zoo, error)) {
+        std::cerr << "❌ Invalid model zoo " << modelsConfigPath << ": " << error << std::endl;
+        return 1;
+    }
+    
+    // Every quiz and psychology template, as requests would send them
+    TemplateRegistry templates;
+    templates.load(templatesPath, false);
+    std::vector<std::string> prompts = templates.snapshot()->allPrompts();
+    std::cerr << "⏱️ " << prompts.size() << " prompts, " << config.decodeTokens << " decoded tokens each" << std::endl;
+    
+    ModelBench bench(config);
+    std::vector<BenchResult> results = bench.run(zoo, prompts);
+    if (results.empty()) {
+        std::cerr << "❌ Nothing was benchmarked" << std::endl;
+        return 1;
+    }
+    
+    ModelBench::printTable(results, std::cout);
+    if (!jsonPath.empty()) {
+        std::ofstream out(jsonPath);
+        out << ModelBench::toJson(results) << std::endl;
+        if (!out) {
+            std::cerr << "❌ Failed to write " << jsonPath << std::endl;
+            return 1;
+        }
+        std::cerr << "📝 Results written to " << jsonPath << std::endl;
+    }
+    return 0;
+}
+
 int main(int argc, char* argv[]) {
     // Print banner
     printBanner();
@@ -134,6 +196,33 @@ int main(int argc, char* argv[]) {
     std::string host = "0.0.0.0";
     int port = 8080;
     std::string modelPath = "models/distilgpt2.Q4_K_M.gguf";
+    std::string modelsConfigPath;
+    std::vector<std::pair<GenerationRole, LoraAdapterSpec>> roleAdapters;
+    CompressionConfig compression;
+    QuestionBankConfig bankConfig;
+    bool bankEnabled = false;
+    EmbeddingIndexConfig embeddingConfig;
+    bool embeddingEnabled = false;
+    PlayerHistoryConfig historyConfig;
+    int candidates = 3;
+    std::optional<uint64_t> seed;
+    ThreadPoolConfig threadPoolConfig;
+    bool threadPoolConfigured = false;
+    AutoTuneConfig autoTuneConfig;
+    GenerationCacheConfig cacheConfig;
+    cacheConfig.maxBytes = ResourceLimits::current().generationCacheBytes();
+    bool cacheConfigured = false;
+    std::string templatesPath = "config/templates.json";
+    int drainTimeoutSeconds = 20;
+    int modelIdleSeconds = 900;
+    int latencySloMs = 5000;
+    int prefillChunkMs = 25;
+    std::string stateDirectory;
+    bool benchMode = false;
+    BenchConfig benchConfig;
+    std::string benchJsonPath;
+    const char* adminTokenEnv = std::getenv("AEON_ADMIN_TOKEN");
+    std::string adminToken = adminTokenEnv ? adminTokenEnv : "";
     
     for (int i = 1; i < argc; i++) {
         std::string arg = argv[i];
@@ -143,17 +232,154 @@ int main(int argc, char* argv[]) {
             port = std::stoi(argv[++i]);
         } else if ((arg == "--model" || arg == "-m") && i + 1 < argc) {
             modelPath = argv[++i];
+        } else if (arg == "--models" && i + 1 < argc) {
+            modelsConfigPath = argv[++i];
+        } else if (arg == "--lora" && i + 1 < argc) {
+            // <task>=<adapter path>
+            std::string value = argv[++i];
+            size_t separator = value.find('=');
+            GenerationRole role;
+            if (separator == std::string::npos || separator + 1 == value.size() ||
+                !parseGenerationRole(value.substr(0, separator), role)) {
+                std::cerr << "❌ --lora expects <quiz|psychology|analysis>=<adapter.gguf>" << std::endl;
+                return 1;
+            }
+            roleAdapters.push_back({role, {value.substr(separator + 1)}});
+        } else if (arg == "--compress-min-size" && i + 1 < argc) {
+            compression.minSize = std::stoul(argv[++i]);
+        } else if (arg == "--compress-level" && i + 1 < argc) {
+            compression.level = std::stoi(argv[++i]);
+        } else if (arg == "--no-compression") {
+            compression.enabled = false;
+        } else if (arg == "--bank" && i + 1 < argc) {
+            bankConfig.path = argv[++i];
+            bankEnabled = true;
+        } else if (arg == "--bank-freshness" && i + 1 < argc) {
+            bankConfig.freshness = std::stod(argv[++i]);
+        } else if (arg == "--bank-min" && i + 1 < argc) {
+            bankConfig.minEntriesToServe = std::stoi(argv[++i]);
+        } else if (arg == "--bank-target" && i + 1 < argc) {
+            bankConfig.targetEntriesPerKey = std::stoi(argv[++i]);
+        } else if (arg == "--embedding-index") {
+            embeddingEnabled = true;
+        } else if (arg == "--embedding-model" && i + 1 < argc) {
+            embeddingConfig.modelPath = argv[++i];
+            embeddingEnabled = true;
+        } else if (arg == "--topic-similarity" && i + 1 < argc) {
+            embeddingConfig.minSimilarity = std::stof(argv[++i]);
+        } else if (arg == "--player-history-ttl" && i + 1 < argc) {
+            historyConfig.ttl = std::chrono::seconds(std::stoi(argv[++i]));
+        } else if (arg == "--candidates" && i + 1 < argc) {
+            candidates = std::stoi(argv[++i]);
+        } else if (arg == "--seed" && i + 1 < argc) {
+            seed = std::stoull(argv[++i]);
+        } else if (arg == "--cache-size" && i + 1 < argc) {
+            cacheConfig.maxBytes = std::stoull(argv[++i]) * 1024 * 1024;
+            cacheConfigured = true;
+        } else if (arg == "--drain-timeout" && i + 1 < argc) {
+            drainTimeoutSeconds = std::stoi(argv[++i]);
+        } else if (arg == "--latency-slo" && i + 1 < argc) {
+            latencySloMs = std::stoi(argv[++i]);
+        } else if (arg == "--prefill-chunk-ms" && i + 1 < argc) {
+            prefillChunkMs = std::stoi(argv[++i]);
+        } else if (arg == "--model-idle-timeout" && i + 1 < argc) {
+            modelIdleSeconds = std::stoi(argv[++i]);
+        } else if (arg == "--state-dir" && i + 1 < argc) {
+            stateDirectory = argv[++i];
+        } else if (arg == "--admin-token" && i + 1 < argc) {
+            adminToken = argv[++i];
+        } else if (arg == "--templates" && i + 1 < argc) {
+            templatesPath = argv[++i];
+        } else if (arg == "--cache-path" && i + 1 < argc) {
+            cacheConfig.path = argv[++i];
+            cacheConfigured = true;
+        } else if (arg == "--autotune" && i + 1 < argc) {
+            autoTuneConfig.cachePath = argv[++i];
+        } else if (arg == "--retune") {
+            autoTuneConfig.retune = true;
+        } else if (arg == "--threadpools" && i + 1 < argc) {
+            threadPoolConfig.pools = std::stoi(argv[++i]);
+            threadPoolConfigured = true;
+        } else if (arg == "--threadpool-threads" && i + 1 < argc) {
+            threadPoolConfig.threads = std::stoi(argv[++i]);
+            threadPoolConfigured = true;
+        } else if (arg == "--thread-poll" && i + 1 < argc) {
+            threadPoolConfig.poll = std::stoi(argv[++i]);
+            threadPoolConfigured = true;
+        } else if (arg == "--thread-priority" && i + 1 < argc) {
+            threadPoolConfig.priority = argv[++i];
+            threadPoolConfigured = true;
+        } else if (arg == "--strict-cpu") {
+            threadPoolConfig.strictCpu = true;
+            threadPoolConfigured = true;
+        } else if (arg == "--simd" && i + 1 < argc) {
+            std::string variant = argv[++i];
+            if (!selectSimdKernels(variant)) {
+                std::cerr << "❌ SIMD kernels '" << variant << "' are not supported on this CPU" << std::endl;
+                return 1;
+            }
+        } else if (arg == "--bench") {
+            benchMode = true;
+        } else if (arg == "--bench-threads" && i + 1 < argc) {
+            benchConfig.threadCounts = parseIntList(argv[++i]);
+        } else if (arg == "--bench-batch" && i + 1 < argc) {
+            benchConfig.batchSizes = parseIntList(argv[++i]);
+        } else if (arg == "--bench-tokens" && i + 1 < argc) {
+            benchConfig.decodeTokens = std::stoi(argv[++i]);
+        } else if (arg == "--bench-json" && i + 1 < argc) {
+            benchJsonPath = argv[++i];
         } else if (arg == "--help") {
             std::cout << "Usage: " << argv[0] << " [options]" << std::endl;
             std::cout << "Options:" << std::endl;
             std::cout << "  --host, -h <host>     Server host (default: 0.0.0.0)" << std::endl;
             std::cout << "  --port, -p <port>     Server port (default: 8080)" << std::endl;
             std::cout << "  --model, -m <path>    Model path (default: models/distilgpt2.Q4_K_M.gguf)" << std::endl;
+            std::cout << "  --models <path>       Model zoo JSON routing tasks/categories/difficulties to models (overrides --model)" << std::endl;
+            std::cout << "  --lora <task>=<path>  LoRA adapter specializing --model for quiz, psychology or analysis (repeatable)" << std::endl;
+            std::cout << "  --compress-min-size <bytes>  Smallest response body to compress (default: 1024)" << std::endl;
+            std::cout << "  --compress-level <1-9>       Response compression level (default: 6)" << std::endl;
+            std::cout << "  --no-compression      Disable response compression" << std::endl;
+            std::cout << "  --bank <path>         Persist generated questions to a question bank at <path>" << std::endl;
+            std::cout << "  --bank-freshness <0-1>  Share of requests still sent to the model once stocked (default: 0.2)" << std::endl;
+            std::cout << "  --bank-min <n>        Questions per category/difficulty before serving from the bank (default: 20)" << std::endl;
+            std::cout << "  --bank-target <n>     Background growth target per category/difficulty (default: 200)" << std::endl;
+            std::cout << "  --embedding-index     Index banked questions by embedding for topic/subcategory requests (needs --bank)" << std::endl;
+            std::cout << "  --embedding-model <path>  GGUF to embed with (default: the quiz model; implies --embedding-index)" << std::endl;
+            std::cout << "  --topic-similarity <0-1>  Similarity a banked question needs to match a topic (default: 0.35)" << std::endl;
+            std::cout << "  --player-history-ttl <seconds>  Forget a player's seen questions after this idle time (default: 1800)" << std::endl;
+            std::cout << "  --candidates <1-4>    Quiz candidates decoded per question, best one served (default: 3)" << std::endl;
+            std::cout << "  --seed <n>            Make generation reproducible: same seed and inputs give the same output" << std::endl;
+            std::cout << "  --cache-size <MB>     Memory for cached seeded generations, 0 disables (default: 32, less under a small memory limit)" << std::endl;
+            std::cout << "  --cache-path <path>   Persist the generation cache to <path>.log" << std::endl;
+            std::cout << "  --latency-slo <ms>    Serve pooled/banked/cached content once the expected model wait exceeds this (default: 5000, 0: never)" << std::endl;
+            std::cout << "  --prefill-chunk-ms <ms>  Prefill prompts in chunks of about this long, between other models' decode steps (default: 25, 0: n_batch chunks)" << std::endl;
+            std::cout << "  --drain-timeout <sec> Time in-flight requests get to finish on SIGTERM (default: 20)" << std::endl;
+            std::cout << "  --model-idle-timeout <sec> Release a model's context after this long unused (default: 900, 0: never)" << std::endl;
+            std::cout << "  --state-dir <dir>     Save prompt KV caches here on shutdown and restore them at startup" << std::endl;
+            std::cout << "  --admin-token <token> Token for /api/admin/* (or AEON_ADMIN_TOKEN; default: localhost only)" << std::endl;
+            std::cout << "  --templates <path>    Prompt template file, reloaded on change (default: config/templates.json)" << std::endl;
+            std::cout << "  --threadpools <n>     Inference threadpools shared by all models; models on one take turns (default: 1)" << std::endl;
+            std::cout << "  --threadpool-threads <n>  Threads per pool (default: the CPU limit divided by the pools)" << std::endl;
+            std::cout << "  --thread-poll <0-100> How long idle inference threads spin before sleeping (default: 50)" << std::endl;
+            std::cout << "  --thread-priority <p> Inference thread priority: normal, medium, high or realtime (default: normal)" << std::endl;
+            std::cout << "  --strict-cpu          Pin each inference thread to its own CPU" << std::endl;
+            std::cout << "  --autotune <path>     Tune threads and batch sizes per model, cached in <path> by CPU and model" << std::endl;
+            std::cout << "  --retune              Measure again even when the tuning cache has results" << std::endl;
+            std::cout << "  --simd <variant>      Force the generic, avx2 or avx512 kernels (default: best the CPU supports)" << std::endl;
+            std::cout << "  --bench               Measure prefill/decode speed of the configured models over every template, then exit" << std::endl;
+            std::cout << "  --bench-threads <n,...>  Thread counts to sweep (default: the server's share and all cores)" << std::endl;
+            std::cout << "  --bench-batch <n,...>    Batch sizes to sweep (default: 32,128,512)" << std::endl;
+            std::cout << "  --bench-tokens <n>    Tokens decoded after each prompt (default: 64)" << std::endl;
+            std::cout << "  --bench-json <path>   Also write the results as JSON to <path>" << std::endl;
             std::cout << "  --help                Show this help message" << std::endl;
             return 0;
         }
     }
     
+    if (benchMode) {
+        return runBenchmark(modelsConfigPath, modelPath, templatesPath, benchConfig, benchJsonPath);
+    }
+    
     // Print server information
     printServerInfo(host, port, modelPath);
     printEndpoints();
@@ -164,13 +390,75 @@ int main(int argc, char* argv[]) {
     
     try {
         std::cout << "🔄 Initializing AEON AI Server..." << std::endl;
+        std::cout << "🧮 SIMD kernels: " << simdKernels().name << std::endl;
+        printResourceLimits();
+        
+        // Create server instance with AI model(s): a model zoo routes
+        // requests by task, category and difficulty; otherwise every task
+        // uses --model, specialized by its --lora adapters
+        if (!modelsConfigPath.empty()) {
+            ModelZooConfig zoo;
+            std::string error;
+            if (!ModelZooConfig::load(modelsConfigPath, zoo, error)) {
+                std::cerr << "❌ Invalid model zoo " << modelsConfigPath << ": " << error << std::endl;
+                return 1;
+            }
+            g_server = std::make_unique<HttpServer>(host, port, zoo);
+        } else {
+            ModelZooConfig zoo = ModelZooConfig::forRoles(modelPath, modelPath, modelPath);
+            for (const auto& roleAdapter : roleAdapters) {
+                zoo.models[zoo.resolve(roleAdapter.first, "", "")].adapters.push_back(roleAdapter.second);
+            }
+            g_server = std::make_unique<HttpServer>(host, port, zoo);
+        }
+        g_server->setCompressionConfig(compression);
+        g_server->setPlayerHistoryConfig(historyConfig);
+        g_server->setCandidatesPerQuestion(candidates);
+        g_server->setSeed(seed);
+        g_server->setLatencySlo(latencySloMs);
+        g_server->setPrefillLatencyTarget(prefillChunkMs);
         
-        // Create server instance with AI model
-        g_server = std::make_unique<HttpServer>(host, port, modelPath);
+        std::string threadPoolError;
+        if (threadPoolConfigured && !g_server->setThreadPoolConfig(threadPoolConfig, threadPoolError)) {
+            std::cerr << "❌ Invalid threadpool settings: " << threadPoolError << std::endl;
+            return 1;
+        }
+        g_server->setAdminToken(adminToken);
+        
+        if (!g_server->loadTemplates(templatesPath)) {
+            std::cout << "⚠️ Warning: could not load " << templatesPath << ", using built-in prompt templates" << std::endl;
+        }
+        
+        // Before any prompt state is restored: tuning recreates the contexts
+        if (!autoTuneConfig.cachePath.empty() && !g_server->enableAutoTune(autoTuneConfig)) {
+            std::cout << "⚠️ Warning: some models could not be tuned, they keep the default settings" << std::endl;
+        }
+        
+        if (cacheConfigured && !g_server->configureGenerationCache(cacheConfig)) {
+            std::cout << "⚠️ Warning: generation cache unavailable, using in-memory defaults" << std::endl;
+        }
+        
+        if (bankEnabled && !g_server->enableQuestionBank(bankConfig)) {
+            std::cout << "⚠️ Warning: question bank unavailable, serving generated questions only" << std::endl;
+        }
+        
+        if (embeddingEnabled) {
+            embeddingConfig.path = bankConfig.path + ".emb";
+            if (!bankEnabled || !g_server->enableEmbeddingIndex(embeddingConfig)) {
+                std::cout << "⚠️ Warning: embedding index unavailable, topics will not be targeted" << std::endl;
+                embeddingEnabled = false;
+            }
+        }
+        
+        if (!stateDirectory.empty() && !g_server->configureStateDirectory(stateDirectory)) {
+            std::cout << "⚠️ Warning: model state will not be persisted" << std::endl;
+        }
         
         // Set up signal handlers for graceful shutdown
-        signal(SIGINT, signalHandler);   // Ctrl+C
-        signal(SIGTERM, signalHandler);  // Termination signal
+        Supervisor supervisor;
+        if (!supervisor.handleSignals({SIGINT, SIGTERM})) {  // Ctrl+C, termination signal
+            return 1;
+        }
         
         std::cout << "✅ Server core initialized successfully!" << std::endl;
         
@@ -196,20 +484,40 @@ int main(int argc, char* argv[]) {
         std::cout << "AEON AI SERVER LOG:" << std::endl;
         std::cout << std::string(60, '=') << std::endl;
         
-        // Keep the main thread alive and show periodic stats
-        int counter = 0;
-        while (true) {
-            std::this_thread::sleep_for(std::chrono::seconds(1));
-            
-            // Print periodic stats every 2 minutes
-            if (++counter % 120 == 0 && g_server->getTotalRequests() > 0) {
+        // Periodic jobs; the main thread sleeps between them until a signal arrives
+        supervisor.every("stats", std::chrono::minutes(2), []() {
+            if (g_server->getTotalRequests() > 0) {
                 std::cout << "📊 AEON AI Status | "
                           << "Requests: " << g_server->getTotalRequests() 
                           << " | Success: " << g_server->getSuccessfulGenerations()
                           << " | Errors: " << g_server->getFailedGenerations()
                           << " | Uptime: " << g_server->getUptime() << std::endl;
             }
+        });
+        supervisor.every("pool-refill", std::chrono::seconds(30), []() {
+            g_server->refillPools();
+        });
+        supervisor.every("maintenance", std::chrono::minutes(1), []() {
+            g_server->runMaintenance();
+        });
+        if (embeddingEnabled) {
+            // Bounded batches, so a large unindexed bank does not hold up the other jobs
+            supervisor.every("embedding-index", std::chrono::seconds(15), []() {
+                g_server->indexBankedQuestions(256);
+            });
         }
+        if (modelIdleSeconds > 0) {
+            supervisor.every("model-idle", std::chrono::seconds(std::max(1, modelIdleSeconds / 4)), [modelIdleSeconds]() {
+                g_server->evictIdleModels(std::chrono::seconds(modelIdleSeconds));
+            });
+        }
+        
+        int received = supervisor.run();
+        std::cout << "\n🛑 Received signal " << received << ". Shutting down gracefully..." << std::endl;
+        
+        g_server->shutdown(std::chrono::seconds(drainTimeoutSeconds));
+        g_server.reset();
+        std::cout << "👋 AEON AI Server shut down cleanly" << std::endl;
         
     } catch (const std::exception& e) {
         std::cerr << "❌ Server error: " << e.what() << std::endl;
@@ -0,0 +1,247 @@
+#include "model_bench.h"
+#include "token_sampler.h"
+#include "resource_limits.h"
+#include "llama.h"
+#include "ggml-backend.h"
+#include <jsoncpp/json/json.h>
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <unordered_map>
+#include <unistd.h>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double secondsSince(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+size_t residentBytes() {
+    std::ifstream statm("/proc/self/statm");
+    size_t pages = 0, resident = 0;
+    statm >> pages >> resident;
+    return resident * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+}
+
+} // namespace
+
+ModelBench::ModelBench(const BenchConfig& config) : config(config) {
+    if (this->config.threadCounts.empty()) {
+        int cores = ResourceLimits::current().cpuCount();
+        this->config.threadCounts = {std::max(1, cores / 3), cores};
+    }
+    auto& threads = this->config.threadCounts;
+    std::sort(threads.begin(), threads.end());
+    threads.erase(std::unique(threads.begin(), threads.end()), threads.end());
+}
+
+std::vector<BenchResult> ModelBench::run(const ModelZooConfig& zoo, const std::vector<std::string>& prompts) {
+    std::vector<BenchResult> results;
+    llama_backend_init();
+    ggml_backend_load_all();
+
+    // Models sharing a file are measured once, under all their names
+    std::vector<std::pair<std::string, std::string>> files; // (names, path)
+    std::unordered_map<std::string, size_t> byPath;
+    for (const auto& spec : zoo.models) {
+        auto it = byPath.find(spec.path);
+        if (it == byPath.end()) {
+            byPath.emplace(spec.path, files.size());
+            files.emplace_back(spec.name, spec.path);
+        } else {
+            files[it->second].first += "+" + spec.name;
+        }
+    }
+
+    for (const auto& file : files) {
+        if (!benchModel(file.first, file.second, prompts, results)) {
+            std::cerr << "❌ Skipping " << file.first << std::endl;
+        }
+    }
+
+    llama_backend_free();
+    return results;
+}
+
+bool ModelBench::benchModel(const std::string& name, const std::string& path,
+                            const std::vector<std::string>& prompts, std::vector<BenchResult>& results) {
+    std::cerr << "⏱️ Benchmarking " << name << " (" << path << ")" << std::endl;
+
+    auto model_params = llama_model_default_params();
+    model_params.n_gpu_layers = 0; // CPU only, as served
+    std::unique_ptr<llama_model, decltype(&llama_model_free)> model(
+        llama_model_load_from_file(path.c_str(), model_params), llama_model_free);
+    if (!model) {
+        std::cerr << "❌ Failed to load model from: " << path << std::endl;
+        return false;
+    }
+    return benchWeights(model.get(), name, prompts, results);
+}
+
+bool ModelBench::benchWeights(llama_model* model, const std::string& name, const std::vector<std::string>& prompts,
+                              std::vector<BenchResult>& results) {
+    // Prompts are cut so the decoded tokens still fit in the context
+    const llama_vocab* vocab = llama_model_get_vocab(model);
+    const int n_vocab = llama_vocab_n_tokens(vocab);
+    const int maxPromptTokens = std::max(1, config.contextSize - config.decodeTokens - 1);
+    std::vector<std::vector<llama_token>> tokenized;
+    for (const auto& prompt : prompts) {
+        std::vector<llama_token> tokens(prompt.length() + 1);
+        int n = llama_tokenize(vocab, prompt.c_str(), prompt.length(), tokens.data(), tokens.size(), false, true);
+        if (n > 0) {
+            tokens.resize(std::min(n, maxPromptTokens));
+            tokenized.push_back(std::move(tokens));
+        }
+    }
+    if (tokenized.empty()) {
+        std::cerr << "❌ No prompt could be tokenized for " << name << std::endl;
+        return false;
+    }
+
+    // (batch, ubatch) pairs; a ubatch larger than its batch would be cut to it
+    std::vector<std::pair<int, int>> batches;
+    for (int batchSize : config.batchSizes) {
+        if (config.ubatchSizes.empty()) {
+            batches.emplace_back(batchSize, batchSize);
+        }
+        for (int ubatchSize : config.ubatchSizes) {
+            if (ubatchSize <= batchSize) {
+                batches.emplace_back(batchSize, ubatchSize);
+            }
+        }
+    }
+
+    GenerationParams sampling; // The quiz defaults
+    for (const auto& [batchSize, ubatchSize] : batches) {
+        size_t residentBefore = residentBytes();
+
+        auto ctx_params = llama_context_default_params();
+        ctx_params.n_ctx = config.contextSize;
+        ctx_params.n_batch = batchSize;
+        ctx_params.n_ubatch = ubatchSize;
+        ctx_params.n_seq_max = 1;
+        ctx_params.n_threads = config.threadCounts.back();
+        ctx_params.n_threads_batch = config.threadCounts.back();
+        std::unique_ptr<llama_context, decltype(&llama_free)> context(
+            llama_init_from_model(model, ctx_params), llama_free);
+        if (!context) {
+            std::cerr << "❌ Failed to create a context with batch size " << batchSize << "/" << ubatchSize << std::endl;
+            continue;
+        }
+
+        // One untimed pass faults in the weights and KV buffers
+        llama_decode(context.get(), llama_batch_get_one(tokenized.front().data(), 1));
+        llama_synchronize(context.get());
+
+        for (int threads : config.threadCounts) {
+            llama_set_n_threads(context.get(), threads, threads);
+
+            BenchResult result;
+            result.model = name;
+            result.threads = threads;
+            result.batchSize = batchSize;
+            result.ubatchSize = ubatchSize;
+
+            double prefillSeconds = 0.0, decodeSeconds = 0.0, samplerSeconds = 0.0;
+            std::mt19937_64 rng(42);
+            for (auto& tokens : tokenized) {
+                llama_kv_self_clear(context.get());
+
+                auto start = Clock::now();
+                bool ok = true;
+                for (size_t pos = 0; ok && pos < tokens.size(); pos += batchSize) {
+                    int chunk = static_cast<int>(std::min<size_t>(batchSize, tokens.size() - pos));
+                    ok = llama_decode(context.get(), llama_batch_get_one(tokens.data() + pos, chunk)) == 0;
+                }
+                llama_synchronize(context.get());
+                prefillSeconds += secondsSince(start);
+                if (!ok) {
+                    std::cerr << "❌ Prefill failed at batch size " << batchSize << std::endl;
+                    break;
+                }
+                result.promptTokens += tokens.size();
+
+                // End-of-generation tokens are sampled through like any
+                // other, so every prompt decodes the same number of tokens
+                for (int i = 0; i < config.decodeTokens; ++i) {
+                    start = Clock::now();
+                    llama_token token = sampleToken(llama_get_logits_ith(context.get(), -1), n_vocab, sampling, rng);
+                    samplerSeconds += secondsSince(start);
+
+                    start = Clock::now();
+                    ok = llama_decode(context.get(), llama_batch_get_one(&token, 1)) == 0;
+                    llama_synchronize(context.get());
+                    decodeSeconds += secondsSince(start);
+                    if (!ok) {
+                        break;
+                    }
+                    result.decodedTokens++;
+                }
+            }
+
+            result.prefillTokensPerSec = prefillSeconds > 0 ? result.promptTokens / prefillSeconds : 0.0;
+            result.decodeTokensPerSec = decodeSeconds > 0 ? result.decodedTokens / decodeSeconds : 0.0;
+            result.samplerUsPerToken = result.decodedTokens > 0 ? samplerSeconds * 1e6 / result.decodedTokens : 0.0;
+            size_t residentAfter = residentBytes();
+            result.contextBytes = residentAfter > residentBefore ? residentAfter - residentBefore : 0;
+            results.push_back(result);
+
+            std::cerr << "   threads " << threads << ", batch " << batchSize << "/" << ubatchSize << ": "
+                      << std::fixed << std::setprecision(1) << result.prefillTokensPerSec << " prefill tok/s, "
+                      << result.decodeTokensPerSec << " decode tok/s" << std::endl;
+        }
+    }
+    return true;
+}
+
+void ModelBench::printTable(const std::vector<BenchResult>& results, std::ostream& out) {
+    out << std::left << std::setw(28) << "model" << std::right
+        << std::setw(8) << "threads" << std::setw(7) << "batch" << std::setw(8) << "ubatch"
+        << std::setw(14) << "prefill t/s" << std::setw(13) << "decode t/s"
+        << std::setw(14) << "sampler us/t" << std::setw(12) << "ctx MB" << std::endl;
+    out << std::string(104, '-') << std::endl;
+
+    for (const auto& result : results) {
+        out << std::left << std::setw(28) << result.model.substr(0, 27) << std::right
+            << std::setw(8) << result.threads << std::setw(7) << result.batchSize << std::setw(8) << result.ubatchSize
+            << std::fixed << std::setprecision(1)
+            << std::setw(14) << result.prefillTokensPerSec << std::setw(13) << result.decodeTokensPerSec
+            << std::setw(14) << result.samplerUsPerToken
+            << std::setw(12) << result.contextBytes / (1024.0 * 1024.0) << std::endl;
+    }
+}
+
+std::string ModelBench::toJson(const std::vector<BenchResult>& results) {
+    Json::Value report;
+    report["timestamp"] = static_cast<Json::Int64>(std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count());
+    report["cores"] = std::thread::hardware_concurrency();
+    report["cpuLimit"] = ResourceLimits::current().cpus;
+
+    Json::Value runs(Json::arrayValue);
+    for (const auto& result : results) {
+        Json::Value run;
+        run["model"] = result.model;
+        run["threads"] = result.threads;
+        run["batchSize"] = result.batchSize;
+        run["ubatchSize"] = result.ubatchSize;
+        run["promptTokens"] = static_cast<Json::UInt64>(result.promptTokens);
+        run["prefillTokensPerSec"] = result.prefillTokensPerSec;
+        run["decodedTokens"] = static_cast<Json::UInt64>(result.decodedTokens);
+        run["decodeTokensPerSec"] = result.decodeTokensPerSec;
+        run["samplerUsPerToken"] = result.samplerUsPerToken;
+        run["contextBytes"] = static_cast<Json::UInt64>(result.contextBytes);
+        runs.append(run);
+    }
+    report["results"] = runs;
+
+    Json::StreamWriterBuilder builder;
+    builder["indentation"] = "  ";
+    return Json::writeString(builder, report);
+}
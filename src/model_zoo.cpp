@@ -0,0 +1,147 @@
+#include "model_zoo.h"
+#include <jsoncpp/json/json.h>
+#include <fstream>
+#include <sstream>
+#include <cmath>
+
+int ModelZooConfig::resolve(GenerationRole task, const std::string& category, const std::string& difficulty) const {
+    for (const auto& route : routes) {
+        if ((!route.task || *route.task == task) &&
+            (route.category.empty() || route.category == category) &&
+            (route.difficulty.empty() || route.difficulty == difficulty)) {
+            return static_cast<int>(route.model);
+        }
+    }
+    return -1;
+}
+
+ModelZooConfig ModelZooConfig::forRoles(const std::string& quizPath, const std::string& psychologyPath,
+                                        const std::string& analysisPath) {
+    ModelZooConfig config;
+    config.models = {{"Quiz-Model", quizPath, {}}, {"Psychology-Model", psychologyPath, {}},
+                     {"Analysis-Model", analysisPath, {}}};
+    config.routes = {{GenerationRole::Quiz, "", "", 0},
+                     {GenerationRole::Psychology, "", "", 1},
+                     {GenerationRole::Analysis, "", "", 2}};
+    return config;
+}
+
+bool ModelZooConfig::parse(const std::string& json, ModelZooConfig& config, std::string& error) {
+    Json::Value root;
+    Json::CharReaderBuilder builder;
+    std::istringstream stream(json);
+    if (!Json::parseFromStream(builder, stream, &root, &error)) {
+        return false;
+    }
+
+    const Json::Value& models = root["models"];
+    if (!models.isObject() || models.empty()) {
+        error = "'models' must be a non-empty object mapping names to model paths";
+        return false;
+    }
+    for (const auto& name : models.getMemberNames()) {
+        // A path, or {"path": ..., "adapters": [...]}
+        const Json::Value& entry = models[name];
+        ModelSpec spec{name, "", {}};
+        if (entry.isString()) {
+            spec.path = entry.asString();
+        } else if (entry.isObject() && entry["path"].isString()) {
+            spec.path = entry["path"].asString();
+        }
+        if (spec.path.empty()) {
+            error = "model '" + name + "' needs a path";
+            return false;
+        }
+        if (entry.isObject() && entry.isMember("adapters") && !parseAdapters(entry["adapters"], spec.adapters, error)) {
+            error = "model '" + name + "': " + error;
+            return false;
+        }
+        config.models.push_back(std::move(spec));
+    }
+
+    const Json::Value& routes = root["routes"];
+    if (!routes.isArray() || routes.empty()) {
+        error = "'routes' must be a non-empty array";
+        return false;
+    }
+    for (const auto& entry : routes) {
+        ModelRoute route;
+
+        std::string task = entry.get("task", "").asString();
+        if (!task.empty() && task != "*") {
+            GenerationRole role;
+            if (!parseGenerationRole(task, role)) {
+                error = "unknown task '" + task + "' (expected quiz, psychology or analysis)";
+                return false;
+            }
+            route.task = role;
+        }
+        route.category = entry.get("category", "").asString();
+        route.difficulty = entry.get("difficulty", "").asString();
+
+        std::string model = entry.get("model", "").asString();
+        size_t index = 0;
+        while (index < config.models.size() && config.models[index].name != model) {
+            index++;
+        }
+        if (index == config.models.size()) {
+            error = "route refers to unknown model '" + model + "'";
+            return false;
+        }
+        route.model = index;
+        config.routes.push_back(std::move(route));
+    }
+
+    // A name no category or difficulty uses, to find the catch-all routes
+    const std::string unmatched(1, '\0');
+    for (size_t i = 0; i < kGenerationRoleCount; ++i) {
+        GenerationRole role = static_cast<GenerationRole>(i);
+        if (config.resolve(role, unmatched, unmatched) < 0) {
+            error = std::string("no catch-all route for task '") + generationRoleName(role) + "'";
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool ModelZooConfig::parseAdapters(const Json::Value& json, std::vector<LoraAdapterSpec>& adapters,
+                                   std::string& error) {
+    if (!json.isArray()) {
+        error = "'adapters' must be an array";
+        return false;
+    }
+    std::vector<LoraAdapterSpec> parsed;
+    for (const auto& entry : json) {
+        LoraAdapterSpec adapter;
+        if (entry.isString()) {
+            adapter.path = entry.asString();
+        } else if (entry.isObject() && entry["path"].isString()) {
+            adapter.path = entry["path"].asString();
+            const Json::Value& scale = entry.get("scale", 1.0);
+            if (!scale.isNumeric() || !std::isfinite(scale.asDouble())) {
+                error = "adapter scale must be a number";
+                return false;
+            }
+            adapter.scale = scale.asFloat();
+        }
+        if (adapter.path.empty()) {
+            error = "each adapter needs a path";
+            return false;
+        }
+        parsed.push_back(std::move(adapter));
+    }
+    adapters = std::move(parsed);
+    return true;
+}
+
+bool ModelZooConfig::load(const std::string& path, ModelZooConfig& config, std::string& error) {
+    std::ifstream file(path);
+    if (!file) {
+        error = "cannot read " + path;
+        return false;
+    }
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    return parse(buffer.str(), config, error);
+}
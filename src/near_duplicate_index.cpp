@@ -0,0 +1,149 @@
+#include "near_duplicate_index.h"
+#include "simd_kernels.h"
+#include <cctype>
+#include <mutex>
+#include <sstream>
+#include <unordered_set>
+
+namespace {
+
+// Question boilerplate that every template produces; ignoring it keeps the
+// hash focused on what the question is actually about
+const std::unordered_set<std::string>& stopWords() {
+    static const std::unordered_set<std::string> words = {
+        "a", "an", "the", "of", "in", "on", "to", "is", "are", "was", "which", "what",
+        "who", "how", "does", "do", "and", "or", "for", "by", "with", "that", "this",
+        "our", "your", "its", "be", "can"};
+    return words;
+}
+
+uint64_t hashToken(const std::string& token) {
+    // FNV-1a followed by a splitmix64 finalizer to spread the bits evenly
+    uint64_t hash = 14695981039346656037ull;
+    for (unsigned char c : token) {
+        hash = (hash ^ c) * 1099511628211ull;
+    }
+    hash ^= hash >> 30;
+    hash *= 0xbf58476d1ce4e5b9ull;
+    hash ^= hash >> 27;
+    hash *= 0x94d049bb133111ebull;
+    hash ^= hash >> 31;
+    return hash;
+}
+
+} // namespace
+
+std::string NearDuplicateIndex::normalize(const std::string& text) {
+    std::string normalized;
+    normalized.reserve(text.size());
+
+    bool pendingSpace = false;
+    for (unsigned char c : text) {
+        if (std::isalnum(c)) {
+            if (pendingSpace && !normalized.empty()) {
+                normalized.push_back(' ');
+            }
+            normalized.push_back(static_cast<char>(std::tolower(c)));
+            pendingSpace = false;
+        } else {
+            pendingSpace = true;
+        }
+    }
+    return normalized;
+}
+
+uint64_t NearDuplicateIndex::simhash(const std::string& text) {
+    std::vector<std::string> tokens;
+    std::istringstream stream(normalize(text));
+    std::string word;
+    while (stream >> word) {
+        if (stopWords().count(word) == 0) {
+            tokens.push_back(word);
+        }
+    }
+
+    int32_t weights[64] = {0};
+    const SimdKernels& kernels = simdKernels();
+    auto addFeature = [&weights, &kernels](uint64_t featureHash) { kernels.addSimhashFeature(weights, featureHash); };
+
+    // Character 4-gram shingles over the remaining words: questions are only
+    // a handful of words long, so whole-word features alone make one changed
+    // word flip a large share of the hash bits
+    std::string joined;
+    for (const auto& token : tokens) {
+        if (!joined.empty()) {
+            joined.push_back(' ');
+        }
+        joined += token;
+    }
+
+    const size_t shingle = 4;
+    if (joined.size() <= shingle) {
+        addFeature(hashToken(joined));
+    }
+    for (size_t i = 0; i + shingle <= joined.size(); ++i) {
+        addFeature(hashToken(joined.substr(i, shingle)));
+    }
+
+    uint64_t hash = 0;
+    for (int bit = 0; bit < 64; ++bit) {
+        if (weights[bit] > 0) {
+            hash |= 1ull << bit;
+        }
+    }
+    return hash;
+}
+
+int NearDuplicateIndex::distance(uint64_t a, uint64_t b) {
+    return __builtin_popcountll(a ^ b);
+}
+
+uint16_t NearDuplicateIndex::bandKey(uint64_t hash, int band) {
+    return static_cast<uint16_t>(hash >> (band * kBandBits));
+}
+
+bool NearDuplicateIndex::containsNearLocked(uint64_t hash) const {
+    for (int band = 0; band < kBands; ++band) {
+        auto it = bands[band].find(bandKey(hash, band));
+        if (it == bands[band].end()) {
+            continue;
+        }
+        for (uint64_t candidate : it->second) {
+            if (distance(hash, candidate) <= kMaxDistance) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+void NearDuplicateIndex::insertLocked(uint64_t hash) {
+    for (int band = 0; band < kBands; ++band) {
+        bands[band][bandKey(hash, band)].push_back(hash);
+    }
+    count++;
+}
+
+bool NearDuplicateIndex::containsNear(uint64_t hash) const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    return containsNearLocked(hash);
+}
+
+void NearDuplicateIndex::insert(uint64_t hash) {
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    insertLocked(hash);
+}
+
+bool NearDuplicateIndex::insertIfNovel(uint64_t hash) {
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    if (containsNearLocked(hash)) {
+        return false;
+    }
+    insertLocked(hash);
+    return true;
+}
+
+size_t NearDuplicateIndex::size() const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    return count;
+}
@@ -0,0 +1,146 @@
+#include "player_history.h"
+
+namespace {
+
+uint64_t mix64(uint64_t x) {
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ull;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebull;
+    x ^= x >> 31;
+    return x;
+}
+
+} // namespace
+
+PlayerHistory::PlayerHistory(const PlayerHistoryConfig& config)
+    : config(config), epoch(std::chrono::steady_clock::now()) {}
+
+uint32_t PlayerHistory::now() const {
+    return static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::steady_clock::now() - epoch).count());
+}
+
+uint64_t PlayerHistory::playerKey(const std::string& player) {
+    // Store a 64-bit hash instead of the name to keep entries fixed-size
+    uint64_t hash = 14695981039346656037ull;
+    for (unsigned char c : player) {
+        hash = (hash ^ c) * 1099511628211ull;
+    }
+    return mix64(hash);
+}
+
+bool PlayerHistory::testBits(const std::array<uint64_t, kFilterWords>& filter, uint64_t fingerprint) {
+    // Double hashing: bit_i = h1 + i * h2
+    uint64_t h1 = fingerprint;
+    uint64_t h2 = mix64(fingerprint) | 1;
+    for (int i = 0; i < kHashes; ++i) {
+        uint64_t bit = (h1 + static_cast<uint64_t>(i) * h2) % (kFilterWords * 64);
+        if (!(filter[bit / 64] & (1ull << (bit % 64)))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void PlayerHistory::setBits(std::array<uint64_t, kFilterWords>& filter, uint64_t fingerprint) {
+    uint64_t h1 = fingerprint;
+    uint64_t h2 = mix64(fingerprint) | 1;
+    for (int i = 0; i < kHashes; ++i) {
+        uint64_t bit = (h1 + static_cast<uint64_t>(i) * h2) % (kFilterWords * 64);
+        filter[bit / 64] |= 1ull << (bit % 64);
+    }
+}
+
+bool PlayerHistory::hasSeen(const std::string& player, uint64_t fingerprint) const {
+    uint64_t key = playerKey(player);
+    const Shard& shard = shards[key % kShards];
+
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.players.find(key);
+    if (it == shard.players.end()) {
+        return false;
+    }
+
+    // An expired entry that has not been swept yet counts as a fresh player
+    if (now() - it->second.lastSeen > static_cast<uint32_t>(config.ttl.count())) {
+        return false;
+    }
+    return testBits(it->second.current, fingerprint) || testBits(it->second.previous, fingerprint);
+}
+
+void PlayerHistory::markSeen(const std::string& player, uint64_t fingerprint) {
+    uint64_t key = playerKey(player);
+    Shard& shard = shards[key % kShards];
+    uint32_t timestamp = now();
+
+    {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto inserted = shard.players.emplace(key, Entry());
+        Entry& entry = inserted.first->second;
+
+        if (inserted.second) {
+            playerCount++;
+        } else if (timestamp - entry.lastSeen > static_cast<uint32_t>(config.ttl.count())) {
+            entry = Entry();
+        }
+
+        if (entry.currentCount >= config.rotateAfter) {
+            entry.previous = entry.current;
+            entry.current.fill(0);
+            entry.currentCount = 0;
+        }
+
+        setBits(entry.current, fingerprint);
+        entry.currentCount++;
+        entry.lastSeen = timestamp;
+    }
+
+    // Amortize eviction: every 1024 updates, sweep one shard in rotation
+    uint64_t op = operations.fetch_add(1);
+    if ((op & 1023) == 1023) {
+        uint32_t ttl = static_cast<uint32_t>(config.ttl.count());
+        if (timestamp > ttl) {
+            sweepShard(shards[(op >> 10) % kShards], timestamp - ttl);
+        }
+    }
+}
+
+size_t PlayerHistory::sweepShard(Shard& shard, uint32_t cutoff) {
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    size_t removed = 0;
+    for (auto it = shard.players.begin(); it != shard.players.end();) {
+        if (it->second.lastSeen < cutoff) {
+            it = shard.players.erase(it);
+            removed++;
+        } else {
+            ++it;
+        }
+    }
+    playerCount -= removed;
+    return removed;
+}
+
+size_t PlayerHistory::sweep() {
+    uint32_t timestamp = now();
+    uint32_t ttl = static_cast<uint32_t>(config.ttl.count());
+    if (timestamp <= ttl) {
+        return 0;
+    }
+
+    size_t removed = 0;
+    for (auto& shard : shards) {
+        removed += sweepShard(shard, timestamp - ttl);
+    }
+    return removed;
+}
+
+size_t PlayerHistory::activePlayers() const {
+    return playerCount.load();
+}
+
+size_t PlayerHistory::approximateMemoryBytes() const {
+    // Entry plus key, hash-node pointers and bucket slot
+    const size_t perPlayer = sizeof(Entry) + sizeof(uint64_t) + 3 * sizeof(void*);
+    return activePlayers() * perPlayer;
+}
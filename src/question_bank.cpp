@@ -0,0 +1,395 @@
+#include "question_bank.h"
+#include "ai_quiz_generator.h"
+#include "near_duplicate_index.h"
+#include <iostream>
+#include <cstring>
+#include <cctype>
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace {
+
+const char kIndexMagic[8] = {'A', 'E', 'O', 'N', 'Q', 'I', 'D', 'X'};
+const uint32_t kIndexVersion = 2; // v2: fingerprint is a SimHash
+const uint8_t kRecordVersion = 1;
+const uint64_t kInitialIndexCapacity = 1024;
+
+void putU32(std::string& out, uint32_t value) {
+    out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+void putU64(std::string& out, uint64_t value) {
+    out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+void putString(std::string& out, const std::string& value) {
+    putU32(out, static_cast<uint32_t>(value.size()));
+    out.append(value);
+}
+
+class PayloadReader {
+public:
+    explicit PayloadReader(const std::string& payload) : data(payload), pos(0) {}
+
+    bool u8(uint8_t& value) { return raw(&value, sizeof(value)); }
+    bool u32(uint32_t& value) { return raw(&value, sizeof(value)); }
+    bool u64(uint64_t& value) { return raw(&value, sizeof(value)); }
+
+    bool string(std::string& value) {
+        uint32_t length;
+        if (!u32(length) || pos + length > data.size()) {
+            return false;
+        }
+        value.assign(data, pos, length);
+        pos += length;
+        return true;
+    }
+
+private:
+    bool raw(void* out, size_t length) {
+        if (pos + length > data.size()) {
+            return false;
+        }
+        std::memcpy(out, data.data() + pos, length);
+        pos += length;
+        return true;
+    }
+
+    const std::string& data;
+    size_t pos;
+};
+
+uint32_t unixSeconds() {
+    return static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count());
+}
+
+} // namespace
+
+QuestionBank::QuestionBank(const QuestionBankConfig& config) : config(config) {
+    log.setSyncOnAppend(config.syncOnAppend);
+}
+
+QuestionBank::~QuestionBank() {
+    close();
+}
+
+uint32_t QuestionBank::keyHash(const std::string& category, const std::string& difficulty) {
+    // FNV-1a over "category\0difficulty"
+    uint32_t hash = 2166136261u;
+    auto mix = [&hash](const std::string& s) {
+        for (unsigned char c : s) {
+            hash = (hash ^ c) * 16777619u;
+        }
+    };
+    mix(category);
+    hash = (hash ^ 0u) * 16777619u;
+    mix(difficulty);
+    return hash;
+}
+
+uint64_t QuestionBank::fingerprint(const std::string& questionText) {
+    return NearDuplicateIndex::simhash(questionText);
+}
+
+std::string QuestionBank::serialize(const QuizQuestion& question) {
+    std::string out;
+    out.reserve(256);
+    out.push_back(static_cast<char>(kRecordVersion));
+    putString(out, question.question);
+    putU32(out, static_cast<uint32_t>(question.answers.size()));
+    for (const auto& answer : question.answers) {
+        putString(out, answer);
+    }
+    putU32(out, static_cast<uint32_t>(question.correctAnswerIndex));
+    putString(out, question.category);
+    putString(out, question.difficulty);
+    putString(out, question.aiModel);
+    putU64(out, unixSeconds());
+    putU32(out, static_cast<uint32_t>(question.generationTimeMs));
+    return out;
+}
+
+bool QuestionBank::deserialize(const std::string& payload, QuizQuestion& question) {
+    PayloadReader reader(payload);
+
+    uint8_t version;
+    uint32_t answerCount, correctIndex, generationTimeMs;
+    uint64_t createdAt;
+    if (!reader.u8(version) || version != kRecordVersion ||
+        !reader.string(question.question) || !reader.u32(answerCount) || answerCount > 16) {
+        return false;
+    }
+
+    question.answers.resize(answerCount);
+    for (auto& answer : question.answers) {
+        if (!reader.string(answer)) {
+            return false;
+        }
+    }
+
+    if (!reader.u32(correctIndex) || !reader.string(question.category) ||
+        !reader.string(question.difficulty) || !reader.string(question.aiModel) ||
+        !reader.u64(createdAt) || !reader.u32(generationTimeMs)) {
+        return false;
+    }
+
+    question.correctAnswerIndex = static_cast<int>(correctIndex);
+    question.generationTimeMs = static_cast<int>(generationTimeMs);
+    question.generated = true;
+    return true;
+}
+
+bool QuestionBank::open() {
+    std::unique_lock<std::shared_mutex> lock(indexMutex);
+
+    bool rebuild = false;
+    if (!openIndex(rebuild)) {
+        return false;
+    }
+
+    // An index that claims more of the log than exists cannot be trusted
+    std::string logPath = config.path + ".log";
+    struct stat st;
+    uint64_t logSize = (::stat(logPath.c_str(), &st) == 0) ? static_cast<uint64_t>(st.st_size) : 0;
+    if (rebuild || header()->logEnd > logSize) {
+        header()->count = 0;
+        header()->logEnd = RecordLog::firstRecordOffset();
+        rebuild = true;
+    }
+
+    // Records the index has not seen yet (everything, when rebuilding) are
+    // verified and indexed as the log is opened
+    uint64_t recovered = 0;
+    bool opened = log.open(logPath, header()->logEnd,
+                           [this, &recovered](uint64_t offset, const std::string& payload) {
+        QuizQuestion question;
+        if (deserialize(payload, question) && addIndexEntry(offset, question)) {
+            recovered++;
+        }
+    });
+    if (!opened) {
+        closeIndex();
+        return false;
+    }
+
+    // Drop index entries that point past the (possibly truncated) log
+    while (header()->count > 0 && entries()[header()->count - 1].offset >= log.size()) {
+        header()->count--;
+    }
+    header()->logEnd = log.size();
+
+    entriesByKey.clear();
+    for (uint64_t i = 0; i < header()->count; ++i) {
+        entriesByKey[entries()[i].keyHash].push_back(static_cast<uint32_t>(i));
+    }
+
+    std::cout << "🏦 Question bank opened: " << header()->count << " questions"
+              << (rebuild ? " (index rebuilt)" : "")
+              << (recovered > 0 && !rebuild ? ", recovered " + std::to_string(recovered) : "")
+              << std::endl;
+    return true;
+}
+
+bool QuestionBank::openIndex(bool& rebuild) {
+    std::string indexPath = config.path + ".idx";
+    indexFd = ::open(indexPath.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (indexFd < 0) {
+        std::cerr << "❌ Failed to open question bank index: " << indexPath << std::endl;
+        return false;
+    }
+
+    struct stat st;
+    fstat(indexFd, &st);
+    size_t fileSize = static_cast<size_t>(st.st_size);
+
+    IndexHeader existing{};
+    bool valid = fileSize >= sizeof(IndexHeader) &&
+                 pread(indexFd, &existing, sizeof(existing), 0) == static_cast<ssize_t>(sizeof(existing)) &&
+                 std::memcmp(existing.magic, kIndexMagic, sizeof(kIndexMagic)) == 0 &&
+                 existing.version == kIndexVersion &&
+                 existing.entrySize == sizeof(IndexEntry) &&
+                 sizeof(IndexHeader) + existing.count * sizeof(IndexEntry) <= fileSize;
+
+    size_t minSize = sizeof(IndexHeader) + kInitialIndexCapacity * sizeof(IndexEntry);
+    if (!valid) {
+        rebuild = true;
+        if (ftruncate(indexFd, 0) != 0 || ftruncate(indexFd, static_cast<off_t>(minSize)) != 0) {
+            closeIndex();
+            return false;
+        }
+        fileSize = minSize;
+    }
+
+    indexMap = static_cast<char*>(mmap(nullptr, fileSize, PROT_READ | PROT_WRITE, MAP_SHARED, indexFd, 0));
+    if (indexMap == MAP_FAILED) {
+        indexMap = nullptr;
+        std::cerr << "❌ Failed to map question bank index: " << indexPath << std::endl;
+        closeIndex();
+        return false;
+    }
+    indexMapSize = fileSize;
+
+    if (!valid) {
+        std::memcpy(header()->magic, kIndexMagic, sizeof(kIndexMagic));
+        header()->version = kIndexVersion;
+        header()->entrySize = sizeof(IndexEntry);
+        header()->count = 0;
+        header()->logEnd = RecordLog::firstRecordOffset();
+    }
+    return true;
+}
+
+bool QuestionBank::growIndex(uint64_t minEntries) {
+    size_t capacity = (indexMapSize - sizeof(IndexHeader)) / sizeof(IndexEntry);
+    if (minEntries <= capacity) {
+        return true;
+    }
+
+    size_t newSize = sizeof(IndexHeader) + std::max<size_t>(capacity * 2, minEntries) * sizeof(IndexEntry);
+    munmap(indexMap, indexMapSize);
+    indexMap = nullptr;
+
+    if (ftruncate(indexFd, static_cast<off_t>(newSize)) != 0) {
+        newSize = indexMapSize; // Keep the old mapping size so nothing is lost
+    }
+    indexMap = static_cast<char*>(mmap(nullptr, newSize, PROT_READ | PROT_WRITE, MAP_SHARED, indexFd, 0));
+    if (indexMap == MAP_FAILED) {
+        indexMap = nullptr;
+        indexMapSize = 0;
+        std::cerr << "❌ Failed to remap question bank index" << std::endl;
+        return false;
+    }
+    indexMapSize = newSize;
+    return minEntries <= (indexMapSize - sizeof(IndexHeader)) / sizeof(IndexEntry);
+}
+
+void QuestionBank::closeIndex() {
+    if (indexMap) {
+        msync(indexMap, indexMapSize, MS_SYNC);
+        munmap(indexMap, indexMapSize);
+        indexMap = nullptr;
+        indexMapSize = 0;
+    }
+    if (indexFd >= 0) {
+        ::close(indexFd);
+        indexFd = -1;
+    }
+}
+
+bool QuestionBank::addIndexEntry(uint64_t offset, const QuizQuestion& question) {
+    // Caller holds indexMutex exclusively
+    uint64_t count = header()->count;
+    if (!growIndex(count + 1)) {
+        return false;
+    }
+
+    IndexEntry& entry = entries()[count];
+    entry.offset = offset;
+    entry.fingerprint = fingerprint(question.question);
+    entry.keyHash = keyHash(question.category, question.difficulty);
+    entry.createdAt = unixSeconds();
+
+    header()->count = count + 1;
+    header()->logEnd = std::max<uint64_t>(header()->logEnd, log.size());
+    entriesByKey[entry.keyHash].push_back(static_cast<uint32_t>(count));
+    return true;
+}
+
+void QuestionBank::close() {
+    std::unique_lock<std::shared_mutex> lock(indexMutex);
+    log.close();
+    closeIndex();
+    entriesByKey.clear();
+}
+
+bool QuestionBank::append(const QuizQuestion& question) {
+    std::string payload = serialize(question);
+
+    std::unique_lock<std::shared_mutex> lock(indexMutex);
+    if (!indexMap) {
+        return false;
+    }
+
+    // Log first: a crash before the index entry is written is repaired on open()
+    uint64_t offset;
+    if (!log.append(payload, offset)) {
+        return false;
+    }
+    return addIndexEntry(offset, question);
+}
+
+bool QuestionBank::sample(const std::string& category, const std::string& difficulty,
+                          std::mt19937_64& rng, QuizQuestion& question) const {
+    uint64_t offset;
+    {
+        std::shared_lock<std::shared_mutex> lock(indexMutex);
+        auto it = entriesByKey.find(keyHash(category, difficulty));
+        if (!indexMap || it == entriesByKey.end() || it->second.empty()) {
+            return false;
+        }
+
+        std::uniform_int_distribution<size_t> pick(0, it->second.size() - 1);
+        offset = entries()[it->second[pick(rng)]].offset;
+    }
+
+    std::string payload;
+    if (!log.read(offset, payload) || !deserialize(payload, question)) {
+        return false;
+    }
+
+    // Guard against keyHash collisions between (category, difficulty) pairs
+    return question.category == category && question.difficulty == difficulty;
+}
+
+size_t QuestionBank::count(const std::string& category, const std::string& difficulty) const {
+    std::shared_lock<std::shared_mutex> lock(indexMutex);
+    auto it = entriesByKey.find(keyHash(category, difficulty));
+    return it == entriesByKey.end() ? 0 : it->second.size();
+}
+
+void QuestionBank::forEachFingerprint(const std::function<void(uint64_t)>& callback) const {
+    std::shared_lock<std::shared_mutex> lock(indexMutex);
+    if (!indexMap) {
+        return;
+    }
+    for (uint64_t i = 0; i < header()->count; ++i) {
+        callback(entries()[i].fingerprint);
+    }
+}
+
+void QuestionBank::forEachEntry(const std::function<void(uint64_t, uint32_t)>& callback) const {
+    std::shared_lock<std::shared_mutex> lock(indexMutex);
+    if (!indexMap) {
+        return;
+    }
+    for (uint64_t i = 0; i < header()->count; ++i) {
+        callback(entries()[i].offset, entries()[i].keyHash);
+    }
+}
+
+bool QuestionBank::read(uint64_t offset, QuizQuestion& question) const {
+    std::string payload;
+    return log.read(offset, payload) && deserialize(payload, question);
+}
+
+size_t QuestionBank::size() const {
+    std::shared_lock<std::shared_mutex> lock(indexMutex);
+    return indexMap ? static_cast<size_t>(header()->count) : 0;
+}
+
+bool QuestionBank::flush() {
+    std::shared_lock<std::shared_mutex> lock(indexMutex);
+    if (!indexMap) {
+        return false;
+    }
+    // Log before index, so the index never describes records that are not durable
+    bool ok = log.sync();
+    ok &= msync(indexMap, indexMapSize, MS_SYNC) == 0;
+    return ok;
+}
@@ -0,0 +1,215 @@
+#include "record_log.h"
+#include <iostream>
+#include <cstring>
+#include <algorithm>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+namespace {
+
+const char kFileMagic[8] = {'A', 'E', 'O', 'N', 'L', 'O', 'G', '1'};
+const uint32_t kRecordMagic = 0x52454F41; // "AOER"
+const uint32_t kMaxRecordSize = 16 * 1024 * 1024;
+
+struct RecordHeader {
+    uint32_t magic;
+    uint32_t length;
+    uint32_t crc;
+};
+
+bool readFully(int fd, char* buffer, size_t length, uint64_t offset) {
+    while (length > 0) {
+        ssize_t n = pread(fd, buffer, length, static_cast<off_t>(offset));
+        if (n <= 0) {
+            return false;
+        }
+        buffer += n;
+        length -= static_cast<size_t>(n);
+        offset += static_cast<uint64_t>(n);
+    }
+    return true;
+}
+
+bool writeFully(int fd, const char* buffer, size_t length, uint64_t offset) {
+    while (length > 0) {
+        ssize_t n = pwrite(fd, buffer, length, static_cast<off_t>(offset));
+        if (n <= 0) {
+            return false;
+        }
+        buffer += n;
+        length -= static_cast<size_t>(n);
+        offset += static_cast<uint64_t>(n);
+    }
+    return true;
+}
+
+} // namespace
+
+RecordLog::~RecordLog() {
+    close();
+}
+
+uint64_t RecordLog::firstRecordOffset() {
+    return sizeof(kFileMagic);
+}
+
+uint32_t RecordLog::crc32(const char* data, size_t length) {
+    static uint32_t table[256];
+    static std::once_flag tableFlag;
+    std::call_once(tableFlag, []() {
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; ++k) {
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            }
+            table[i] = c;
+        }
+    });
+
+    uint32_t crc = 0xFFFFFFFFu;
+    for (size_t i = 0; i < length; ++i) {
+        crc = table[(crc ^ static_cast<uint8_t>(data[i])) & 0xFF] ^ (crc >> 8);
+    }
+    return crc ^ 0xFFFFFFFFu;
+}
+
+bool RecordLog::open(const std::string& logPath, uint64_t verifyFrom, const RecordCallback& onRecord) {
+    close();
+
+    fd = ::open(logPath.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        std::cerr << "❌ Failed to open record log: " << logPath << std::endl;
+        return false;
+    }
+    path = logPath;
+
+    struct stat st;
+    fstat(fd, &st);
+    uint64_t fileSize = static_cast<uint64_t>(st.st_size);
+
+    if (fileSize < sizeof(kFileMagic)) {
+        // New (or truncated-before-header) file
+        if (ftruncate(fd, 0) != 0 || !writeFully(fd, kFileMagic, sizeof(kFileMagic), 0)) {
+            std::cerr << "❌ Failed to initialize record log: " << logPath << std::endl;
+            close();
+            return false;
+        }
+        endOffset = sizeof(kFileMagic);
+        return true;
+    }
+
+    char magic[sizeof(kFileMagic)];
+    if (!readFully(fd, magic, sizeof(magic), 0) || std::memcmp(magic, kFileMagic, sizeof(magic)) != 0) {
+        std::cerr << "❌ Not a record log: " << logPath << std::endl;
+        close();
+        return false;
+    }
+
+    // Walk the untrusted tail and stop at the first record that does not check out
+    uint64_t offset = std::max<uint64_t>(verifyFrom, sizeof(kFileMagic));
+    if (offset > fileSize) {
+        offset = sizeof(kFileMagic);
+    }
+
+    std::string payload;
+    while (offset + sizeof(RecordHeader) <= fileSize) {
+        RecordHeader header;
+        if (!readFully(fd, reinterpret_cast<char*>(&header), sizeof(header), offset) ||
+            header.magic != kRecordMagic || header.length > kMaxRecordSize ||
+            offset + sizeof(header) + header.length > fileSize) {
+            break;
+        }
+
+        payload.resize(header.length);
+        if (!readFully(fd, &payload[0], header.length, offset + sizeof(header)) ||
+            crc32(payload.data(), payload.size()) != header.crc) {
+            break;
+        }
+
+        if (onRecord) {
+            onRecord(offset, payload);
+        }
+        offset += sizeof(header) + header.length;
+    }
+
+    if (offset < fileSize) {
+        std::cout << "⚠️ Truncating " << (fileSize - offset) << " bytes of torn records from "
+                  << logPath << std::endl;
+        if (ftruncate(fd, static_cast<off_t>(offset)) != 0) {
+            std::cerr << "❌ Failed to truncate record log: " << logPath << std::endl;
+            close();
+            return false;
+        }
+    }
+
+    endOffset = offset;
+    return true;
+}
+
+void RecordLog::close() {
+    if (fd >= 0) {
+        sync();
+        ::close(fd);
+        fd = -1;
+    }
+}
+
+bool RecordLog::append(const std::string& payload, uint64_t& offset) {
+    if (fd < 0 || payload.size() > kMaxRecordSize) {
+        return false;
+    }
+
+    RecordHeader header{kRecordMagic, static_cast<uint32_t>(payload.size()),
+                        crc32(payload.data(), payload.size())};
+
+    std::string buffer;
+    buffer.reserve(sizeof(header) + payload.size());
+    buffer.append(reinterpret_cast<const char*>(&header), sizeof(header));
+    buffer.append(payload);
+
+    std::lock_guard<std::mutex> lock(appendMutex);
+
+    offset = endOffset.load();
+    if (!writeFully(fd, buffer.data(), buffer.size(), offset)) {
+        // Drop whatever part of the record made it to disk
+        if (ftruncate(fd, static_cast<off_t>(offset)) != 0) {
+            std::cerr << "❌ Failed to roll back partial record in " << path << std::endl;
+        }
+        return false;
+    }
+
+    endOffset = offset + buffer.size();
+    dirty = true;
+
+    if (syncOnAppend) {
+        fdatasync(fd);
+        dirty = false;
+    }
+    return true;
+}
+
+bool RecordLog::read(uint64_t offset, std::string& payload) const {
+    if (fd < 0 || offset + sizeof(RecordHeader) > endOffset.load()) {
+        return false;
+    }
+
+    RecordHeader header;
+    if (!readFully(fd, reinterpret_cast<char*>(&header), sizeof(header), offset) ||
+        header.magic != kRecordMagic || header.length > kMaxRecordSize) {
+        return false;
+    }
+
+    payload.resize(header.length);
+    return readFully(fd, &payload[0], header.length, offset + sizeof(header));
+}
+
+bool RecordLog::sync() {
+    if (fd < 0) {
+        return false;
+    }
+    if (dirty.exchange(false)) {
+        return fdatasync(fd) == 0;
+    }
+    return true;
+}
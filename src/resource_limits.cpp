@@ -0,0 +1,201 @@
+#include "resource_limits.h"
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <cmath>
+#include <thread>
+#include <vector>
+#include <sys/stat.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+namespace {
+
+const char* kCgroupRoot = "/sys/fs/cgroup";
+const size_t kDefaultCacheBytes = 32 * 1024 * 1024;
+
+// v1 reports "no limit" as a huge page-rounded number rather than a keyword
+const unsigned long long kUnlimitedMemory = 1ull << 60;
+
+bool readFirstLine(const std::string& path, std::string& line) {
+    std::ifstream file(path);
+    return file && std::getline(file, line);
+}
+
+bool isDirectory(const std::string& path) {
+    struct stat info;
+    return stat(path.c_str(), &info) == 0 && S_ISDIR(info.st_mode);
+}
+
+// The cgroup directories to read limits from, innermost first. Without a
+// cgroup namespace /proc/self/cgroup names a path the container's mount does
+// not have; the mount itself is then our cgroup
+std::vector<std::string> cgroupChain(const std::string& mount, const std::string& path) {
+    std::string dir = mount + path;
+    while (dir.size() > mount.size() && dir.back() == '/') {
+        dir.pop_back();
+    }
+    if (!isDirectory(dir)) {
+        dir = mount;
+    }
+
+    std::vector<std::string> chain{dir};
+    while (dir.size() > mount.size()) {
+        dir = dir.substr(0, dir.rfind('/'));
+        chain.push_back(dir.size() < mount.size() ? mount : dir);
+    }
+    return chain;
+}
+
+// Path of our cgroup in the hierarchy holding `controller` ("" for v2)
+bool ownCgroup(const std::string& controller, std::string& path) {
+    std::ifstream file("/proc/self/cgroup");
+    std::string line;
+    while (std::getline(file, line)) {
+        // hierarchy-id:controller,list:path
+        size_t first = line.find(':');
+        size_t second = line.find(':', first + 1);
+        if (first == std::string::npos || second == std::string::npos) {
+            continue;
+        }
+        std::string controllers = line.substr(first + 1, second - first - 1);
+        std::stringstream list(controllers);
+        std::string name;
+        bool match = controller.empty() && controllers.empty();
+        while (!match && std::getline(list, name, ',')) {
+            match = name == controller;
+        }
+        if (match) {
+            path = line.substr(second + 1);
+            return true;
+        }
+    }
+    return false;
+}
+
+void applyCgroupV2(ResourceLimits& limits, double& quotaCpus, unsigned long long& memory) {
+    std::string path;
+    if (!ownCgroup("", path)) {
+        return;
+    }
+    for (const auto& dir : cgroupChain(kCgroupRoot, path)) {
+        std::string line;
+        // cpu.max: "<quota> <period>" or "max <period>"
+        if (readFirstLine(dir + "/cpu.max", line)) {
+            std::istringstream fields(line);
+            std::string quota;
+            double period = 0;
+            if (fields >> quota >> period && quota != "max" && period > 0) {
+                double cpus = std::stod(quota) / period;
+                if (cpus < quotaCpus) {
+                    quotaCpus = cpus;
+                    limits.cpuSource = "cgroup v2 cpu.max";
+                }
+            }
+        }
+        if (readFirstLine(dir + "/memory.max", line) && line != "max") {
+            unsigned long long bytes = std::stoull(line);
+            if (bytes < memory) {
+                memory = bytes;
+                limits.memorySource = "cgroup v2 memory.max";
+            }
+        }
+    }
+}
+
+void applyCgroupV1(ResourceLimits& limits, double& quotaCpus, unsigned long long& memory) {
+    std::string path;
+    if (ownCgroup("cpu", path)) {
+        std::string mount = std::string(kCgroupRoot) + "/cpu,cpuacct";
+        if (!isDirectory(mount)) {
+            mount = std::string(kCgroupRoot) + "/cpu";
+        }
+        for (const auto& dir : cgroupChain(mount, path)) {
+            std::string quota, period;
+            if (readFirstLine(dir + "/cpu.cfs_quota_us", quota) && readFirstLine(dir + "/cpu.cfs_period_us", period)) {
+                long long quotaUs = std::stoll(quota); // -1: no quota
+                long long periodUs = std::stoll(period);
+                if (quotaUs > 0 && periodUs > 0 && static_cast<double>(quotaUs) / periodUs < quotaCpus) {
+                    quotaCpus = static_cast<double>(quotaUs) / periodUs;
+                    limits.cpuSource = "cgroup v1 CFS quota";
+                }
+            }
+        }
+    }
+    if (ownCgroup("memory", path)) {
+        for (const auto& dir : cgroupChain(std::string(kCgroupRoot) + "/memory", path)) {
+            std::string line;
+            if (readFirstLine(dir + "/memory.limit_in_bytes", line)) {
+                unsigned long long bytes = std::stoull(line);
+                if (bytes < kUnlimitedMemory && bytes < memory) {
+                    memory = bytes;
+                    limits.memorySource = "cgroup v1 memory limit";
+                }
+            }
+        }
+    }
+}
+
+} // namespace
+
+int ResourceLimits::cpuCount() const {
+    // A fractional quota cannot keep another thread busy; round down
+    return std::max(1, static_cast<int>(std::floor(cpus + 1e-6)));
+}
+
+int ResourceLimits::threadsPerContext(int contexts) const {
+    return std::max(1, cpuCount() / std::max(1, contexts));
+}
+
+int ResourceLimits::httpWorkers() const {
+    return std::max(8, cpuCount());
+}
+
+size_t ResourceLimits::generationCacheBytes() const {
+    return memoryBytes == 0 ? kDefaultCacheBytes : std::min(kDefaultCacheBytes, memoryBytes / 50);
+}
+
+const ResourceLimits& ResourceLimits::current() {
+    static const ResourceLimits limits = detect();
+    return limits;
+}
+
+ResourceLimits ResourceLimits::detect() {
+    ResourceLimits limits;
+
+    // CPUs we may be scheduled on: a cpuset or taskset, else the machine
+    double available = std::max(1u, std::thread::hardware_concurrency());
+    limits.cpuSource = "hardware";
+#ifdef __linux__
+    cpu_set_t affinity;
+    if (sched_getaffinity(0, sizeof(affinity), &affinity) == 0 && CPU_COUNT(&affinity) > 0) {
+        available = CPU_COUNT(&affinity);
+        limits.cpuSource = "CPU affinity";
+    }
+#endif
+
+    unsigned long long memory = kUnlimitedMemory;
+    long pages = sysconf(_SC_PHYS_PAGES);
+    long pageSize = sysconf(_SC_PAGESIZE);
+    if (pages > 0 && pageSize > 0) {
+        memory = static_cast<unsigned long long>(pages) * static_cast<unsigned long long>(pageSize);
+        limits.memorySource = "physical memory";
+    }
+
+    // A quota tighter than the CPU count wins. Malformed files are ignored
+    double quotaCpus = available;
+    try {
+        if (isDirectory(kCgroupRoot) && std::ifstream(std::string(kCgroupRoot) + "/cgroup.controllers")) {
+            applyCgroupV2(limits, quotaCpus, memory);
+        } else {
+            applyCgroupV1(limits, quotaCpus, memory);
+        }
+    } catch (const std::exception&) {
+    }
+
+    limits.cpus = quotaCpus;
+    limits.memoryBytes = memory < kUnlimitedMemory ? static_cast<size_t>(memory) : 0;
+    return limits;
+}
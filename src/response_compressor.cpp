@@ -0,0 +1,207 @@
+#include "response_compressor.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <sstream>
+
+#ifdef AEON_ZLIB_SUPPORT
+#include <zlib.h>
+#endif
+
+#ifdef AEON_BROTLI_SUPPORT
+#include <brotli/encode.h>
+#endif
+
+#ifdef AEON_ZSTD_SUPPORT
+#include <zstd.h>
+#endif
+
+const std::string& PrecompressedBody::forEncoding(ContentEncoding encoding) const {
+    switch (encoding) {
+        case ContentEncoding::Gzip:   return gzip.empty() ? identity : gzip;
+        case ContentEncoding::Brotli: return brotli.empty() ? identity : brotli;
+        case ContentEncoding::Zstd:   return zstd.empty() ? identity : zstd;
+        default:                      return identity;
+    }
+}
+
+ResponseCompressor::ResponseCompressor(const CompressionConfig& config) : config(config) {
+    this->config.level = std::max(1, std::min(9, config.level));
+}
+
+const char* ResponseCompressor::encodingName(ContentEncoding encoding) {
+    switch (encoding) {
+        case ContentEncoding::Gzip:   return "gzip";
+        case ContentEncoding::Brotli: return "br";
+        case ContentEncoding::Zstd:   return "zstd";
+        default:                      return "identity";
+    }
+}
+
+std::vector<ContentEncoding> ResponseCompressor::supportedEncodings() {
+    // Ordered by preference when the client weights them equally
+    std::vector<ContentEncoding> encodings;
+#ifdef AEON_ZSTD_SUPPORT
+    encodings.push_back(ContentEncoding::Zstd);
+#endif
+#ifdef AEON_BROTLI_SUPPORT
+    encodings.push_back(ContentEncoding::Brotli);
+#endif
+#ifdef AEON_ZLIB_SUPPORT
+    encodings.push_back(ContentEncoding::Gzip);
+#endif
+    return encodings;
+}
+
+ContentEncoding ResponseCompressor::negotiate(const std::string& acceptEncoding) const {
+    if (!config.enabled || acceptEncoding.empty()) {
+        return ContentEncoding::Identity;
+    }
+
+    // Collect the q-value the client gave each coding (and the "*" wildcard)
+    double wildcardQ = -1.0;
+    std::vector<std::pair<std::string, double>> offered;
+
+    std::stringstream ss(acceptEncoding);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        std::string name = item.substr(0, item.find(';'));
+        name.erase(std::remove_if(name.begin(), name.end(), ::isspace), name.end());
+        std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+
+        double q = 1.0;
+        auto qPos = item.find("q=");
+        if (qPos != std::string::npos) {
+            q = std::atof(item.c_str() + qPos + 2);
+        }
+
+        if (name == "*") {
+            wildcardQ = q;
+        } else if (!name.empty()) {
+            offered.emplace_back(name, q);
+        }
+    }
+
+    ContentEncoding best = ContentEncoding::Identity;
+    double bestQ = 0.0;
+    for (auto encoding : supportedEncodings()) {
+        double q = wildcardQ;
+        for (const auto& entry : offered) {
+            if (entry.first == encodingName(encoding) ||
+                (encoding == ContentEncoding::Gzip && entry.first == "x-gzip")) {
+                q = entry.second;
+            }
+        }
+        if (q > bestQ) {
+            best = encoding;
+            bestQ = q;
+        }
+    }
+
+    return best;
+}
+
+bool ResponseCompressor::compress(const std::string& input, ContentEncoding encoding,
+                                  std::string& output) const {
+    if (!config.enabled || input.size() < config.minSize) {
+        return false;
+    }
+
+    switch (encoding) {
+        case ContentEncoding::Gzip:   return compressGzip(input, output);
+        case ContentEncoding::Brotli: return compressBrotli(input, output);
+        case ContentEncoding::Zstd:   return compressZstd(input, output);
+        default:                      return false;
+    }
+}
+
+PrecompressedBody ResponseCompressor::precompress(const std::string& body) const {
+    PrecompressedBody result;
+    result.identity = body;
+
+    // Static bodies are built once, so always use the strongest settings
+    ResponseCompressor strongest(CompressionConfig{config.enabled, config.minSize, 9});
+    for (auto encoding : supportedEncodings()) {
+        std::string compressed;
+        if (!strongest.compress(body, encoding, compressed)) {
+            continue;
+        }
+        switch (encoding) {
+            case ContentEncoding::Gzip:   result.gzip = std::move(compressed); break;
+            case ContentEncoding::Brotli: result.brotli = std::move(compressed); break;
+            case ContentEncoding::Zstd:   result.zstd = std::move(compressed); break;
+            default: break;
+        }
+    }
+
+    return result;
+}
+
+bool ResponseCompressor::compressGzip([[maybe_unused]] const std::string& input,
+                                      [[maybe_unused]] std::string& output) const {
+#ifdef AEON_ZLIB_SUPPORT
+    z_stream stream{};
+    // 15 window bits + 16 selects the gzip wrapper instead of raw zlib
+    if (deflateInit2(&stream, config.level, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        return false;
+    }
+
+    std::string buffer(deflateBound(&stream, input.size()), '\0');
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(input.data()));
+    stream.avail_in = static_cast<uInt>(input.size());
+    stream.next_out = reinterpret_cast<Bytef*>(&buffer[0]);
+    stream.avail_out = static_cast<uInt>(buffer.size());
+
+    int ret = deflate(&stream, Z_FINISH);
+    buffer.resize(stream.total_out);
+    deflateEnd(&stream);
+
+    if (ret != Z_STREAM_END) {
+        return false;
+    }
+    output = std::move(buffer);
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool ResponseCompressor::compressBrotli([[maybe_unused]] const std::string& input,
+                                        [[maybe_unused]] std::string& output) const {
+#ifdef AEON_BROTLI_SUPPORT
+    // Brotli quality runs 0..11; keep the top end for precompressed bodies
+    int quality = config.level >= 9 ? BROTLI_MAX_QUALITY : config.level;
+    size_t encodedSize = BrotliEncoderMaxCompressedSize(input.size());
+    std::string buffer(encodedSize, '\0');
+
+    if (!BrotliEncoderCompress(quality, BROTLI_DEFAULT_WINDOW, BROTLI_MODE_TEXT,
+                               input.size(), reinterpret_cast<const uint8_t*>(input.data()),
+                               &encodedSize, reinterpret_cast<uint8_t*>(&buffer[0]))) {
+        return false;
+    }
+    buffer.resize(encodedSize);
+    output = std::move(buffer);
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool ResponseCompressor::compressZstd([[maybe_unused]] const std::string& input,
+                                      [[maybe_unused]] std::string& output) const {
+#ifdef AEON_ZSTD_SUPPORT
+    // zstd levels 1..19 are usable on the request path; scale our 1..9 range
+    int level = config.level * 2;
+    std::string buffer(ZSTD_compressBound(input.size()), '\0');
+
+    size_t written = ZSTD_compress(&buffer[0], buffer.size(), input.data(), input.size(), level);
+    if (ZSTD_isError(written)) {
+        return false;
+    }
+    buffer.resize(written);
+    output = std::move(buffer);
+    return true;
+#else
+    return false;
+#endif
+}
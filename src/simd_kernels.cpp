@@ -0,0 +1,90 @@
+#include "simd_kernels.h"
+#include <atomic>
+
+extern const SimdKernels kSimdKernelsGeneric;
+#if defined(__x86_64__) || defined(__i386__)
+extern const SimdKernels kSimdKernelsAvx2;
+extern const SimdKernels kSimdKernelsAvx512;
+#endif
+
+namespace {
+
+#if defined(__x86_64__) || defined(__i386__)
+bool hasAvx2() {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+}
+
+bool hasAvx512() {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw") &&
+           __builtin_cpu_supports("avx512vl") && __builtin_cpu_supports("avx512dq");
+}
+#endif
+
+// Best first
+std::vector<const SimdKernels*> supportedVariants() {
+    std::vector<const SimdKernels*> variants;
+#if defined(__x86_64__) || defined(__i386__)
+    if (hasAvx512()) {
+        variants.push_back(&kSimdKernelsAvx512);
+    }
+    if (hasAvx2()) {
+        variants.push_back(&kSimdKernelsAvx2);
+    }
+#endif
+    variants.push_back(&kSimdKernelsGeneric);
+    return variants;
+}
+
+std::atomic<const SimdKernels*>& selected() {
+    static std::atomic<const SimdKernels*> kernels{supportedVariants().front()};
+    return kernels;
+}
+
+} // namespace
+
+const SimdKernels& simdKernels() {
+    return *selected().load(std::memory_order_relaxed);
+}
+
+bool selectSimdKernels(const std::string& name) {
+    for (const SimdKernels* variant : supportedVariants()) {
+        if (name == variant->name) {
+            selected().store(variant, std::memory_order_relaxed);
+            return true;
+        }
+    }
+    return false;
+}
+
+std::vector<std::string> supportedSimdKernels() {
+    std::vector<std::string> names;
+    for (const SimdKernels* variant : supportedVariants()) {
+        names.push_back(variant->name);
+    }
+    return names;
+}
+
+std::vector<std::string> cpuFeatures() {
+    std::vector<std::string> features;
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_cpu_init();
+    // __builtin_cpu_supports needs a literal, hence no loop over names
+    auto add = [&features](bool supported, const char* name) {
+        if (supported) {
+            features.push_back(name);
+        }
+    };
+    add(__builtin_cpu_supports("sse4.2"), "sse4.2");
+    add(__builtin_cpu_supports("avx"), "avx");
+    add(__builtin_cpu_supports("avx2"), "avx2");
+    add(__builtin_cpu_supports("fma"), "fma");
+    add(__builtin_cpu_supports("avx512f"), "avx512f");
+    add(__builtin_cpu_supports("avx512bw"), "avx512bw");
+    add(__builtin_cpu_supports("avx512vl"), "avx512vl");
+    add(__builtin_cpu_supports("avx512dq"), "avx512dq");
+    add(__builtin_cpu_supports("avx512vnni"), "avx512vnni");
+#endif
+    return features;
+}
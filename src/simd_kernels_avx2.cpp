@@ -0,0 +1,10 @@
+// AVX2 + FMA build of the SIMD kernels (compiled with -mavx2 -mfma)
+#include "simd_kernels_impl.h"
+
+extern const SimdKernels kSimdKernelsAvx2 = {
+    "avx2",
+    argmaxImpl,
+    expWeightsImpl,
+    dotInt8Impl,
+    addSimhashFeatureImpl,
+};
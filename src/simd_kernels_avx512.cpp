@@ -0,0 +1,10 @@
+// AVX-512 build of the SIMD kernels (compiled with -mavx512f -mavx512bw -mavx512vl -mavx512dq)
+#include "simd_kernels_impl.h"
+
+extern const SimdKernels kSimdKernelsAvx512 = {
+    "avx512",
+    argmaxImpl,
+    expWeightsImpl,
+    dotInt8Impl,
+    addSimhashFeatureImpl,
+};
@@ -0,0 +1,10 @@
+// Baseline build of the SIMD kernels: plain x86-64 (SSE2) or the target's default ISA
+#include "simd_kernels_impl.h"
+
+extern const SimdKernels kSimdKernelsGeneric = {
+    "generic",
+    argmaxImpl,
+    expWeightsImpl,
+    dotInt8Impl,
+    addSimhashFeatureImpl,
+};
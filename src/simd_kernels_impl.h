@@ -0,0 +1,123 @@
+// Kernel bodies shared by every simd_kernels_<variant>.cpp. Each includes
+// this file once, compiled with its own -m flags, and exports the result as
+// kSimdKernels<Variant>.
+//
+// Rules that keep the variants interchangeable:
+//  - Everything here has internal linkage and calls no inline or template
+//    library code: such functions are emitted in every variant's object and
+//    the linker keeps one copy, possibly an AVX-512 one called from a
+//    baseline path.
+//  - Float reductions run in kLanes independent lanes combined in a fixed
+//    order, so the vectorizer never needs to reassociate, and the files are
+//    built with -ffp-contract=off; together that makes results identical
+//    across variants.
+#include "simd_kernels.h"
+#include <cstring>
+
+namespace {
+
+const size_t kLanes = 16;
+
+inline float expNonPositive(float x) {
+    // Cephes-style expf for x <= 0: e^x = 2^n * e^r, |r| <= ln2 / 2
+    const float kUnderflow = -87.0f;
+    float clamped = x < kUnderflow ? kUnderflow : x;
+
+    // Round to nearest by the 1.5 * 2^23 trick, exact without fast-math
+    const float kRound = 12582912.0f;
+    float n = (clamped * 1.44269504088896341f + kRound) - kRound;
+    float r = clamped - n * 0.693359375f;
+    r = r - n * -2.12194440e-4f;
+
+    float p = 1.9875691500e-4f;
+    p = p * r + 1.3981999507e-3f;
+    p = p * r + 8.3334519073e-3f;
+    p = p * r + 4.1665795894e-2f;
+    p = p * r + 1.6666665459e-1f;
+    p = p * r + 5.0000001201e-1f;
+    float y = p * r * r + r + 1.0f;
+
+    int32_t bits = (static_cast<int32_t>(n) + 127) << 23;
+    float scale;
+    std::memcpy(&scale, &bits, sizeof(scale));
+    return x < kUnderflow ? 0.0f : y * scale;
+}
+
+int32_t argmaxImpl(const float* values, size_t n) {
+    float laneMax[kLanes];
+    int32_t laneIndex[kLanes];
+    int32_t position[kLanes]; // Index each lane reads next
+    for (size_t lane = 0; lane < kLanes; ++lane) {
+        laneMax[lane] = values[0];
+        laneIndex[lane] = 0;
+        position[lane] = static_cast<int32_t>(lane);
+    }
+
+    size_t i = 0;
+    for (; i + kLanes <= n; i += kLanes) {
+        for (size_t lane = 0; lane < kLanes; ++lane) {
+            float value = values[i + lane];
+            bool greater = value > laneMax[lane];
+            laneMax[lane] = greater ? value : laneMax[lane];
+            laneIndex[lane] = greater ? position[lane] : laneIndex[lane];
+            position[lane] += static_cast<int32_t>(kLanes);
+        }
+    }
+
+    // Each lane holds its first maximum; across lanes prefer the lower index
+    float best = laneMax[0];
+    int32_t bestIndex = laneIndex[0];
+    for (size_t lane = 1; lane < kLanes; ++lane) {
+        if (laneMax[lane] > best || (laneMax[lane] == best && laneIndex[lane] < bestIndex)) {
+            best = laneMax[lane];
+            bestIndex = laneIndex[lane];
+        }
+    }
+    for (; i < n; ++i) {
+        if (values[i] > best) {
+            best = values[i];
+            bestIndex = static_cast<int32_t>(i);
+        }
+    }
+    return bestIndex;
+}
+
+double expWeightsImpl(const float* logits, float* weights, size_t n, float maxLogit, float invTemperature) {
+    float laneSum[kLanes] = {0.0f};
+    size_t i = 0;
+    for (; i + kLanes <= n; i += kLanes) {
+        for (size_t lane = 0; lane < kLanes; ++lane) {
+            float weight = expNonPositive((logits[i + lane] - maxLogit) * invTemperature);
+            weights[i + lane] = weight;
+            laneSum[lane] += weight;
+        }
+    }
+
+    double sum = 0.0;
+    for (size_t lane = 0; lane < kLanes; ++lane) {
+        sum += laneSum[lane];
+    }
+    for (; i < n; ++i) {
+        weights[i] = expNonPositive((logits[i] - maxLogit) * invTemperature);
+        sum += weights[i];
+    }
+    return sum;
+}
+
+int32_t dotInt8Impl(const int8_t* a, const int8_t* b, size_t n) {
+    // Integer sums are exact in any order; |a|, |b| <= 127 keeps int32 safe
+    // below 130k elements
+    int32_t dot = 0;
+    for (size_t i = 0; i < n; ++i) {
+        dot += static_cast<int32_t>(a[i]) * static_cast<int32_t>(b[i]);
+    }
+    return dot;
+}
+
+void addSimhashFeatureImpl(int32_t* weights, uint64_t featureHash) {
+    for (int bit = 0; bit < 64; ++bit) {
+        weights[bit] += static_cast<int32_t>((featureHash >> bit) & 1) * 2 - 1;
+    }
+}
+
+} // namespace
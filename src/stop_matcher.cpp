@@ -0,0 +1,71 @@
+#include "stop_matcher.h"
+#include <algorithm>
+#include <deque>
+
+StopMatcher::StopMatcher(const std::vector<std::string>& stops) {
+    // Trie of the stop sequences
+    for (const auto& stop : stops) {
+        if (stop.empty()) {
+            continue;
+        }
+        State state = 0;
+        for (unsigned char byte : stop) {
+            State next = child(state, byte);
+            if (next == 0) {
+                next = static_cast<State>(nodes.size());
+                auto& edges = nodes[state].next;
+                edges.insert(std::upper_bound(edges.begin(), edges.end(), std::make_pair(byte, State(0))),
+                             {byte, next});
+                nodes.emplace_back();
+            }
+            state = next;
+        }
+        nodes[state].output = std::max(nodes[state].output, stop.size());
+    }
+
+    // Failure links in breadth-first order, so a node's fail target is
+    // complete before the node itself is visited
+    std::deque<State> queue;
+    for (const auto& edge : nodes[0].next) {
+        queue.push_back(edge.second);
+    }
+    while (!queue.empty()) {
+        State state = queue.front();
+        queue.pop_front();
+
+        for (const auto& [byte, next] : nodes[state].next) {
+            State fallback = nodes[state].fail;
+            while (fallback != 0 && child(fallback, byte) == 0) {
+                fallback = nodes[fallback].fail;
+            }
+            nodes[next].fail = child(fallback, byte);
+            nodes[next].output = std::max(nodes[next].output, nodes[nodes[next].fail].output);
+            queue.push_back(next);
+        }
+    }
+}
+
+StopMatcher::State StopMatcher::child(State state, unsigned char byte) const {
+    const auto& edges = nodes[state].next;
+    auto it = std::lower_bound(edges.begin(), edges.end(), std::make_pair(byte, State(0)));
+    return it != edges.end() && it->first == byte ? it->second : 0;
+}
+
+bool StopMatcher::feed(State& state, const char* data, size_t size, Match& match) const {
+    for (size_t i = 0; i < size; ++i) {
+        unsigned char byte = static_cast<unsigned char>(data[i]);
+        State next = child(state, byte);
+        while (next == 0 && state != 0) {
+            state = nodes[state].fail;
+            next = child(state, byte);
+        }
+        state = next;
+
+        if (nodes[state].output > 0) {
+            match.end = i + 1;
+            match.length = nodes[state].output;
+            return true;
+        }
+    }
+    return false;
+}
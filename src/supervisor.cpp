@@ -0,0 +1,131 @@
+#include "supervisor.h"
+#include <iostream>
+#include <algorithm>
+#include <csignal>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+
+namespace {
+
+// Self-pipe: the handler only records the signal, run() does the work
+int signalPipe[2] = {-1, -1};
+volatile sig_atomic_t signalsReceived = 0;
+
+void onSignal(int signal) {
+    // A second signal gives up on whatever shutdown is doing
+    if (signalsReceived++ > 0) {
+        _exit(128 + signal);
+    }
+
+    unsigned char number = static_cast<unsigned char>(signal);
+    if (write(signalPipe[1], &number, 1) < 0) {
+        _exit(128 + signal);
+    }
+}
+
+} // namespace
+
+Supervisor::Supervisor() : epoch(std::chrono::steady_clock::now()) {}
+
+Supervisor::~Supervisor() {
+    for (int* fd : {&signalPipe[0], &signalPipe[1]}) {
+        if (*fd >= 0) {
+            ::close(*fd);
+            *fd = -1;
+        }
+    }
+}
+
+bool Supervisor::handleSignals(std::initializer_list<int> signals) {
+    if (signalPipe[0] < 0 && pipe2(signalPipe, O_CLOEXEC) != 0) {
+        std::cerr << "❌ Failed to create signal pipe" << std::endl;
+        return false;
+    }
+
+    for (int signal : signals) {
+        struct sigaction action = {};
+        action.sa_handler = onSignal;
+        sigemptyset(&action.sa_mask);
+        action.sa_flags = SA_RESTART;
+        if (sigaction(signal, &action, nullptr) != 0) {
+            std::cerr << "❌ Failed to install handler for signal " << signal << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+void Supervisor::every(const std::string& name, std::chrono::seconds period, Job job) {
+    uint64_t ticks = std::max<int64_t>(period.count(), 1);
+    schedule(Timer{name, ticks, currentTick() + ticks, std::move(job)});
+    timerCount++;
+}
+
+uint64_t Supervisor::currentTick() const {
+    return std::chrono::duration_cast<std::chrono::seconds>(std::chrono::steady_clock::now() - epoch).count();
+}
+
+void Supervisor::schedule(Timer timer) {
+    wheel[timer.due % kSlots].push_back(std::move(timer));
+}
+
+void Supervisor::runDue(uint64_t tick) {
+    // Detach the slot first: jobs reschedule into the wheel, possibly this same slot
+    std::vector<Timer> slot;
+    slot.swap(wheel[tick % kSlots]);
+
+    for (auto& timer : slot) {
+        if (timer.due > tick) {
+            schedule(std::move(timer)); // Due on a later lap
+            continue;
+        }
+
+        try {
+            timer.job();
+        } catch (const std::exception& e) {
+            std::cerr << "❌ Supervisor job '" << timer.name << "' failed: " << e.what() << std::endl;
+        }
+
+        // A job that overran its period runs next at the following period, not in a burst
+        timer.due = std::max(timer.due + timer.period, currentTick() + 1);
+        schedule(std::move(timer));
+    }
+}
+
+int Supervisor::msUntilNextSlot(uint64_t now) const {
+    if (timerCount == 0) {
+        return -1;
+    }
+
+    for (uint64_t tick = now + 1; tick <= now + kSlots; ++tick) {
+        if (!wheel[tick % kSlots].empty()) {
+            auto wake = epoch + std::chrono::seconds(tick);
+            auto wait = std::chrono::ceil<std::chrono::milliseconds>(wake - std::chrono::steady_clock::now());
+            return static_cast<int>(std::max<int64_t>(wait.count(), 0));
+        }
+    }
+    return -1; // Unreachable while timers exist: each sits in some slot
+}
+
+int Supervisor::run() {
+    struct pollfd signalFd = {signalPipe[0], POLLIN, 0};
+
+    while (true) {
+        // Catch up on every tick since the last pass; after a stall longer
+        // than a lap, one lap visits every slot and due <= tick catches the rest
+        uint64_t now = currentTick();
+        uint64_t first = std::max(processedTick + 1, now >= kSlots ? now - kSlots + 1 : 1);
+        for (uint64_t tick = first; tick <= now; ++tick) {
+            runDue(tick);
+        }
+        processedTick = std::max(processedTick, now);
+
+        if (poll(&signalFd, 1, msUntilNextSlot(now)) > 0) {
+            unsigned char number = 0;
+            if (read(signalPipe[0], &number, 1) == 1) {
+                return number;
+            }
+        }
+    }
+}
@@ -0,0 +1,377 @@
+#include "template_registry.h"
+#include <jsoncpp/json/json.h>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <filesystem>
+#include <unordered_set>
+#include <algorithm>
+#include <atomic>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/inotify.h>
+
+namespace {
+
+// Wait for a burst of editor writes to settle before reloading
+const int kDebounceMs = 100;
+
+// Template stop sequences are trusted configuration, but still bounded so a
+// typo cannot cut every response short or bloat the matcher
+const size_t kMaxTemplateStops = 8;
+const size_t kMaxTemplateStopLength = 64;
+
+// The response continues the prompt's "Question:", so a second one starts
+// another question; psychology prompts have no answer line either
+const std::vector<std::string> kQuizStops = {"Question:"};
+const std::vector<std::string> kPsychologyStops = {"Question:", "Answer:", "D)"};
+
+bool parseStops(const Json::Value& json, const std::string& owner, std::vector<std::string>& stops,
+                std::string& error) {
+    if (json.isNull()) {
+        return true;
+    }
+    if (!json.isArray() || json.size() > kMaxTemplateStops) {
+        error = owner + ": 'stop' must be an array of at most " + std::to_string(kMaxTemplateStops) + " strings";
+        return false;
+    }
+    for (const auto& stop : json) {
+        if (!stop.isString() || stop.asString().empty() || stop.asString().size() > kMaxTemplateStopLength) {
+            error = owner + ": stop sequences must be strings of 1 to " +
+                    std::to_string(kMaxTemplateStopLength) + " bytes";
+            return false;
+        }
+        stops.push_back(stop.asString());
+    }
+    return true;
+}
+
+std::string quizPrompt(const std::string& subject, const std::string& level) {
+    std::string lead = level.empty()
+        ? (std::string("aeiou").find(subject[0]) != std::string::npos ? "an " : "a ")
+        : (level == "advanced" ? "an advanced " : "a " + level + " ");
+    return "Create " + lead + subject + " question with 3 options. "
+           "Question: [question]? A) [option1] B) [option2] C) [option3] Answer: [A/B/C]\n"
+           "Question:";
+}
+
+std::string psychologyPrompt(const std::string& topic, const std::string& optionA, const std::string& optionC) {
+    return "Create a personality question about " + topic + ". "
+           "Question: [question]? A) [" + optionA + "] B) [neutral] C) [" + optionC + "]\n"
+           "Question:";
+}
+
+} // namespace
+
+const QuizCategoryTemplates* TemplateSet::findCategory(const std::string& name) const {
+    for (const auto& category : categories) {
+        if (category.name == name) {
+            return &category;
+        }
+    }
+    return nullptr;
+}
+
+const std::string* TemplateSet::findQuizPrompt(const std::string& category, const std::string& difficulty) const {
+    const QuizCategoryTemplates* templates = findCategory(category);
+    if (!templates) {
+        return nullptr;
+    }
+    auto it = std::find(difficulties.begin(), difficulties.end(), difficulty);
+    if (it == difficulties.end()) {
+        return nullptr;
+    }
+    return &templates->prompts[it - difficulties.begin()];
+}
+
+const PsychologyTemplate* TemplateSet::findPsychology(const std::string& category) const {
+    for (const auto& entry : psychology) {
+        if (entry.category == category) {
+            return &entry;
+        }
+    }
+    return nullptr;
+}
+
+const std::string* TemplateSet::findPsychologyPrompt(const std::string& category) const {
+    const PsychologyTemplate* entry = findPsychology(category);
+    return entry ? &entry->prompt : nullptr;
+}
+
+std::vector<std::string> TemplateSet::allPrompts() const {
+    std::vector<std::string> prompts;
+    for (const auto& category : categories) {
+        prompts.insert(prompts.end(), category.prompts.begin(), category.prompts.end());
+    }
+    for (const auto& entry : psychology) {
+        prompts.push_back(entry.prompt);
+    }
+    return prompts;
+}
+
+TemplateRegistry::TemplateRegistry() : current(defaults()) {}
+
+TemplateRegistry::~TemplateRegistry() {
+    stopWatching();
+}
+
+std::shared_ptr<TemplateSet> TemplateRegistry::defaults() {
+    // Simplified prompts for small models
+    auto set = std::make_shared<TemplateSet>();
+    set->difficulties = {"Easy", "Medium", "Hard"};
+
+    const std::vector<std::pair<std::string, std::string>> subjects = {
+        {"Science", "science"}, {"Technology", "tech"}, {"Mathematics", "math"}, {"Engineering", "engineering"}};
+    const std::vector<std::vector<std::string>> subcategories = {
+        {"Physics", "Chemistry", "Biology", "Earth Science"},
+        {"Programming", "Computer Science", "AI", "Networking"},
+        {"Algebra", "Geometry", "Calculus", "Statistics"},
+        {"Civil", "Mechanical", "Electrical", "Software"}};
+
+    for (size_t i = 0; i < subjects.size(); ++i) {
+        QuizCategoryTemplates category;
+        category.name = subjects[i].first;
+        category.subcategories = subcategories[i];
+        category.prompts = {quizPrompt(subjects[i].second, "basic"),
+                            quizPrompt(subjects[i].second, ""),
+                            quizPrompt(subjects[i].second, "advanced")};
+        category.stop = kQuizStops;
+        set->categories.push_back(std::move(category));
+    }
+
+    set->psychology = {
+        {"E/I_Social", psychologyPrompt("social preferences", "extroverted", "introverted"), kPsychologyStops},
+        {"E/I_Energy", psychologyPrompt("energy and social recharging", "extroverted", "introverted"), kPsychologyStops},
+        {"S/N_Information", psychologyPrompt("information processing", "sensing", "intuition"), kPsychologyStops},
+        {"S/N_Future", psychologyPrompt("future planning", "sensing", "intuition"), kPsychologyStops},
+        {"T/F_Decisions", psychologyPrompt("decision making", "thinking", "feeling"), kPsychologyStops},
+        {"T/F_Conflict", psychologyPrompt("handling conflict", "thinking", "feeling"), kPsychologyStops},
+        {"J/P_Structure", psychologyPrompt("structure and organization", "judging", "perceiving"), kPsychologyStops},
+        {"J/P_Deadlines", psychologyPrompt("deadlines and time management", "judging", "perceiving"), kPsychologyStops}};
+
+    return set;
+}
+
+bool TemplateRegistry::parse(const std::string& json, TemplateSet& set, std::string& error) {
+    Json::Value root;
+    Json::CharReaderBuilder builder;
+    std::istringstream stream(json);
+    if (!Json::parseFromStream(builder, stream, &root, &error)) {
+        return false;
+    }
+
+    const Json::Value& difficulties = root["difficulties"];
+    if (!difficulties.isArray() || difficulties.empty()) {
+        error = "'difficulties' must be a non-empty array";
+        return false;
+    }
+    for (const auto& difficulty : difficulties) {
+        if (!difficulty.isString() || difficulty.asString().empty()) {
+            error = "difficulty names must be non-empty strings";
+            return false;
+        }
+        if (std::find(set.difficulties.begin(), set.difficulties.end(), difficulty.asString()) != set.difficulties.end()) {
+            error = "duplicate difficulty '" + difficulty.asString() + "'";
+            return false;
+        }
+        set.difficulties.push_back(difficulty.asString());
+    }
+
+    const Json::Value& quiz = root["quiz"];
+    if (!quiz.isArray() || quiz.empty()) {
+        error = "'quiz' must be a non-empty array";
+        return false;
+    }
+    for (const auto& entry : quiz) {
+        QuizCategoryTemplates category;
+        category.name = entry.get("category", "").asString();
+        if (category.name.empty() || set.findCategory(category.name)) {
+            error = "quiz categories need a unique non-empty 'category'";
+            return false;
+        }
+
+        for (const auto& sub : entry["subcategories"]) {
+            category.subcategories.push_back(sub.asString());
+        }
+
+        // Every category must cover every difficulty, so any advertised
+        // combination has a prompt
+        const Json::Value& prompts = entry["prompts"];
+        for (const auto& difficulty : set.difficulties) {
+            if (!prompts.isObject() || !prompts[difficulty].isString() || prompts[difficulty].asString().empty()) {
+                error = "category '" + category.name + "' has no prompt for '" + difficulty + "'";
+                return false;
+            }
+            category.prompts.push_back(prompts[difficulty].asString());
+        }
+        if (!parseStops(entry["stop"], "category '" + category.name + "'", category.stop, error)) {
+            return false;
+        }
+        set.categories.push_back(std::move(category));
+    }
+
+    for (const auto& entry : root["psychology"]) {
+        PsychologyTemplate psychology{entry.get("category", "").asString(), entry.get("prompt", "").asString(), {}};
+        // The trait is read from the first three characters ("E/I")
+        if (psychology.category.size() < 3 || psychology.prompt.empty() ||
+            set.findPsychologyPrompt(psychology.category)) {
+            error = "psychology entries need a unique 'category' like \"E/I_Social\" and a 'prompt'";
+            return false;
+        }
+        if (!parseStops(entry["stop"], "psychology '" + psychology.category + "'", psychology.stop, error)) {
+            return false;
+        }
+        set.psychology.push_back(std::move(psychology));
+    }
+    if (set.psychology.empty()) {
+        error = "'psychology' must be a non-empty array";
+        return false;
+    }
+
+    return true;
+}
+
+std::shared_ptr<const TemplateSet> TemplateRegistry::snapshot() const {
+    return std::atomic_load(&current);
+}
+
+void TemplateRegistry::setReloadCallback(ReloadCallback callback) {
+    std::lock_guard<std::mutex> lock(reloadMutex);
+    onReload = std::move(callback);
+}
+
+void TemplateRegistry::install(std::shared_ptr<TemplateSet> set) {
+    // Caller holds reloadMutex
+    set->version = nextVersion++;
+    std::shared_ptr<const TemplateSet> previous = std::atomic_load(&current);
+    std::shared_ptr<const TemplateSet> fresh = std::move(set);
+    std::atomic_store(&current, fresh);
+
+    if (onReload) {
+        onReload(*previous, *fresh);
+    }
+}
+
+bool TemplateRegistry::load(const std::string& templatePath, bool watch) {
+    stopWatching();
+    path = templatePath;
+
+    bool loaded = true;
+    if (std::filesystem::exists(path)) {
+        loaded = reload();
+    } else {
+        std::cout << "📝 No template file at " << path << ", using built-in prompt templates" << std::endl;
+    }
+
+    if (watch) {
+        startWatching();
+    }
+    return loaded;
+}
+
+bool TemplateRegistry::reload() {
+    std::lock_guard<std::mutex> lock(reloadMutex);
+
+    std::ifstream file(path);
+    if (!file) {
+        std::cerr << "⚠️ Cannot read template file " << path << ", keeping current templates" << std::endl;
+        return false;
+    }
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+
+    auto set = std::make_shared<TemplateSet>();
+    std::string error;
+    if (!parse(buffer.str(), *set, error)) {
+        std::cerr << "❌ Invalid template file " << path << ": " << error << " (keeping current templates)" << std::endl;
+        return false;
+    }
+
+    size_t categories = set->categories.size();
+    size_t psychology = set->psychology.size();
+    install(std::move(set));
+
+    std::cout << "📝 Loaded prompt templates from " << path << ": " << categories
+              << " quiz categories, " << psychology << " psychology prompts" << std::endl;
+    return true;
+}
+
+bool TemplateRegistry::startWatching() {
+    std::string directory = std::filesystem::path(path).parent_path().string();
+    if (directory.empty()) {
+        directory = ".";
+    }
+
+    inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotifyFd < 0 ||
+        inotify_add_watch(inotifyFd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE) < 0 ||
+        pipe2(stopPipe, O_CLOEXEC) != 0) {
+        std::cerr << "⚠️ Cannot watch " << directory << " for template changes; reload disabled" << std::endl;
+        stopWatching();
+        return false;
+    }
+
+    watchThread = std::thread(&TemplateRegistry::watchLoop, this);
+    return true;
+}
+
+void TemplateRegistry::watchLoop() {
+    const std::string fileName = std::filesystem::path(path).filename().string();
+    alignas(struct inotify_event) char buffer[4096];
+
+    // Returns true if any queued event names the template file
+    auto drainEvents = [&]() {
+        bool relevant = false;
+        ssize_t length;
+        while ((length = read(inotifyFd, buffer, sizeof(buffer))) > 0) {
+            for (char* ptr = buffer; ptr < buffer + length;) {
+                auto* event = reinterpret_cast<struct inotify_event*>(ptr);
+                if (event->len > 0 && fileName == event->name) {
+                    relevant = true;
+                }
+                ptr += sizeof(struct inotify_event) + event->len;
+            }
+        }
+        return relevant;
+    };
+
+    struct pollfd fds[2] = {{inotifyFd, POLLIN, 0}, {stopPipe[0], POLLIN, 0}};
+    while (true) {
+        if (poll(fds, 2, -1) < 0) {
+            continue; // EINTR
+        }
+        if (fds[1].revents) {
+            return;
+        }
+        if (!drainEvents()) {
+            continue;
+        }
+
+        // Coalesce the remaining events of this save before reading the file
+        while (poll(fds, 2, kDebounceMs) > 0) {
+            if (fds[1].revents) {
+                return;
+            }
+            drainEvents();
+        }
+        reload();
+    }
+}
+
+void TemplateRegistry::stopWatching() {
+    if (watchThread.joinable()) {
+        char stop = 1;
+        if (write(stopPipe[1], &stop, 1) < 0) {
+            std::cerr << "⚠️ Failed to signal template watcher" << std::endl;
+        }
+        watchThread.join();
+    }
+
+    for (int* fd : {&inotifyFd, &stopPipe[0], &stopPipe[1]}) {
+        if (*fd >= 0) {
+            ::close(*fd);
+            *fd = -1;
+        }
+    }
+}
@@ -0,0 +1,77 @@
+#include "token_sampler.h"
+#include "simd_kernels.h"
+#include <algorithm>
+#include <vector>
+#include <cmath>
+
+int32_t sampleToken(const float* logits, int n_vocab, const GenerationParams& params, std::mt19937_64& rng) {
+    const SimdKernels& kernels = simdKernels();
+    int32_t best = kernels.argmax(logits, n_vocab);
+
+    // Greedy sampling
+    if (params.temperature <= 0 || params.topK == 1) {
+        return best;
+    }
+
+    const float max_l = logits[best];
+    const bool filtered = (params.topK > 0 && params.topK < n_vocab) || params.topP < 1.0f;
+
+    if (!filtered) {
+        thread_local std::vector<float> weights;
+        weights.resize(n_vocab);
+
+        double sum = kernels.expWeights(logits, weights.data(), n_vocab, max_l, 1.0f / params.temperature);
+
+        double target = std::uniform_real_distribution<double>(0.0, sum)(rng);
+        for (int id = 0; id < n_vocab; ++id) {
+            target -= weights[id];
+            if (target <= 0.0) {
+                return id;
+            }
+        }
+        return best;
+    }
+
+    thread_local std::vector<int32_t> ids;
+    ids.resize(n_vocab);
+    for (int id = 0; id < n_vocab; ++id) {
+        ids[id] = id;
+    }
+
+    auto byLogit = [logits](int32_t a, int32_t b) {
+        return logits[a] > logits[b] || (logits[a] == logits[b] && a < b);
+    };
+
+    // Keep the top_k candidates (partial sort is O(n log k)), or sort all when only top_p applies
+    size_t keep = (params.topK > 0 && params.topK < n_vocab) ? params.topK : n_vocab;
+    std::partial_sort(ids.begin(), ids.begin() + keep, ids.end(), byLogit);
+    ids.resize(keep);
+
+    thread_local std::vector<double> weights;
+    weights.resize(keep);
+    double sum = 0.0;
+    for (size_t i = 0; i < keep; ++i) {
+        weights[i] = exp((logits[ids[i]] - max_l) / params.temperature);
+        sum += weights[i];
+    }
+
+    // Nucleus: shortest prefix (candidates are sorted) reaching top_p of the mass
+    if (params.topP < 1.0f) {
+        double mass = 0.0;
+        size_t cut = 0;
+        while (cut < keep && mass < params.topP * sum) {
+            mass += weights[cut++];
+        }
+        keep = std::max<size_t>(cut, 1);
+        sum = mass > 0.0 ? mass : weights[0];
+    }
+
+    double target = std::uniform_real_distribution<double>(0.0, sum)(rng);
+    for (size_t i = 0; i < keep; ++i) {
+        target -= weights[i];
+        if (target <= 0.0) {
+            return ids[i];
+        }
+    }
+    return ids[0];
+}